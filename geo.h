@@ -11,8 +11,198 @@ bool calcRhumblineDistAndBrg (bool useWgs84, Pos *origin, Pos *dest, double *ran
 bool calcGreatCircleDistAndBrg (bool useWgs84, Pos *origin, Pos *dest, double *range, double *bearing, double *endBearing);
 bool calcGreatCirclePos (bool useWgs84, Pos *origin, double range, double bearing, Pos *dest, double *endBearing);
 
-inline double valToRad (double val) { return val * RAD_IN_DEG; }
-inline double valToDeg (double val) { return val / RAD_IN_DEG; }
+bool calcRhumblinePosBatch (bool useWgs84, Pos *origin, const double *ranges, const double *bearings, size_t count, PosBatch *dest);
+bool calcGreatCirclePosBatch (bool useWgs84, Pos *origin, const double *ranges, const double *bearings, size_t count, PosBatch *dest, double *endBearings);
+
+// Short range inverse problem in the local tangent plane of the anchor (own ship); angles are in radians, ranges and
+// errors in miles. Ellipsoid may be null for WGS84. The error bound (range and cross track together) is range^3 /
+// (8 R^2 cos^2 lat), about 0.14 m at 12 nm and 60 degrees of latitude; points exceeding maxError are solved by the
+// exact inverse problem and give the zero bound
+bool initLocalFrame (const Ellipsoid *ellipsoid, const Pos *anchor, double maxError, LocalFrame *frame);
+bool calcLocalDistAndBrg (const LocalFrame *frame, const Pos *dest, double *range, double *bearing, double *errorBound);
+bool calcLocalDistAndBrgBatch (const LocalFrame *frame, const double *lat, const double *lon, size_t count, double *ranges, double *bearings,
+                               size_t *exactCount);
+
+// Warm started inverse problem for the streams of queries on the same pair of vessels: every query starts the INVER1
+// iteration from the solution of the last one. One solver per pair; ellipsoid may be null for WGS84. The iteration
+// cap (solver->maxIterations) and the path reporting are the same as for the context API
+void initGcSolver (const Ellipsoid *ellipsoid, GcSolver *solver);
+bool solveGcInverse (GcSolver *solver, const Pos *origin, const Pos *dest, double *range, double *bearing, double *endBearing);
+
+// Incremental range/bearing (miles, radians) from the own ship to all the targets on every tick. Target i keeps slot i
+// between the calls; the first order displacements of both ships are combined with the last exact solution in the
+// plane, the target is solved exactly again once the drift keeping the error within maxError (miles) is exceeded,
+// which takes 1-3% of the targets at 20-30 knots and a second tick. Ellipsoid may be null
+bool initTargetUpdater (const Ellipsoid *ellipsoid, double maxError, TargetGeodesic *targets, size_t capacity, TargetUpdater *updater);
+bool updateTargets (TargetUpdater *updater, const Pos *ownShip, const double *lat, const double *lon, size_t count, double *ranges, double *bearings);
+
+// Batch kernels templated over the arithmetic type (float, double and long double are instantiated); origin and
+// results are in radians, ranges are in miles. Ellipsoid may be null for WGS84. Float results are display grade:
+// against the double kernels for the same input values the error is within 1.5 m up to 500 nm and 6 m up to 3000 nm
+// (rhumb lines ending within 2 degrees of the pole excepted); mostly the float spacing of the angles
+template <typename Real> bool calcRhumblinePosT (const Ellipsoid *ellipsoid, const Pos *origin, const Real *ranges, const Real *bearings, size_t count, Real *lat, Real *lon);
+template <typename Real> bool calcGreatCirclePosT (const Ellipsoid *ellipsoid, const Pos *origin, const Real *ranges, const Real *bearings, size_t count, Real *lat, Real *lon);
+
+// Inverse problems from one origin to every point over the same types; invalid points and the poles give zeros. Float
+// range and bearing (as the offset at the end point) are within the same bounds
+template <typename Real> bool calcRhumblineDistAndBrgT (const Ellipsoid *ellipsoid, const Pos *origin, const Real *lat, const Real *lon, size_t count, Real *ranges, Real *bearings);
+template <typename Real> bool calcGreatCircleDistAndBrgT (const Ellipsoid *ellipsoid, const Pos *origin, const Real *lat, const Real *lon, size_t count, Real *ranges, Real *bearings);
+
+// Ellipsoidal Mercator relative to the chart origin (radians), easting/northing are miles of the equator scaled by k0;
+// float error within 500 nm of the origin is below 1 m both ways
+template <typename Real> bool projectMercatorT (const Ellipsoid *ellipsoid, const Pos *origin, double k0, const Real *lat, const Real *lon, size_t count,
+                                                Real *easting, Real *northing);
+template <typename Real> bool unprojectMercatorT (const Ellipsoid *ellipsoid, const Pos *origin, double k0, const Real *easting, const Real *northing, size_t count,
+                                                  Real *lat, Real *lon);
+
+// Same projection (double only) by branch free minimax polynomial kernels in AVX2/SSE2 lanes for chart rendering;
+// against the exact kernels northing is within 6e-10 nm times k0 up to 89 degrees of latitude (easting is the same)
+// and latitude back is within 2e-12 rad. Per point on a 2 GHz core: 12 cycles (165 Mpts/s) forward and 16 cycles
+// (125 Mpts/s) inverse with the AVX2 lanes, which need /arch:AVX2 (the optimized AVX2 build task); 39 and 59 cycles
+// (50 and 34 Mpts/s) with the SSE2 lanes of an /O2 x64 build
+bool projectMercatorFast (const Ellipsoid *ellipsoid, const Pos *origin, double k0, const double *lat, const double *lon, size_t count,
+                          double *easting, double *northing);
+bool unprojectMercatorFast (const Ellipsoid *ellipsoid, const Pos *origin, double k0, const double *easting, const double *northing, size_t count,
+                            double *lat, double *lon);
+
+// Transverse Mercator by the Kruger series to the 6th order of the third flattening, batch kernels in AVX2/SSE2 lanes;
+// x/y are meters east of the central meridian and north of the equator, within 1 mm of the exact mapping up to 3000 km
+// from the central meridian (|lon - centralMeridian| < 90 degrees is accepted). Invalid points give zeros
+bool projectTransverseMercator (const Ellipsoid *ellipsoid, double centralMeridian, double k0, const double *lat, const double *lon, size_t count,
+                                double *x, double *y);
+bool unprojectTransverseMercator (const Ellipsoid *ellipsoid, double centralMeridian, double k0, const double *x, const double *y, size_t count,
+                                  double *lat, double *lon);
+
+// UTM zone (1..60, Norway and Svalbard exceptions), negative in the southern hemisphere; zero out of 80S..84N
+int findUtmZone (double lat, double lon);
+
+// UTM in meters; zone 0 finds the zone of every point (returned in zones if given), otherwise the whole batch is
+// projected in the given zone (negative for the southern hemisphere). Batches may mix the zones
+bool projectUtm (const Ellipsoid *ellipsoid, const double *lat, const double *lon, size_t count, int zone, int *zones, double *easting, double *northing);
+bool unprojectUtm (const Ellipsoid *ellipsoid, const int *zones, const double *easting, const double *northing, size_t count, double *lat, double *lon);
+
+// Latitudes at the Mercator northing offsets from begLat (batch of calcLatEquationRoot), radians
+bool calcLatEquationRootBatch (double eccentricity, double begLat, const double *dNorthings, size_t count, double scaledEquRadius, double *lats);
+
+// Arc builders (port of gkdBuildGeoArc); angles are in radians, positive angle is clockwise
+struct Arc {
+    Pos begin, center;
+    double angle;
+};
+
+size_t calcArcPointCount (double angle, double angleStep, bool includeEndPoint);
+bool buildGeoArcs (bool useWgs84, Method method, Arc *arcs, size_t arcCount, double angleStep, bool includeEndPoint, PosBatch *output, size_t *firstPoints);
+bool buildRangeRings (bool useWgs84, Pos *centers, size_t centerCount, double range, double angleStep, PosBatch *output);
+
+// Route corridor (XTE buffer); portXte and stbdXte hold pointCount - 1 per-leg limits in miles
+bool calcRouteCorridorSize (bool useWgs84, Method method, Pos *route, size_t pointCount, const double *portXte, const double *stbdXte,
+                            double stepDistance, double angleStep, size_t *contourCount, size_t *vertexCount);
+bool buildRouteCorridor (bool useWgs84, Method method, Pos *route, size_t pointCount, const double *portXte, const double *stbdXte,
+                         double stepDistance, double angleStep, RegionBuffer *corridor);
+
+// Datum shifts (replacement of gkdCalcDatumShifts); latitudes and longitudes are in radians, heights in meters
+const DatumShift *findDatum (int datumId);
+bool calcDatumShifts (const DatumShift *datum, DatumShiftMethod method, bool toWgs84, const double *lat, const double *lon, const double *height,
+                      size_t count, double *deltaLat, double *deltaLon, double *deltaHeight);
+bool convertDatum (const DatumShift *datum, DatumShiftMethod method, bool toWgs84, PosBatch *points, double *height);
+
+// Geodetic <-> ECEF conversions and seven-parameter Helmert transforms; ellipsoid may be null for WGS84. Points
+// within the evolute around the center (about 43 km on WGS84) have no closed form geodetic position and give zeros
+bool geodeticToEcef (const Ellipsoid *ellipsoid, const double *lat, const double *lon, const double *height, size_t count, double *x, double *y, double *z);
+bool ecefToGeodetic (const Ellipsoid *ellipsoid, const double *x, const double *y, const double *z, size_t count, double *lat, double *lon, double *height);
+bool transformHelmert (const HelmertParams *params, size_t count, double *x, double *y, double *z);
+bool convertHelmert (const Ellipsoid *source, const Ellipsoid *target, const HelmertParams *params, PosBatch *points, double *height);
+
+// Allocation and locale free formatting/parsing of latitudes and longitudes (radians) in caller buffers
+bool compileGeoFormat (const char *format, bool latitude, GeoFormat *compiled);
+size_t formatGeoValue (const GeoFormat *format, double value, char *buffer, size_t size);
+bool formatGeoValues (const GeoFormat *format, const double *values, size_t count, char *buffer, size_t stride);
+bool parseGeoValue (const char *text, size_t length, bool latitude, double *value);
+bool parseGeoValues (const char *buffer, size_t stride, size_t count, bool latitude, double *values);
+
+// Parsing of the text written with the compiled format; other texts are parsed by parseGeoValue
+bool parseFormattedGeoValue (const GeoFormat *format, const char *text, size_t length, double *value);
+bool parseFormattedGeoValues (const GeoFormat *format, const char *buffer, size_t stride, size_t count, double *values);
+
+// NMEA 0183 position ingest (GGA/RMC/GLL); fixes are appended to the batch, times (optional) are UTC seconds of day
+void initNmeaParser (NmeaParser *parser);
+size_t parseNmea (NmeaParser *parser, const char *data, size_t size, PosBatch *positions, double *times);
+
+// AIS position reports (message types 1, 2, 3 and 18); SOG is in knots, COG in radians
+size_t decodeAis (NmeaParser *parser, const char *data, size_t size, AisReports *reports);
+
+// Memory mapped files; size is zero to map the existing file as is or the size of the file to be created
+bool mapFile (const char *path, bool writable, size_t size, MappedFile *file);
+void unmapFile (MappedFile *file);
+
+// Grid based datum shifts (NTv2 style); shifts are applied to the latitude/longitude in radians
+bool writeGridShift (const char *path, double south, double west, double latStep, double lonStep, size_t rows, size_t cols,
+                     const float *latShifts, const float *lonShifts, size_t tileSize);
+bool openGridShift (const char *path, GridShift *grid);
+void closeGridShift (GridShift *grid);
+bool calcGridShifts (const GridShift *grid, const double *lat, const double *lon, size_t count, double *deltaLat, double *deltaLon);
+bool convertGridShift (const GridShift *grid, bool forward, PosBatch *points);
+
+// Columnar track files; positions are in radians, times are in seconds and must not decrease
+bool writeTrackFile (const char *path, const double *lat, const double *lon, const double *time, size_t count, size_t blockSize);
+bool openTrackFile (const char *path, TrackFile *track);
+void closeTrackFile (TrackFile *track);
+size_t findTrackBlocks (const TrackFile *track, double south, double north, double west, double east, double beginTime, double endTime,
+                        size_t *blocks, size_t maxBlocks);
+
+// Binary region lists with the spatial index (replacement of gkSaveRegionList/gkLoadRegionList); positions are in
+// radians, contour edges are treated as straight lines in latitude/longitude
+bool writeRegionList (const char *path, const RegionBuffer *regions, size_t regionCount);
+bool openRegionList (const char *path, RegionList *list);
+void closeRegionList (RegionList *list);
+size_t findRegions (const RegionList *list, double south, double north, double west, double east, size_t *regions, size_t maxRegions);
+bool isPointInRegion (const RegionList *list, size_t region, const Pos *point);
+
+// Performance counters of the kernels, kept per thread if the library is built with _USE_GEO_STATS_ and compiled
+// out entirely otherwise (getGeoStats returns false then). The snapshot sums all the threads since the last reset;
+// formatGeoStats writes the text table or the Prometheus text exposition, returns the length or zero if short
+bool getGeoStats (GeoStats *stats);
+void resetGeoStats ();
+size_t formatGeoStats (const GeoStats *stats, bool prometheus, char *buffer, size_t size);
+
+// Range (miles) and bearing (radians) of the repeated legs from the LRU cache in front of calcGreatCircleDistAndBrg
+// and calcRhumblineDistAndBrg. Keys are the endpoints rounded to the quantum (1e-7 rad is 0.64 m), the method and the
+// ellipsoid, so the results are these of the rounded points. Capacity is split into the shards locked separately,
+// the legs are solved out of the locks and failures are not cached. Hit rate is hits / (hits + misses)
+bool openLegCache (size_t capacity, double quantum, LegCache *cache);
+void closeLegCache (LegCache *cache);
+bool calcLegCached (LegCache *cache, Method method, bool useWgs84, const Pos *origin, const Pos *dest, double *range, double *bearing);
+bool getLegCacheStats (LegCache *cache, LegCacheStats *stats);
+
+// Binary capture of the legacy calls (inputs and results) for the offline replay. Every thread writes its records
+// into its own lock free ring of ringSize records (records are dropped when it is full, the caller never waits), a
+// background thread flushes the rings to the file. stopGeoCapture flushes the rest and returns the counts
+bool startGeoCapture (const char *path, size_t ringSize);
+bool stopGeoCapture (size_t *written, size_t *dropped);
+
+// Captured calls are replayed by the kernels linked, so the capture of the production traffic mix benchmarks any
+// version of them; throughput and differences by the call are returned
+bool openCaptureFile (const char *path, CaptureFile *capture);
+void closeCaptureFile (CaptureFile *capture);
+bool replayCapture (const CaptureFile *capture, ReplayStats *stats);
+
+// Reentrant API; settings come from the caller's context, failures are returned and stored in context->lastError.
+// Nonzero context->maxIterations bounds the great circle inverse latency: past the cap (and for the nearly antipodal
+// points) the start azimuth is found by the bisection (48 steps), context->lastGcPath tells the path taken. Corridors
+// are WGS84 only, other context ellipsoids give GEO_INVALID_ARGUMENT
+void initGeoContext (GeoContext *context);
+GeoStatus calcRhumblinePosEx (GeoContext *context, const Pos *origin, double range, double bearing, Pos *dest);
+GeoStatus calcRhumblineDistAndBrgEx (GeoContext *context, const Pos *origin, const Pos *dest, double *range, double *bearing);
+GeoStatus calcRhumblineDistAndBrg2Ex (GeoContext *context, const Pos *origin, const Pos *dest, double *range, double *bearing);
+GeoStatus calcGreatCirclePosEx (GeoContext *context, const Pos *origin, double range, double bearing, Pos *dest, double *endBearing);
+GeoStatus calcGreatCircleDistAndBrgEx (GeoContext *context, const Pos *origin, const Pos *dest, double *range, double *bearing, double *endBearing);
+GeoStatus calcRouteCorridorSizeEx (GeoContext *context, Method method, const Pos *route, size_t pointCount, const double *portXte, const double *stbdXte,
+                                   double angleStep, size_t *contourCount, size_t *vertexCount);
+GeoStatus buildRouteCorridorEx (GeoContext *context, Method method, const Pos *route, size_t pointCount, const double *portXte, const double *stbdXte,
+                                double angleStep, RegionBuffer *corridor);
+
+constexpr double valToRad (double val) { return val * RAD_IN_DEG; }
+constexpr double valToDeg (double val) { return val / RAD_IN_DEG; }
 inline void degToRad (double *val) { *val *= RAD_IN_DEG; }
 inline void radToDeg (double *val) { *val /= RAD_IN_DEG; }
 
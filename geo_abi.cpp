@@ -0,0 +1,125 @@
+#define _INTERNAL_
+
+#include "geo.h"
+#include "geoabi.h"
+
+#ifdef __cplusplus
+namespace geo {
+#endif
+
+// Column of the caller buffer; zero stride repeats the same value for every point
+struct AbiColumn {
+    char *data;
+    ptrdiff_t stride;
+
+    AbiColumn (const double *column, ptrdiff_t columnStride) : data ((char *) column), stride (columnStride) {}
+
+    double& operator [] (size_t i) const {
+        return *(double *) (data + (ptrdiff_t) i * stride);
+    }
+};
+
+// Legacy calls normalize their arguments in place, so the points are copied and the caller buffers are only read
+template <typename Call> static size_t runDirectBatch (size_t count, AbiColumn originLat, AbiColumn originLon, AbiColumn range, AbiColumn bearing,
+                                                       AbiColumn destLat, AbiColumn destLon, Call call) {
+    if (!originLat.data || !originLon.data || !range.data || !bearing.data || !destLat.data || !destLon.data) return 0;
+
+    size_t solved = 0;
+
+    for (size_t i = 0; i < count; ++ i) {
+        Pos origin { originLat [i], originLon [i] }, dest { 0.0, 0.0 };
+
+        if (call (& origin, range [i], bearing [i], & dest, i))
+            ++ solved;
+        else
+            dest.lat = dest.lon = 0.0;
+
+        destLat [i] = dest.lat;
+        destLon [i] = dest.lon;
+    }
+
+    return solved;
+}
+
+template <typename Call> static size_t runInverseBatch (size_t count, AbiColumn originLat, AbiColumn originLon, AbiColumn destLat, AbiColumn destLon,
+                                                        AbiColumn range, AbiColumn bearing, Call call) {
+    if (!originLat.data || !originLon.data || !destLat.data || !destLon.data || !range.data || !bearing.data) return 0;
+
+    size_t solved = 0;
+
+    for (size_t i = 0; i < count; ++ i) {
+        Pos origin { originLat [i], originLon [i] }, dest { destLat [i], destLon [i] };
+        double rng = 0.0, brg = 0.0;
+
+        if (call (& origin, & dest, & rng, & brg, i)) ++ solved;
+
+        range [i] = rng;
+        bearing [i] = brg;
+    }
+
+    return solved;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+using geo::AbiColumn;
+
+int geo_abi_version (void) {
+    return GEO_ABI_VERSION;
+}
+
+size_t geo_rl_pos_v1 (int useWgs84, size_t count, const double *originLat, ptrdiff_t originLatStride, const double *originLon, ptrdiff_t originLonStride,
+                      const double *range, ptrdiff_t rangeStride, const double *bearing, ptrdiff_t bearingStride, double *destLat, ptrdiff_t destLatStride,
+                      double *destLon, ptrdiff_t destLonStride) {
+    return geo::runDirectBatch (count, AbiColumn (originLat, originLatStride), AbiColumn (originLon, originLonStride), AbiColumn (range, rangeStride),
+                                AbiColumn (bearing, bearingStride), AbiColumn (destLat, destLatStride), AbiColumn (destLon, destLonStride),
+                                [useWgs84] (geo::Pos *origin, double rng, double brg, geo::Pos *dest, size_t) {
+                                    return geo::calcRhumblinePos (useWgs84 != 0, origin, rng, brg, dest);
+                                });
+}
+
+size_t geo_rl_dist_brg_v1 (int useWgs84, size_t count, const double *originLat, ptrdiff_t originLatStride, const double *originLon,
+                           ptrdiff_t originLonStride, const double *destLat, ptrdiff_t destLatStride, const double *destLon, ptrdiff_t destLonStride,
+                           double *range, ptrdiff_t rangeStride, double *bearing, ptrdiff_t bearingStride) {
+    return geo::runInverseBatch (count, AbiColumn (originLat, originLatStride), AbiColumn (originLon, originLonStride), AbiColumn (destLat, destLatStride),
+                                 AbiColumn (destLon, destLonStride), AbiColumn (range, rangeStride), AbiColumn (bearing, bearingStride),
+                                 [useWgs84] (geo::Pos *origin, geo::Pos *dest, double *rng, double *brg, size_t) {
+                                     return geo::calcRhumblineDistAndBrg (useWgs84 != 0, origin, dest, rng, brg);
+                                 });
+}
+
+size_t geo_gc_pos_v1 (int useWgs84, size_t count, const double *originLat, ptrdiff_t originLatStride, const double *originLon, ptrdiff_t originLonStride,
+                      const double *range, ptrdiff_t rangeStride, const double *bearing, ptrdiff_t bearingStride, double *destLat, ptrdiff_t destLatStride,
+                      double *destLon, ptrdiff_t destLonStride, double *endBearing, ptrdiff_t endBearingStride) {
+    AbiColumn endBearings (endBearing, endBearingStride);
+
+    return geo::runDirectBatch (count, AbiColumn (originLat, originLatStride), AbiColumn (originLon, originLonStride), AbiColumn (range, rangeStride),
+                                AbiColumn (bearing, bearingStride), AbiColumn (destLat, destLatStride), AbiColumn (destLon, destLonStride),
+                                [useWgs84, endBearings] (geo::Pos *origin, double rng, double brg, geo::Pos *dest, size_t i) {
+                                    double endBrg = 0.0;
+                                    auto result = geo::calcGreatCirclePos (useWgs84 != 0, origin, rng, brg, dest, & endBrg);
+
+                                    if (endBearings.data) endBearings [i] = result ? endBrg : 0.0;
+
+                                    return result;
+                                });
+}
+
+size_t geo_gc_dist_brg_v1 (int useWgs84, size_t count, const double *originLat, ptrdiff_t originLatStride, const double *originLon,
+                           ptrdiff_t originLonStride, const double *destLat, ptrdiff_t destLatStride, const double *destLon, ptrdiff_t destLonStride,
+                           double *range, ptrdiff_t rangeStride, double *bearing, ptrdiff_t bearingStride, double *endBearing, ptrdiff_t endBearingStride) {
+    AbiColumn endBearings (endBearing, endBearingStride);
+
+    return geo::runInverseBatch (count, AbiColumn (originLat, originLatStride), AbiColumn (originLon, originLonStride), AbiColumn (destLat, destLatStride),
+                                 AbiColumn (destLon, destLonStride), AbiColumn (range, rangeStride), AbiColumn (bearing, bearingStride),
+                                 [useWgs84, endBearings] (geo::Pos *origin, geo::Pos *dest, double *rng, double *brg, size_t i) {
+                                     double endBrg = 0.0;
+                                     auto result = geo::calcGreatCircleDistAndBrg (useWgs84 != 0, origin, dest, rng, brg, & endBrg);
+
+                                     if (endBearings.data) endBearings [i] = endBrg;
+
+                                     return result;
+                                 });
+}
@@ -0,0 +1,159 @@
+#define _INTERNAL_
+
+#include <string.h>
+#include "geo.h"
+
+#ifdef __cplusplus
+namespace geo {
+#endif
+
+static const size_t AIS_MAX_FIELDS = 7;
+static const size_t AIS_MAX_PAYLOAD = 42;
+static const size_t AIS_REPORT_BITS = 168;
+static const unsigned char AIS_INVALID_CHAR = 0xff;
+
+// Six bit value of the payload armoring character
+static const unsigned char AIS_SIXBIT [128] = {
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f,
+    0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0x1a, 0x1b, 0x1c, 0x1d, 0x1e, 0x1f,
+    0x20, 0x21, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0x28, 0x29, 0x2a, 0x2b, 0x2c, 0x2d, 0x2e, 0x2f, 0x30, 0x31, 0x32, 0x33, 0x34, 0x35, 0x36, 0x37,
+    0x38, 0x39, 0x3a, 0x3b, 0x3c, 0x3d, 0x3e, 0x3f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+};
+
+// Start bits of the position report fields
+struct AisReportLayout {
+    size_t sog, lon, lat, cog;
+};
+
+static const AisReportLayout CLASS_A_LAYOUT = { 50, 61, 89, 116 };
+static const AisReportLayout CLASS_B_LAYOUT = { 46, 57, 85, 112 };
+
+static const size_t AIS_SOG_BITS = 10;
+static const size_t AIS_LON_BITS = 28;
+static const size_t AIS_LAT_BITS = 27;
+static const size_t AIS_COG_BITS = 12;
+
+// "Not available" values
+static const unsigned long long AIS_NO_SOG = 1023;
+static const unsigned long long AIS_NO_COG = 3600;
+static const long long AIS_NO_LON = 181 * 600000;
+static const long long AIS_NO_LAT = 91 * 600000;
+
+// Payload packed into big endian 64 bit words; false if an invalid character is met
+static inline bool unpackAisPayload (const char *begin, const char *end, unsigned long long *words) {
+    memset (words, 0, sizeof (unsigned long long) * 4);
+
+    for (size_t i = 0, count = end - begin; i < count && i < AIS_MAX_PAYLOAD; ++ i) {
+        auto chr = (unsigned char) begin [i];
+        auto value = chr < 128 ? (unsigned long long) AIS_SIXBIT [chr] : AIS_INVALID_CHAR;
+
+        if (value == AIS_INVALID_CHAR) return false;
+
+        auto bitPos = i * 6;
+        auto word = bitPos >> 6;
+        auto offset = bitPos & 63;
+
+        if (offset <= 58) {
+            words [word] |= value << (58 - offset);
+        } else {
+            words [word] |= value >> (offset - 58);
+            words [word + 1] |= value << (122 - offset);
+        }
+    }
+
+    return true;
+}
+
+static inline unsigned long long getAisBits (const unsigned long long *words, size_t start, size_t length) {
+    auto word = start >> 6;
+    auto offset = start & 63;
+    auto value = words [word] << offset;
+
+    if (offset + length > 64) value |= words [word + 1] >> (64 - offset);
+
+    return value >> (64 - length);
+}
+
+static inline long long getAisSignedBits (const unsigned long long *words, size_t start, size_t length) {
+    auto value = getAisBits (words, start, length);
+
+    return (value >> (length - 1)) & 1 ? (long long) value - (1LL << length) : (long long) value;
+}
+
+static void decodeAisSentence (NmeaParser *parser, const char *begin, const char *end, PosBatch *output, void *context) {
+    auto reports = (AisReports *) context;
+    auto start = (const char *) memchr (begin, '!', end - begin);
+    const char *star;
+
+    if (!start) {
+        ++ parser->skipped;
+        return;
+    }
+
+    ++ parser->sentences;
+
+    if (!checkNmeaChecksum (start, end, & star)) {
+        ++ parser->badChecksums;
+        return;
+    }
+
+    NmeaField fields [AIS_MAX_FIELDS];
+    auto fieldCount = splitNmeaFields (start, star, fields, AIS_MAX_FIELDS);
+    unsigned long long words [4];
+
+    // Position reports always fit one fragment
+    if (fieldCount < 5 || (memcmp (start + 3, "VDM", 3) != 0 && memcmp (start + 3, "VDO", 3) != 0) ||
+        fields [0].end - fields [0].begin != 1 || *fields [0].begin != '1' ||
+        (size_t) (fields [4].end - fields [4].begin) * 6 < AIS_REPORT_BITS ||
+        !unpackAisPayload (fields [4].begin, fields [4].end, words)) {
+        ++ parser->skipped;
+        return;
+    }
+
+    auto type = getAisBits (words, 0, 6);
+    const AisReportLayout *layout;
+
+    switch (type) {
+        case 1: case 2: case 3: layout = & CLASS_A_LAYOUT; break;
+        case 18: layout = & CLASS_B_LAYOUT; break;
+        default: ++ parser->skipped; return;
+    }
+
+    auto lon = getAisSignedBits (words, layout->lon, AIS_LON_BITS);
+    auto lat = getAisSignedBits (words, layout->lat, AIS_LAT_BITS);
+
+    if (lon == AIS_NO_LON || lat == AIS_NO_LAT || lon > AIS_NO_LON || lon < - AIS_NO_LON || lat > AIS_NO_LAT || lat < - AIS_NO_LAT) {
+        ++ parser->skipped;
+        return;
+    }
+
+    auto sog = getAisBits (words, layout->sog, AIS_SOG_BITS);
+    auto cog = getAisBits (words, layout->cog, AIS_COG_BITS);
+    auto index = output->count;
+
+    reports->mmsi [index] = (unsigned int) getAisBits (words, 8, 30);
+    output->lat [index] = (double) lat / 600000.0 * RAD_IN_DEG;
+    output->lon [index] = (double) lon / 600000.0 * RAD_IN_DEG;
+
+    if (reports->sog) reports->sog [index] = sog == AIS_NO_SOG ? -1.0 : (double) sog * 0.1;
+    if (reports->cog) reports->cog [index] = cog >= AIS_NO_COG ? -1.0 : (double) cog * 0.1 * RAD_IN_DEG;
+
+    ++ output->count;
+    ++ parser->fixes;
+}
+
+// Decodes the AIVDM/AIVDO sentences of the raw buffer appending position reports to the columns until
+// they are full; returns the number of bytes consumed (see parseNmea)
+size_t decodeAis (NmeaParser *parser, const char *data, size_t size, AisReports *reports) {
+    if (!reports || !reports->mmsi) return 0;
+
+    return scanNmeaSentences (parser, data, size, decodeAisSentence, & reports->positions, reports);
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,142 @@
+#define _INTERNAL_
+
+#include <math.h>
+#include "geo.h"
+
+#ifdef __cplusplus
+namespace geo {
+#endif
+
+// Number of bearings prepared on the stack per one batch kernel call
+static const size_t ARC_CHUNK_SIZE = 64;
+
+size_t calcArcPointCount (double angle, double angleStep, bool includeEndPoint) {
+    if (invalidVal (angle) || invalidVal (angleStep) || angleStep <= 0.0 || fabs (angle) > TWO_PI) return 0;
+
+    auto steps = (size_t) ceil (fabs (angle) / angleStep - DEFPRECISION);
+
+    if (steps == 0) steps = 1;
+
+    return includeEndPoint ? steps + 1 : steps;
+}
+
+// Fills count points of an arc starting from point first; the arc is divided by steps equal parts
+static bool buildArcPoints (
+    bool useWgs84,
+    Method method,
+    Pos *center,
+    double range,
+    double begBearing,
+    double angle,
+    size_t steps,
+    size_t count,
+    PosBatch *output,
+    size_t first
+) {
+    double bearings [ARC_CHUNK_SIZE], ranges [ARC_CHUNK_SIZE];
+    auto angleStep = angle / (double) steps;
+    bool result = true;
+
+    for (size_t i = 0; i < ARC_CHUNK_SIZE; ++ i) ranges [i] = range;
+
+    for (size_t done = 0; done < count; done += ARC_CHUNK_SIZE) {
+        auto chunkSize = count - done < ARC_CHUNK_SIZE ? count - done : ARC_CHUNK_SIZE;
+        PosBatch chunk { output->lat + first + done, output->lon + first + done, chunkSize, 0 };
+
+        for (size_t i = 0; i < chunkSize; ++ i) {
+            bearings [i] = begBearing + angleStep * (double) (done + i);
+
+            normalizeAngle (bearings + i);
+        }
+
+        if (method == GREAT_CIRCLE)
+            result = calcGreatCirclePosBatch (useWgs84, center, ranges, bearings, chunkSize, & chunk, 0) && result;
+        else
+            result = calcRhumblinePosBatch (useWgs84, center, ranges, bearings, chunkSize, & chunk) && result;
+    }
+
+    return result;
+}
+
+// Builds arcs for many centers at once; points of all the arcs are stored one by one into the output buffer,
+// the index of the first point of each arc is stored into firstPoints (optional, arcCount items)
+bool buildGeoArcs (bool useWgs84, Method method, Arc *arcs, size_t arcCount, double angleStep, bool includeEndPoint, PosBatch *output, size_t *firstPoints) {
+    if (!arcs || !output) return false;
+
+    size_t total = 0;
+
+    output->count = 0;
+
+    for (size_t i = 0; i < arcCount; ++ i) {
+        auto count = calcArcPointCount (arcs [i].angle, angleStep, includeEndPoint);
+
+        if (count == 0) return false;
+
+        total += count;
+    }
+
+    if (output->capacity < total) return false;
+
+    bool result = true;
+
+    total = 0;
+
+    for (size_t i = 0; i < arcCount; ++ i) {
+        Pos center = arcs [i].center, begin = arcs [i].begin;
+        double range = 0.0, bearing = 0.0;
+        auto count = calcArcPointCount (arcs [i].angle, angleStep, includeEndPoint);
+        auto steps = includeEndPoint ? count - 1 : count;
+
+        if (firstPoints) firstPoints [i] = total;
+
+        if (method == GREAT_CIRCLE) {
+            result = calcGreatCircleDistAndBrg (useWgs84, & center, & begin, & range, & bearing, 0) && result;
+        } else {
+            result = calcRhumblineDistAndBrg (useWgs84, & center, & begin, & range, & bearing) && result;
+        }
+
+        result = buildArcPoints (useWgs84, method, & center, range, bearing, arcs [i].angle, steps, count, output, total) && result;
+
+        // Begin point is known exactly
+        output->lat [total] = arcs [i].begin.lat;
+        output->lon [total] = arcs [i].begin.lon;
+
+        total += count;
+    }
+
+    output->count = total;
+
+    return result;
+}
+
+// Builds closed great circle range rings of the same radius around many centers; each ring takes
+// calcArcPointCount (TWO_PI, angleStep, true) points, the last point of the ring repeats the first one
+bool buildRangeRings (bool useWgs84, Pos *centers, size_t centerCount, double range, double angleStep, PosBatch *output) {
+    if (!centers || !output) return false;
+
+    auto count = calcArcPointCount (TWO_PI, angleStep, true);
+
+    output->count = 0;
+
+    if (count == 0 || wrongDistance (range) || output->capacity < count * centerCount) return false;
+
+    bool result = true;
+
+    for (size_t i = 0; i < centerCount; ++ i) {
+        Pos center = centers [i];
+        auto first = i * count;
+
+        result = buildArcPoints (useWgs84, GREAT_CIRCLE, & center, range, 0.0, TWO_PI, count - 1, count - 1, output, first) && result;
+
+        output->lat [first + count - 1] = output->lat [first];
+        output->lon [first + count - 1] = output->lon [first];
+    }
+
+    output->count = count * centerCount;
+
+    return result;
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,258 @@
+#define _INTERNAL_
+
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+#include <mutex>
+#include <new>
+#include <vector>
+#include "geo.h"
+
+#ifdef __cplusplus
+namespace geo {
+#endif
+
+static const size_t MAX_LEG_CACHE_SHARDS = 16;
+static const uint32_t NO_LEG = 0xFFFFFFFF;
+
+// Endpoints in quanta, the method and the ellipsoid
+struct LegKey {
+    int64_t lat1, lon1, lat2, lon2;
+    int64_t method;
+
+    bool operator == (const LegKey& other) const {
+        return lat1 == other.lat1 && lon1 == other.lon1 && lat2 == other.lat2 && lon2 == other.lon2 && method == other.method;
+    }
+};
+
+// Entry is chained in its hash bucket and in the LRU list (most recent first)
+struct LegEntry {
+    LegKey key;
+    uint64_t hash;
+    double range, bearing;
+    uint32_t chain, prev, next;
+};
+
+struct LegShard {
+    std::mutex lock;
+    std::vector <LegEntry> entries;
+    std::vector <uint32_t> buckets;
+    uint32_t used, first, last;
+    unsigned long long hits, misses, evictions;
+};
+
+static inline uint64_t hashLegKey (const LegKey& key) {
+    const int64_t fields [] = { key.lat1, key.lon1, key.lat2, key.lon2, key.method };
+    uint64_t hash = 0x9E3779B97F4A7C15ull;
+
+    for (auto field : fields) {
+        hash = (hash ^ (uint64_t) field) * 0xBF58476D1CE4E5B9ull;
+        hash ^= hash >> 31;
+    }
+
+    return hash;
+}
+
+static inline void unlinkLeg (LegShard *shard, uint32_t index) {
+    auto entry = & shard->entries [index];
+
+    if (entry->prev != NO_LEG) shard->entries [entry->prev].next = entry->next; else shard->first = entry->next;
+    if (entry->next != NO_LEG) shard->entries [entry->next].prev = entry->prev; else shard->last = entry->prev;
+}
+
+static inline void pushLeg (LegShard *shard, uint32_t index) {
+    auto entry = & shard->entries [index];
+
+    entry->prev = NO_LEG;
+    entry->next = shard->first;
+
+    if (shard->first != NO_LEG) shard->entries [shard->first].prev = index; else shard->last = index;
+
+    shard->first = index;
+}
+
+// Shard must be locked by the caller; the entry found becomes the most recent one
+static uint32_t findLeg (LegShard *shard, const LegKey& key, uint64_t hash) {
+    for (auto index = shard->buckets [hash & (shard->buckets.size () - 1)]; index != NO_LEG; index = shard->entries [index].chain) {
+        auto entry = & shard->entries [index];
+
+        if (entry->hash == hash && entry->key == key) {
+            if (shard->first != index) {
+                unlinkLeg (shard, index);
+                pushLeg (shard, index);
+            }
+
+            return index;
+        }
+    }
+
+    return NO_LEG;
+}
+
+// Shard must be locked by the caller; the least recent entry is evicted if the shard is full
+static void addLeg (LegShard *shard, const LegKey& key, uint64_t hash, double range, double bearing) {
+    uint32_t index;
+
+    if (shard->used < shard->entries.size ()) {
+        index = shard->used ++;
+    } else {
+        index = shard->last;
+
+        auto link = & shard->buckets [shard->entries [index].hash & (shard->buckets.size () - 1)];
+
+        while (*link != index) link = & shard->entries [*link].chain;
+
+        *link = shard->entries [index].chain;
+
+        unlinkLeg (shard, index);
+
+        ++ shard->evictions;
+    }
+
+    auto entry = & shard->entries [index];
+    auto bucket = & shard->buckets [hash & (shard->buckets.size () - 1)];
+
+    entry->key = key;
+    entry->hash = hash;
+    entry->range = range;
+    entry->bearing = bearing;
+    entry->chain = *bucket;
+    *bucket = index;
+
+    pushLeg (shard, index);
+}
+
+// Capacity is split into up to 16 shards; every shard has twice as many buckets as entries
+bool openLegCache (size_t capacity, double quantum, LegCache *cache) {
+    if (!cache) return false;
+
+    memset (cache, 0, sizeof (*cache));
+
+    if (capacity == 0 || capacity > ((size_t) 1 << 30) || invalidVal (quantum) || quantum < 1.0e-12 || quantum > 1.0e-2) return false;
+
+    size_t shardCount = 1, bucketCount = 1;
+
+    while (shardCount < MAX_LEG_CACHE_SHARDS && shardCount * 64 < capacity) shardCount <<= 1;
+
+    auto shardCapacity = (capacity + shardCount - 1) / shardCount;
+
+    while (bucketCount < shardCapacity * 2) bucketCount <<= 1;
+
+    auto shards = new (std::nothrow) LegShard [shardCount];
+
+    if (!shards) return false;
+
+    for (size_t i = 0; i < shardCount; ++ i) {
+        auto shard = shards + i;
+
+        shard->entries.resize (shardCapacity);
+        shard->buckets.assign (bucketCount, NO_LEG);
+        shard->used = 0;
+        shard->first = shard->last = NO_LEG;
+        shard->hits = shard->misses = shard->evictions = 0;
+    }
+
+    cache->shards = shards;
+    cache->shardCount = shardCount;
+    cache->shardCapacity = shardCapacity;
+    cache->quantum = quantum;
+
+    return true;
+}
+
+void closeLegCache (LegCache *cache) {
+    if (!cache) return;
+
+    delete [] (LegShard *) cache->shards;
+
+    memset (cache, 0, sizeof (*cache));
+}
+
+static inline bool loadLegPoint (const Pos *pos, double quantum, int64_t *lat, int64_t *lon) {
+    auto posLon = pos->lon;
+
+    if (invalidVal (pos->lat) || invalidVal (posLon) || fabs (pos->lat) > HALF_PI || fabs (posLon) > 10000.0) return false;
+
+    normalizeLon (& posLon);
+
+    *lat = (int64_t) floor (pos->lat / quantum + 0.5);
+    *lon = (int64_t) floor (posLon / quantum + 0.5);
+
+    return true;
+}
+
+// Looks the leg up under the shard lock; a miss is solved out of the lock and added unless another thread has added
+// it meanwhile
+bool calcLegCached (LegCache *cache, Method method, bool useWgs84, const Pos *origin, const Pos *dest, double *range, double *bearing) {
+    if (range) *range = 0.0;
+    if (bearing) *bearing = 0.0;
+
+    if (!cache || !cache->shards || !origin || !dest || (method != RHUMBLINE && method != GREAT_CIRCLE)) return false;
+
+    LegKey key;
+
+    if (!loadLegPoint (origin, cache->quantum, & key.lat1, & key.lon1) || !loadLegPoint (dest, cache->quantum, & key.lat2, & key.lon2)) return false;
+
+    key.method = method * 2 + (useWgs84 ? 1 : 0);
+
+    auto hash = hashLegKey (key);
+    auto shard = (LegShard *) cache->shards + (hash >> 60) % cache->shardCount;
+    double rng, brg;
+
+    {
+        std::lock_guard <std::mutex> lock (shard->lock);
+        auto index = findLeg (shard, key, hash);
+
+        if (index != NO_LEG) {
+            ++ shard->hits;
+
+            if (range) *range = shard->entries [index].range;
+            if (bearing) *bearing = shard->entries [index].bearing;
+
+            return true;
+        }
+
+        ++ shard->misses;
+    }
+
+    Pos begin { key.lat1 * cache->quantum, key.lon1 * cache->quantum }, end { key.lat2 * cache->quantum, key.lon2 * cache->quantum };
+    auto result = method == RHUMBLINE ? calcRhumblineDistAndBrg (useWgs84, & begin, & end, & rng, & brg) :
+                                        calcGreatCircleDistAndBrg (useWgs84, & begin, & end, & rng, & brg, 0);
+
+    if (!result) return false;
+
+    {
+        std::lock_guard <std::mutex> lock (shard->lock);
+
+        if (findLeg (shard, key, hash) == NO_LEG) addLeg (shard, key, hash, rng, brg);
+    }
+
+    if (range) *range = rng;
+    if (bearing) *bearing = brg;
+
+    return true;
+}
+
+bool getLegCacheStats (LegCache *cache, LegCacheStats *stats) {
+    if (!cache || !cache->shards || !stats) return false;
+
+    memset (stats, 0, sizeof (*stats));
+
+    for (size_t i = 0; i < cache->shardCount; ++ i) {
+        auto shard = (LegShard *) cache->shards + i;
+        std::lock_guard <std::mutex> lock (shard->lock);
+
+        stats->hits += shard->hits;
+        stats->misses += shard->misses;
+        stats->evictions += shard->evictions;
+        stats->entries += shard->used;
+    }
+
+    stats->capacity = cache->shardCount * cache->shardCapacity;
+
+    return true;
+}
+
+#ifdef __cplusplus
+}
+#endif
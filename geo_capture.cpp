@@ -0,0 +1,372 @@
+#define _INTERNAL_
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "geo.h"
+#include "geocapture.h"
+
+#ifdef __cplusplus
+namespace geo {
+#endif
+
+static const char CAPTURE_SIGNATURE [8] = { 'G', 'E', 'O', 'C', 'A', 'P', 'T', '1' };
+static const size_t CAPTURE_RECORDS_OFFSET = 64;
+static const auto CAPTURE_FLUSH_PERIOD = std::chrono::milliseconds (10);
+
+// Record count is stored when the capture stops; zero means it was not stopped and the whole records found in the
+// file are taken
+#pragma pack(push, 8)
+struct CaptureHeader {
+    char signature [8];
+    uint64_t recordSize, recordCount, dropped;
+};
+#pragma pack(pop)
+
+// Single producer (the owner thread) single consumer (the flusher) ring; positions grow forever and are masked
+struct CaptureRing {
+    std::vector <GeoCallRecord> records;
+    size_t mask;
+    std::atomic <uint64_t> head, tail, dropped;
+    std::atomic <bool> retired;
+    CaptureRing *next;
+};
+
+// Ring of the thread and the flag of the call being captured; the ring is retired at the thread exit and freed by
+// the flusher once drained
+struct CaptureRingHolder {
+    CaptureRing *ring = 0;
+    bool busy = false;
+
+    ~CaptureRingHolder () {
+        if (ring) ring->retired.store (true, std::memory_order_release);
+    }
+};
+
+std::atomic <bool> captureOn (false);
+
+static thread_local CaptureRingHolder captureRing;
+
+// Rings, the file and the flusher state are guarded by the registry lock; sessions are started and stopped under
+// the session lock
+static std::mutex registryLock, sessionLock;
+static std::condition_variable flushSignal;
+static CaptureRing *rings = 0;
+static FILE *captureFile = 0;
+static std::thread flusher;
+static bool flusherStop = false;
+static size_t captureRingSize = 0;
+static uint64_t recordsWritten = 0, retiredDropped = 0;
+
+// Capture left running is stopped at the exit, so the file gets its header and the flusher is joined
+static struct CaptureGuard {
+    ~CaptureGuard () {
+        stopGeoCapture (0, 0);
+    }
+} captureGuard;
+
+static CaptureRing *registerCaptureRing () {
+    std::lock_guard <std::mutex> lock (registryLock);
+
+    if (!captureRingSize) return 0;
+
+    auto ring = new CaptureRing ();
+
+    ring->records.resize (captureRingSize);
+    ring->mask = captureRingSize - 1;
+    ring->next = rings;
+    rings = ring;
+
+    return captureRing.ring = ring;
+}
+
+void CallCapture::begin (GeoCall call, bool useWgs84, const Pos *origin, double input2, double input3) {
+    if (captureRing.busy) return;
+
+    captureRing.busy = active = true;
+
+    record.call = (unsigned short) call;
+    record.useWgs84 = useWgs84 ? 1 : 0;
+    record.reserved = 0;
+    record.inputs [0] = origin ? origin->lat : NAN;
+    record.inputs [1] = origin ? origin->lon : NAN;
+    record.inputs [2] = input2;
+    record.inputs [3] = input3;
+}
+
+void CallCapture::commit (bool result, double output0, double output1, double output2) {
+    auto ring = captureRing.ring ? captureRing.ring : registerCaptureRing ();
+
+    captureRing.busy = false;
+
+    record.result = result ? 1 : 0;
+    record.outputs [0] = output0;
+    record.outputs [1] = output1;
+    record.outputs [2] = output2;
+
+    if (!ring) return;
+
+    auto head = ring->head.load (std::memory_order_relaxed);
+
+    if (head - ring->tail.load (std::memory_order_acquire) > ring->mask) {
+        ring->dropped.fetch_add (1, std::memory_order_relaxed);
+        return;
+    }
+
+    ring->records [head & ring->mask] = record;
+    ring->head.store (head + 1, std::memory_order_release);
+}
+
+// Registry must be locked by the caller; retired rings are freed once drained
+static void drainCaptureRings () {
+    for (auto link = & rings; *link;) {
+        auto ring = *link;
+        auto retired = ring->retired.load (std::memory_order_acquire);
+        auto head = ring->head.load (std::memory_order_acquire);
+        auto tail = ring->tail.load (std::memory_order_relaxed);
+
+        while (tail != head) {
+            auto first = (size_t) (tail & ring->mask);
+            auto count = (size_t) (head - tail);
+
+            if (first + count > ring->records.size ()) count = ring->records.size () - first;
+
+            if (captureFile) recordsWritten += fwrite (ring->records.data () + first, sizeof (GeoCallRecord), count, captureFile);
+
+            tail += count;
+        }
+
+        ring->tail.store (tail, std::memory_order_release);
+
+        if (retired) {
+            retiredDropped += ring->dropped.load (std::memory_order_relaxed);
+            *link = ring->next;
+            delete ring;
+        } else {
+            link = & ring->next;
+        }
+    }
+}
+
+static void runCaptureFlusher () {
+    std::unique_lock <std::mutex> lock (registryLock);
+
+    while (!flusherStop) {
+        drainCaptureRings ();
+        flushSignal.wait_for (lock, CAPTURE_FLUSH_PERIOD);
+    }
+}
+
+static void initCaptureHeader (uint64_t recordCount, uint64_t dropped, CaptureHeader *header) {
+    memcpy (header->signature, CAPTURE_SIGNATURE, sizeof (header->signature));
+
+    header->recordSize = sizeof (GeoCallRecord);
+    header->recordCount = recordCount;
+    header->dropped = dropped;
+}
+
+static bool writeCaptureHeader (uint64_t recordCount, uint64_t dropped) {
+    char block [CAPTURE_RECORDS_OFFSET] = {};
+
+    initCaptureHeader (recordCount, dropped, (CaptureHeader *) block);
+
+    return fseek (captureFile, 0, SEEK_SET) == 0 && fwrite (block, sizeof (block), 1, captureFile) == 1;
+}
+
+// Ring size is rounded up to a power of two; rings left by the previous session are emptied
+bool startGeoCapture (const char *path, size_t ringSize) {
+    if (!path || ringSize == 0 || ringSize > ((size_t) 1 << 24)) return false;
+
+    std::lock_guard <std::mutex> session (sessionLock);
+
+    if (captureOn.load ()) return false;
+
+    std::unique_lock <std::mutex> lock (registryLock);
+
+    if (!(captureFile = fopen (path, "wb"))) return false;
+
+    if (!writeCaptureHeader (0, 0)) {
+        fclose (captureFile);
+        captureFile = 0;
+        return false;
+    }
+
+    for (captureRingSize = 1; captureRingSize < ringSize; captureRingSize <<= 1);
+
+    for (auto ring = rings; ring; ring = ring->next) {
+        ring->tail.store (ring->head.load (std::memory_order_acquire), std::memory_order_release);
+        ring->dropped.store (0, std::memory_order_relaxed);
+    }
+
+    recordsWritten = retiredDropped = 0;
+    flusherStop = false;
+    flusher = std::thread (runCaptureFlusher);
+
+    lock.unlock ();
+
+    captureOn.store (true);
+
+    return true;
+}
+
+// Calls still running when the capture stops may leave their records in the rings; they are discarded by the next
+// session
+bool stopGeoCapture (size_t *written, size_t *dropped) {
+    std::lock_guard <std::mutex> session (sessionLock);
+
+    if (!captureOn.load ()) return false;
+
+    captureOn.store (false);
+
+    {
+        std::lock_guard <std::mutex> lock (registryLock);
+
+        flusherStop = true;
+    }
+
+    flushSignal.notify_one ();
+    flusher.join ();
+
+    std::lock_guard <std::mutex> lock (registryLock);
+
+    drainCaptureRings ();
+
+    auto lost = retiredDropped;
+
+    for (auto ring = rings; ring; ring = ring->next) lost += ring->dropped.load (std::memory_order_relaxed);
+
+    auto result = writeCaptureHeader (recordsWritten, lost);
+
+    if (fclose (captureFile) != 0) result = false;
+
+    captureFile = 0;
+
+    if (written) *written = (size_t) recordsWritten;
+    if (dropped) *dropped = (size_t) lost;
+
+    return result;
+}
+
+bool openCaptureFile (const char *path, CaptureFile *capture) {
+    if (!capture) return false;
+
+    memset (capture, 0, sizeof (*capture));
+
+    if (!mapFile (path, false, 0, & capture->file)) return false;
+
+    auto header = (const CaptureHeader *) capture->file.data;
+    auto size = capture->file.size;
+
+    if (size < CAPTURE_RECORDS_OFFSET || memcmp (header->signature, CAPTURE_SIGNATURE, sizeof (header->signature)) != 0 ||
+        header->recordSize != sizeof (GeoCallRecord) || header->recordCount > (size - CAPTURE_RECORDS_OFFSET) / sizeof (GeoCallRecord)) {
+        unmapFile (& capture->file);
+        return false;
+    }
+
+    capture->records = (const GeoCallRecord *) ((const char *) capture->file.data + CAPTURE_RECORDS_OFFSET);
+    capture->recordCount = header->recordCount ? (size_t) header->recordCount : (size - CAPTURE_RECORDS_OFFSET) / sizeof (GeoCallRecord);
+    capture->dropped = (size_t) header->dropped;
+
+    return true;
+}
+
+void closeCaptureFile (CaptureFile *capture) {
+    if (!capture) return;
+
+    unmapFile (& capture->file);
+    memset (capture, 0, sizeof (*capture));
+}
+
+// Inputs are copied so the call sees them as they were passed
+static bool replayCall (const GeoCallRecord *record, double *outputs) {
+    Pos origin { record->inputs [0], record->inputs [1] }, dest { record->inputs [2], record->inputs [3] };
+    auto useWgs84 = record->useWgs84 != 0;
+
+    outputs [0] = outputs [1] = outputs [2] = 0.0;
+
+    switch (record->call) {
+        case GEO_CALL_RL_POS: {
+            auto result = calcRhumblinePos (useWgs84, & origin, record->inputs [2], record->inputs [3], & dest);
+
+            outputs [0] = dest.lat;
+            outputs [1] = dest.lon;
+
+            return result;
+        }
+        case GEO_CALL_RL_DIST_BRG:
+            return calcRhumblineDistAndBrg (useWgs84, & origin, & dest, outputs, outputs + 1);
+
+        case GEO_CALL_GC_POS: {
+            auto result = calcGreatCirclePos (useWgs84, & origin, record->inputs [2], record->inputs [3], & dest, outputs + 2);
+
+            outputs [0] = dest.lat;
+            outputs [1] = dest.lon;
+
+            return result;
+        }
+        case GEO_CALL_GC_DIST_BRG:
+            return calcGreatCircleDistAndBrg (useWgs84, & origin, & dest, outputs, outputs + 1, outputs + 2);
+
+        default:
+            return false;
+    }
+}
+
+// Calls are replayed by the kind, every kind is timed alone; results are compared after the timed pass
+bool replayCapture (const CaptureFile *capture, ReplayStats *stats) {
+    if (!capture || !capture->records || !stats) return false;
+
+    memset (stats, 0, sizeof (*stats));
+
+    std::vector <double> outputs (capture->recordCount * 3);
+    std::vector <bool> results (capture->recordCount);
+
+    for (size_t call = 0; call < GEO_CALL_COUNT; ++ call) {
+        auto start = std::chrono::steady_clock::now ();
+
+        for (size_t i = 0; i < capture->recordCount; ++ i) {
+            if (capture->records [i].call == call) results [i] = replayCall (capture->records + i, outputs.data () + i * 3);
+        }
+
+        std::chrono::duration <double> elapsed = std::chrono::steady_clock::now () - start;
+
+        stats->seconds [call] = elapsed.count ();
+    }
+
+    for (size_t i = 0; i < capture->recordCount; ++ i) {
+        auto record = capture->records + i;
+
+        if (record->call >= GEO_CALL_COUNT) continue;
+
+        ++ stats->calls [record->call];
+
+        if (results [i] != (record->result != 0)) {
+            ++ stats->mismatches [record->call];
+            continue;
+        }
+
+        if (!results [i]) continue;
+
+        // Range of the inverse problems is the only output not being an angle
+        for (size_t j = 0; j < 3; ++ j) {
+            auto diff = outputs [i * 3 + j] - record->outputs [j];
+
+            if (j > 0 || record->call == GEO_CALL_RL_POS || record->call == GEO_CALL_GC_POS) diff = remainder (diff, TWO_PI);
+
+            diff = fabs (diff);
+
+            if (diff > stats->maxDiff [record->call][j] || invalidVal (diff)) stats->maxDiff [record->call][j] = diff;
+        }
+    }
+
+    return true;
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,236 @@
+#define _INTERNAL_
+
+#include <math.h>
+#include <vector>
+#include "geo.h"
+
+#ifdef __cplusplus
+namespace geo {
+#endif
+
+void initGeoContext (GeoContext *context) {
+    if (!context) return;
+
+    context->ellipsoid = WGS84_ELLIPSOID;
+    context->precision = DEFPRECISION;
+    context->stepDistance = STEP_RANGE;
+    context->radians = true;
+    context->lastError = GEO_OK;
+    context->maxIterations = 0;
+    context->lastGcPath = GC_PATH_NONE;
+}
+
+static inline GeoStatus reportStatus (GeoContext *context, GeoStatus status) {
+    if (status != GEO_OK) context->lastError = status;
+
+    return status;
+}
+
+// Angles come in and go out in the context units, kernels work in radians
+static inline double loadAngle (const GeoContext *context, double angle) {
+    return context->radians ? angle : angle * RAD_IN_DEG;
+}
+
+static inline double storeAngle (const GeoContext *context, double angle) {
+    return context->radians ? angle : angle * DEG_IN_RAD;
+}
+
+static GeoStatus loadPos (const GeoContext *context, const Pos *source, Pos *pos) {
+    if (!source || invalidVal (source->lat) || invalidVal (source->lon)) return GEO_INVALID_ARGUMENT;
+
+    pos->lat = loadAngle (context, source->lat);
+    pos->lon = loadAngle (context, source->lon);
+
+    if (fabs (pos->lat) > HALF_PI || fabs (pos->lon) > 10000.0) return GEO_OUT_OF_RANGE;
+
+    normalizeLon (& pos->lon);
+
+    return GEO_OK;
+}
+
+static inline void storePos (const GeoContext *context, const Pos *pos, Pos *dest) {
+    dest->lat = storeAngle (context, pos->lat);
+    dest->lon = storeAngle (context, pos->lon);
+}
+
+// Precision bounds the iterations and the step splits the lines, so both must be positive
+static inline bool checkSetting (double value) {
+    return !invalidVal (value) && value > 0.0;
+}
+
+GeoStatus calcRhumblinePosEx (GeoContext *context, const Pos *origin, double range, double bearing, Pos *dest) {
+    if (!context) return GEO_INVALID_ARGUMENT;
+    if (!dest || invalidVal (range) || invalidVal (bearing)) return reportStatus (context, GEO_INVALID_ARGUMENT);
+
+    Pos begin, end;
+    auto status = loadPos (context, origin, & begin);
+
+    if (status != GEO_OK) return reportStatus (context, status);
+
+    if (!calcRlDirect (context->ellipsoid, context->precision, & begin, range, loadAngle (context, bearing), & end)) return reportStatus (context, GEO_OUT_OF_RANGE);
+
+    storePos (context, & end, dest);
+
+    return GEO_OK;
+}
+
+GeoStatus calcRhumblineDistAndBrgEx (GeoContext *context, const Pos *origin, const Pos *dest, double *range, double *bearing) {
+    if (!context) return GEO_INVALID_ARGUMENT;
+
+    Pos begin, end;
+    double rng, brg;
+    auto status = loadPos (context, origin, & begin);
+
+    if (status == GEO_OK) status = loadPos (context, dest, & end);
+    if (status != GEO_OK) return reportStatus (context, status);
+
+    if (!calcRlInverse (context->ellipsoid, context->precision, & begin, & end, & rng, & brg)) return reportStatus (context, GEO_OUT_OF_RANGE);
+
+    if (range) *range = rng;
+    if (bearing) *bearing = storeAngle (context, brg);
+
+    return GEO_OK;
+}
+
+// Rhumb line split by context->stepDistance (see calcRhumblineDistAndBrg2)
+GeoStatus calcRhumblineDistAndBrg2Ex (GeoContext *context, const Pos *origin, const Pos *dest, double *range, double *bearing) {
+    if (!context) return GEO_INVALID_ARGUMENT;
+    if (!checkSetting (context->stepDistance)) return reportStatus (context, GEO_INVALID_ARGUMENT);
+
+    Pos begin, end;
+    double rng, brg;
+    auto status = loadPos (context, origin, & begin);
+
+    if (status == GEO_OK) status = loadPos (context, dest, & end);
+    if (status != GEO_OK) return reportStatus (context, status);
+
+    if (!checkSegmentRag (begin.lat, begin.lon, end.lat, end.lon, true, false) ||
+        !calcRlInverseSplit (context->ellipsoid, context->precision, context->stepDistance, & begin, & end, & rng, & brg))
+        return reportStatus (context, GEO_OUT_OF_RANGE);
+
+    if (range) *range = rng;
+    if (bearing) *bearing = storeAngle (context, brg);
+
+    return GEO_OK;
+}
+
+GeoStatus calcGreatCirclePosEx (GeoContext *context, const Pos *origin, double range, double bearing, Pos *dest, double *endBearing) {
+    if (!context) return GEO_INVALID_ARGUMENT;
+    if (!dest || invalidVal (range) || invalidVal (bearing) || !checkSetting (context->precision)) return reportStatus (context, GEO_INVALID_ARGUMENT);
+
+    Pos begin, end;
+    double endBrg;
+    auto status = loadPos (context, origin, & begin);
+
+    if (status != GEO_OK) return reportStatus (context, status);
+
+    bearing = loadAngle (context, bearing);
+
+    normalizeAngle (& bearing);
+
+    if (wrongDistance (range) || !checkBegPointCourseDist (begin.lat, begin.lon, bearing, range, false)) return reportStatus (context, GEO_OUT_OF_RANGE);
+
+    if (fabs (range) < context->precision) {
+        end = begin;
+        endBrg = bearing;
+    } else {
+        calcGcDirect (context->ellipsoid, context->precision, & begin, range, bearing, & end, & endBrg);
+    }
+
+    storePos (context, & end, dest);
+
+    if (endBearing) *endBearing = storeAngle (context, endBrg);
+
+    return GEO_OK;
+}
+
+GeoStatus calcGreatCircleDistAndBrgEx (GeoContext *context, const Pos *origin, const Pos *dest, double *range, double *bearing, double *endBearing) {
+    if (!context) return GEO_INVALID_ARGUMENT;
+    if (!checkSetting (context->precision)) return reportStatus (context, GEO_INVALID_ARGUMENT);
+
+    Pos begin, end;
+    double rng = 0.0, brg = 0.0, endBrg = 0.0;
+    auto status = loadPos (context, origin, & begin);
+
+    if (status == GEO_OK) status = loadPos (context, dest, & end);
+    if (status != GEO_OK) return reportStatus (context, status);
+
+    if (!checkSegmentRag (begin.lat, begin.lon, end.lat, end.lon, true, false)) return reportStatus (context, GEO_OUT_OF_RANGE);
+
+    context->lastGcPath = GC_PATH_NONE;
+
+    // Same points give zero range and bearings
+    if (!isSame (begin.lat, end.lat, context->precision) || !isSame (begin.lon, end.lon, context->precision))
+        calcGcInverse (context->ellipsoid, context->precision, & begin, & end, & rng, & brg, & endBrg, 0, 0, context->maxIterations,
+                       & context->lastGcPath);
+
+    if (range) *range = rng;
+    if (bearing) *bearing = storeAngle (context, brg);
+    if (endBearing) *endBearing = storeAngle (context, endBrg);
+
+    return GEO_OK;
+}
+
+// Route in the context units to radians; corridors are built by the legacy WGS84 calls, so other ellipsoids are refused
+static GeoStatus loadRoute (const GeoContext *context, const Pos *route, size_t pointCount, std::vector <Pos>& points) {
+    if (!route || pointCount < 2) return GEO_INVALID_ARGUMENT;
+    if (context->ellipsoid.equRadius != WGS84_EQUAT_RAD_M || context->ellipsoid.flattening != WGS84_FLATTENING) return GEO_INVALID_ARGUMENT;
+
+    points.resize (pointCount);
+
+    for (size_t i = 0; i < pointCount; ++ i) {
+        auto status = loadPos (context, route + i, & points [i]);
+
+        if (status != GEO_OK) return status;
+    }
+
+    return GEO_OK;
+}
+
+// Corridor geometry is WGS84 only; the context gives the step distance and the units
+GeoStatus calcRouteCorridorSizeEx (GeoContext *context, Method method, const Pos *route, size_t pointCount, const double *portXte, const double *stbdXte,
+                                   double angleStep, size_t *contourCount, size_t *vertexCount) {
+    if (!context) return GEO_INVALID_ARGUMENT;
+
+    std::vector <Pos> points;
+    auto status = loadRoute (context, route, pointCount, points);
+
+    if (status != GEO_OK) return reportStatus (context, status);
+
+    if (!calcRouteCorridorSize (true, method, points.data (), pointCount, portXte, stbdXte, context->stepDistance, loadAngle (context, angleStep), contourCount, vertexCount))
+        return reportStatus (context, GEO_INVALID_ARGUMENT);
+
+    return GEO_OK;
+}
+
+GeoStatus buildRouteCorridorEx (GeoContext *context, Method method, const Pos *route, size_t pointCount, const double *portXte, const double *stbdXte,
+                                double angleStep, RegionBuffer *corridor) {
+    if (!context) return GEO_INVALID_ARGUMENT;
+    if (!corridor) return reportStatus (context, GEO_INVALID_ARGUMENT);
+
+    std::vector <Pos> points;
+    size_t contourCount, vertexCount;
+    auto status = loadRoute (context, route, pointCount, points);
+
+    angleStep = loadAngle (context, angleStep);
+
+    if (status != GEO_OK) return reportStatus (context, status);
+
+    if (!calcRouteCorridorSize (true, method, points.data (), pointCount, portXte, stbdXte, context->stepDistance, angleStep, & contourCount, & vertexCount))
+        return reportStatus (context, GEO_INVALID_ARGUMENT);
+
+    if (corridor->contourCapacity < contourCount || corridor->vertexCapacity < vertexCount) return reportStatus (context, GEO_BUFFER_TOO_SMALL);
+
+    if (!buildRouteCorridor (true, method, points.data (), pointCount, portXte, stbdXte, context->stepDistance, angleStep, corridor))
+        return reportStatus (context, GEO_OUT_OF_RANGE);
+
+    if (!context->radians) {
+        for (size_t i = 0; i < vertexCount; ++ i) storePos (context, corridor->vertexes + i, corridor->vertexes + i);
+    }
+
+    return GEO_OK;
+}
+
+#ifdef __cplusplus
+}
+#endif
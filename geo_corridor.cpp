@@ -0,0 +1,225 @@
+#define _INTERNAL_
+
+#include <math.h>
+#include <vector>
+#include "geo.h"
+
+#ifdef __cplusplus
+namespace geo {
+#endif
+
+// Each leg of the route becomes an external contour of the region: port offset line forward, end cap around
+// the end waypoint, starboard offset line backward and begin cap around the begin waypoint. The union of the
+// leg contours gives arc joins on the outer side of every turn. Contours are clockwise.
+struct CorridorLeg {
+    Pos begin, end;
+    double range, bearing, portXte, stbdXte;
+    size_t steps, capPoints, first, count;
+    int contour;
+};
+
+// Points of the cap made of two quarter arcs; the first quarter excludes its begin bearing, the second one
+// excludes its end bearing, the forward point is doubled only when radiuses are different
+static size_t calcCapPointCount (size_t quarterPoints, double radius1, double radius2) {
+    return (quarterPoints - 1) + (quarterPoints - 2) + (isSame (radius1, radius2) ? 0 : 1);
+}
+
+static bool prepareCorridorLegs (
+    bool useWgs84,
+    Method method,
+    Pos *route,
+    size_t pointCount,
+    const double *portXte,
+    const double *stbdXte,
+    double stepDistance,
+    double angleStep,
+    std::vector <CorridorLeg>& legs
+) {
+    auto quarterPoints = calcArcPointCount (HALF_PI, angleStep, true);
+
+    legs.clear ();
+
+    if (!route || !portXte || !stbdXte || pointCount < 2 || quarterPoints < 2 || invalidVal (stepDistance) || stepDistance <= 0.0) return false;
+
+    size_t first = 0;
+
+    for (size_t i = 0; i + 1 < pointCount; ++ i) {
+        CorridorLeg leg;
+
+        leg.begin = route [i];
+        leg.end = route [i + 1];
+        leg.portXte = portXte [i];
+        leg.stbdXte = stbdXte [i];
+
+        if (invalidVal (leg.portXte) || invalidVal (leg.stbdXte) || leg.portXte <= 0.0 || leg.stbdXte <= 0.0) return false;
+
+        Pos begin = leg.begin, end = leg.end;
+        bool result = method == GREAT_CIRCLE ?
+                      calcGreatCircleDistAndBrg (useWgs84, & begin, & end, & leg.range, & leg.bearing, 0) :
+                      calcRhumblineDistAndBrg (useWgs84, & begin, & end, & leg.range, & leg.bearing);
+
+        if (!result) return false;
+
+        // Collapsed legs are covered by caps of the neighbours
+        if (leg.range < DEFPRECISION) continue;
+
+        leg.steps = (size_t) ceil (leg.range / stepDistance);
+        leg.capPoints = quarterPoints;
+        leg.first = first;
+        leg.contour = (int) legs.size ();
+        leg.count = (leg.steps + 1) * 2 + calcCapPointCount (quarterPoints, leg.portXte, leg.stbdXte) + calcCapPointCount (quarterPoints, leg.stbdXte, leg.portXte);
+
+        first += leg.count;
+
+        legs.push_back (leg);
+    }
+
+    return true;
+}
+
+static bool buildCap (bool useWgs84, Pos *center, double begBearing, double radius1, double radius2, size_t quarterPoints, Pos *output) {
+    auto count = calcCapPointCount (quarterPoints, radius1, radius2);
+    auto angleStep = HALF_PI / (double) (quarterPoints - 1);
+    std::vector <double> ranges (count), bearings (count), lat (count), lon (count);
+    PosBatch points { lat.data (), lon.data (), count, 0 };
+    size_t i = 0;
+
+    for (size_t j = 1; j < quarterPoints; ++ j, ++ i) {
+        ranges [i] = radius1;
+        bearings [i] = begBearing + angleStep * (double) j;
+    }
+
+    if (isNotSame (radius1, radius2)) {
+        ranges [i] = radius2;
+        bearings [i ++] = begBearing + HALF_PI;
+    }
+
+    for (size_t j = 1; j + 1 < quarterPoints; ++ j, ++ i) {
+        ranges [i] = radius2;
+        bearings [i] = begBearing + HALF_PI + angleStep * (double) j;
+    }
+
+    for (i = 0; i < count; ++ i) normalizeAngle (bearings.data () + i);
+
+    bool result = calcGreatCirclePosBatch (useWgs84, center, ranges.data (), bearings.data (), count, & points, 0);
+
+    for (i = 0; i < count; ++ i) {
+        output [i].lat = lat [i];
+        output [i].lon = lon [i];
+    }
+
+    return result;
+}
+
+static bool buildCorridorLeg (bool useWgs84, Method method, CorridorLeg *leg, Pos *output) {
+    auto sampleCount = leg->steps + 1;
+    std::vector <double> ranges (sampleCount), bearings (sampleCount, leg->bearing), localBearings (sampleCount, leg->bearing), lat (sampleCount), lon (sampleCount);
+    PosBatch samples { lat.data (), lon.data (), sampleCount, 0 };
+    Pos origin = leg->begin;
+    bool result;
+
+    for (size_t i = 0; i < sampleCount; ++ i) ranges [i] = leg->range * (double) i / (double) leg->steps;
+
+    // Sample points along the leg together with the local track direction
+    if (method == GREAT_CIRCLE)
+        result = calcGreatCirclePosBatch (useWgs84, & origin, ranges.data (), bearings.data (), sampleCount, & samples, localBearings.data ());
+    else
+        result = calcRhumblinePosBatch (useWgs84, & origin, ranges.data (), bearings.data (), sampleCount, & samples);
+
+    lat [0] = leg->begin.lat;
+    lon [0] = leg->begin.lon;
+    lat [leg->steps] = leg->end.lat;
+    lon [leg->steps] = leg->end.lon;
+
+    size_t index = 0;
+
+    // Port side forward
+    for (size_t i = 0; i < sampleCount; ++ i) {
+        Pos point { lat [i], lon [i] };
+        auto bearing = localBearings [i] - HALF_PI;
+
+        normalizeAngle (& bearing);
+
+        result = calcGreatCirclePos (useWgs84, & point, leg->portXte, bearing, output + index ++, 0) && result;
+    }
+
+    // End cap from port to starboard over the track extension
+    Pos end = leg->end;
+    auto endBearing = localBearings [leg->steps] - HALF_PI;
+
+    normalizeAngle (& endBearing);
+
+    result = buildCap (useWgs84, & end, endBearing, leg->portXte, leg->stbdXte, leg->capPoints, output + index) && result;
+    index += calcCapPointCount (leg->capPoints, leg->portXte, leg->stbdXte);
+
+    // Starboard side backward
+    for (size_t i = sampleCount; i > 0; -- i) {
+        Pos point { lat [i - 1], lon [i - 1] };
+        auto bearing = localBearings [i - 1] + HALF_PI;
+
+        normalizeAngle (& bearing);
+
+        result = calcGreatCirclePos (useWgs84, & point, leg->stbdXte, bearing, output + index ++, 0) && result;
+    }
+
+    // Begin cap from starboard to port behind the begin waypoint
+    Pos begin = leg->begin;
+    auto begBearing = localBearings [0] + HALF_PI;
+
+    normalizeAngle (& begBearing);
+
+    result = buildCap (useWgs84, & begin, begBearing, leg->stbdXte, leg->portXte, leg->capPoints, output + index) && result;
+
+    return result;
+}
+
+bool calcRouteCorridorSize (bool useWgs84, Method method, Pos *route, size_t pointCount, const double *portXte, const double *stbdXte,
+                            double stepDistance, double angleStep, size_t *contourCount, size_t *vertexCount) {
+    std::vector <CorridorLeg> legs;
+
+    if (contourCount) *contourCount = 0;
+    if (vertexCount) *vertexCount = 0;
+
+    if (!prepareCorridorLegs (useWgs84, method, route, pointCount, portXte, stbdXte, stepDistance, angleStep, legs)) return false;
+
+    if (contourCount) *contourCount = legs.size ();
+    if (vertexCount) *vertexCount = legs.empty () ? 0 : legs.back ().first + legs.back ().count;
+
+    return true;
+}
+
+// Builds the corridor around the route as the region with one external contour per leg; stepDistance (miles)
+// limits the distance between offset points along the leg, angleStep limits the angle between cap points
+bool buildRouteCorridor (bool useWgs84, Method method, Pos *route, size_t pointCount, const double *portXte, const double *stbdXte,
+                         double stepDistance, double angleStep, RegionBuffer *corridor) {
+    std::vector <CorridorLeg> legs;
+
+    if (!corridor) return false;
+
+    corridor->extContourCount = corridor->intContourCount = 0;
+
+    if (!prepareCorridorLegs (useWgs84, method, route, pointCount, portXte, stbdXte, stepDistance, angleStep, legs)) return false;
+
+    if (legs.empty () || corridor->contourCapacity < legs.size () || corridor->vertexCapacity < legs.back ().first + legs.back ().count) return false;
+
+    auto legCount = (int) legs.size ();
+    bool result = true;
+
+    // Legs are independent so may be built concurrently
+    #pragma omp parallel for reduction(&&:result)
+    for (int i = 0; i < legCount; ++ i) {
+        auto leg = & legs [i];
+
+        corridor->contourSizes [leg->contour] = (int) leg->count;
+
+        result = buildCorridorLeg (useWgs84, method, leg, corridor->vertexes + leg->first) && result;
+    }
+
+    corridor->extContourCount = legCount;
+
+    return result;
+}
+
+#ifdef __cplusplus
+}
+#endif
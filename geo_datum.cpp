@@ -0,0 +1,210 @@
+#define _INTERNAL_
+
+#include <math.h>
+#include "geo.h"
+#include "geolanes.h"
+
+#ifdef __cplusplus
+namespace geo {
+#endif
+
+// Part of the datum table; shifts are mean values from NIMA TR8350.2, identifiers match GD_DATUM_xxx
+static const DatumShift DATUMS [] = {
+    { 1, { WGS84_EQUAT_RAD_M, WGS84_FLATTENING }, 0.0, 0.0, 0.0 },                        // WGS84
+    { 32, { 6378160.0, 1.0 / 298.25 }, -133.0, -48.0, 148.0 },                             // Australian Geodetic 1966
+    { 33, { 6378160.0, 1.0 / 298.25 }, -134.0, -48.0, 149.0 },                             // Australian Geodetic 1984
+    { 65, { 6378388.0, 1.0 / 297.0 }, -87.0, -98.0, -121.0 },                              // ED50 mean
+    { 70, { 6378388.0, 1.0 / 297.0 }, -86.0, -98.0, -119.0 },                              // European 1979 mean
+    { 133, { 6378206.4, 1.0 / 294.9786982 }, -8.0, 160.0, 176.0 },                         // NAD27 mean for CONUS
+    { 140, { 6378137.0, 1.0 / 298.257222101 }, 0.0, 0.0, 0.0 },                            // NAD83 CONUS
+    { 154, { 6377563.396, 1.0 / 299.3249646 }, 375.0, -111.0, 431.0 },                     // OSGB36 mean
+    { 173, { 6378245.0, 1.0 / 298.3 }, 28.0, -130.0, -95.0 },                              // Pulkovo 1942
+    { 200, { 6378160.0, 1.0 / 298.25 }, -57.0, 1.0, -41.0 },                               // SAD69 mean
+    { 209, { 6377397.155, 1.0 / 299.1528128 }, -148.0, 507.0, 685.0 },                     // Tokyo mean
+    { 217, { 6378135.0, 1.0 / 298.26 }, 0.0, 0.0, 4.5 },                                   // WGS72
+};
+
+// Per-datum terms calculated once for the whole batch
+struct MolodenskyTerms {
+    double a, f, e2, bByA, aByB, da, df, dx, dy, dz;
+    double daE2ByA, flatTerm;
+};
+
+static void initMolodenskyTerms (const DatumShift *datum, bool toWgs84, MolodenskyTerms *terms) {
+    auto source = toWgs84 ? datum->ellipsoid : WGS84_ELLIPSOID;
+    auto target = toWgs84 ? WGS84_ELLIPSOID : datum->ellipsoid;
+    auto sign = toWgs84 ? 1.0 : -1.0;
+
+    terms->a = source.equRadius;
+    terms->f = source.flattening;
+    terms->e2 = terms->f * 2.0 - terms->f * terms->f;
+    terms->bByA = 1.0 - terms->f;
+    terms->aByB = 1.0 / terms->bByA;
+    terms->da = target.equRadius - source.equRadius;
+    terms->df = target.flattening - source.flattening;
+    terms->dx = datum->dx * sign;
+    terms->dy = datum->dy * sign;
+    terms->dz = datum->dz * sign;
+    terms->daE2ByA = terms->da * terms->e2 / terms->a;
+    terms->flatTerm = terms->a * terms->df + terms->f * terms->da;
+}
+
+// Shifts of the points given by sin/cos of latitude and longitude; height and deltaHeight may be null
+template <typename Lane, bool Abridged> static inline void calcMolodenskyShifts (const MolodenskyTerms& t, Lane sinLat, Lane cosLat, Lane sinLon,
+                                                                                 Lane cosLon, const double *height, double *deltaLat, double *deltaLon,
+                                                                                 double *deltaHeight) {
+    auto one = laneSplat <Lane> (1.0);
+    auto dx = laneSplat <Lane> (t.dx), dy = laneSplat <Lane> (t.dy), dz = laneSplat <Lane> (t.dz);
+    auto sinLat2 = laneMul (sinLat, sinLat);
+    auto sinCos = laneMul (sinLat, cosLat);
+    auto w2 = laneSub (one, laneMul (laneSplat <Lane> (t.e2), sinLat2));
+    auto w = laneSqrt (w2);
+    auto invW = laneDiv (one, w);
+    auto rn = laneMul (laneSplat <Lane> (t.a), invW);
+    auto rm = laneMul (laneMul (rn, laneSplat <Lane> (1.0 - t.e2)), laneMul (invW, invW));
+    auto shiftAlong = laneMulAdd (dx, cosLon, laneMul (dy, sinLon));                // shift along the meridian plane
+    auto shiftAcross = laneSub (laneMul (dy, cosLon), laneMul (dx, sinLon));
+    auto latNum = laneSub (laneMul (dz, cosLat), laneMul (sinLat, shiftAlong));
+    auto heightNum = laneMulAdd (cosLat, shiftAlong, laneMul (dz, sinLat));
+    Lane latDenom, lonDenom;
+
+    if (Abridged) {
+        auto flatTerm = laneSplat <Lane> (t.flatTerm);
+
+        latNum = laneMulAdd (laneMul (flatTerm, laneSplat <Lane> (2.0)), sinCos, latNum);
+        heightNum = laneSub (laneMulAdd (flatTerm, sinLat2, heightNum), laneSplat <Lane> (t.da));
+        latDenom = rm;
+        lonDenom = laneMul (rn, cosLat);
+    } else {
+        auto h = height ? laneLoad <Lane> (height) : laneSplat <Lane> (0.0);
+        auto df = laneSplat <Lane> (t.df);
+        auto radiusTerm = laneMulAdd (rm, laneSplat <Lane> (t.aByB), laneMul (rn, laneSplat <Lane> (t.bByA)));
+
+        latNum = laneMulAdd (laneMulAdd (laneSplat <Lane> (t.daE2ByA), rn, laneMul (df, radiusTerm)), sinCos, latNum);
+        heightNum = laneMulAdd (laneMul (laneMul (df, laneSplat <Lane> (t.bByA)), rn), sinLat2,
+                                laneSub (heightNum, laneMul (laneSplat <Lane> (t.da), w)));           // da a / rn
+        latDenom = laneAdd (rm, h);
+        lonDenom = laneMul (laneAdd (rn, h), cosLat);
+    }
+
+    laneStore (deltaLat, laneDiv (latNum, latDenom));
+    laneStore (deltaLon, laneDiv (shiftAcross, lonDenom));
+
+    if (deltaHeight) laneStore (deltaHeight, heightNum);
+}
+
+// Reference path by the library sin/cos for any argument
+template <bool Abridged> static void calcMolodenskyExact (const MolodenskyTerms& t, const double *lat, const double *lon, const double *height, size_t count,
+                                                          double *deltaLat, double *deltaLon, double *deltaHeight) {
+    for (size_t i = 0; i < count; ++ i)
+        calcMolodenskyShifts <double, Abridged> (t, sin (lat [i]), cos (lat [i]), sin (lon [i]), cos (lon [i]), height ? height + i : 0, deltaLat + i,
+                                                 deltaLon + i, deltaHeight ? deltaHeight + i : 0);
+}
+
+// sin/cos by the minimax polynomials for |lat| <= PI/2 and |lon| <= PI (the longitude by its half angle); false if any
+// lane is out of the range, nothing is stored then
+template <typename Lane, bool Abridged> static inline bool calcMolodenskyLanes (const MolodenskyTerms& t, const double *lat, const double *lon,
+                                                                                const double *height, double *deltaLat, double *deltaLon,
+                                                                                double *deltaHeight) {
+    auto latVal = laneLoad <Lane> (lat);
+    auto lonVal = laneLoad <Lane> (lon);
+    auto valid = laneAnd (laneLessEqual (laneAbs (latVal), laneSplat <Lane> (HALF_PI)), laneLessEqual (laneAbs (lonVal), laneSplat <Lane> (PI)));
+
+    if (!laneAll (valid)) return false;
+
+    Lane sinLat, cosLat, sinHalfLon, cosHalfLon;
+
+    calcFastSinCos (latVal, & sinLat, & cosLat);
+    calcFastSinCos (laneMul (lonVal, laneSplat <Lane> (0.5)), & sinHalfLon, & cosHalfLon);
+
+    auto sinLon = laneMul (laneAdd (sinHalfLon, sinHalfLon), cosHalfLon);
+    auto cosLon = laneSub (laneSplat <Lane> (1.0), laneMul (laneAdd (sinHalfLon, sinHalfLon), sinHalfLon));
+
+    calcMolodenskyShifts <Lane, Abridged> (t, sinLat, cosLat, sinLon, cosLon, height, deltaLat, deltaLon, deltaHeight);
+
+    return true;
+}
+
+// Lane groups with any point out of the polynomial range (or NaN) take the reference path
+template <bool Abridged> static void calcMolodensky (const MolodenskyTerms& t, const double *lat, const double *lon, const double *height, size_t count,
+                                                     double *deltaLat, double *deltaLon, double *deltaHeight) {
+    size_t i = 0;
+
+#ifdef _USE_AVX2_
+    for (; i + 4 <= count; i += 4) {
+        if (!calcMolodenskyLanes <__m256d, Abridged> (t, lat + i, lon + i, height ? height + i : 0, deltaLat + i, deltaLon + i, deltaHeight ? deltaHeight + i : 0))
+            calcMolodenskyExact <Abridged> (t, lat + i, lon + i, height ? height + i : 0, 4, deltaLat + i, deltaLon + i, deltaHeight ? deltaHeight + i : 0);
+    }
+#endif
+#ifdef _USE_SSE2_
+    for (; i + 2 <= count; i += 2) {
+        if (!calcMolodenskyLanes <__m128d, Abridged> (t, lat + i, lon + i, height ? height + i : 0, deltaLat + i, deltaLon + i, deltaHeight ? deltaHeight + i : 0))
+            calcMolodenskyExact <Abridged> (t, lat + i, lon + i, height ? height + i : 0, 2, deltaLat + i, deltaLon + i, deltaHeight ? deltaHeight + i : 0);
+    }
+#endif
+    for (; i < count; ++ i) {
+        if (!calcMolodenskyLanes <double, Abridged> (t, lat + i, lon + i, height ? height + i : 0, deltaLat + i, deltaLon + i, deltaHeight ? deltaHeight + i : 0))
+            calcMolodenskyExact <Abridged> (t, lat + i, lon + i, height ? height + i : 0, 1, deltaLat + i, deltaLon + i, deltaHeight ? deltaHeight + i : 0);
+    }
+}
+
+const DatumShift *findDatum (int datumId) {
+    for (size_t i = 0; i < sizeof (DATUMS) / sizeof (*DATUMS); ++ i) {
+        if (DATUMS [i].datumId == datumId) return DATUMS + i;
+    }
+
+    return 0;
+}
+
+// Calculates latitude/longitude (radians) and height (meters) shifts of the points from the datum to WGS84
+// or vice versa; height and deltaHeight are optional
+bool calcDatumShifts (const DatumShift *datum, DatumShiftMethod method, bool toWgs84, const double *lat, const double *lon, const double *height,
+                      size_t count, double *deltaLat, double *deltaLon, double *deltaHeight) {
+    if (!datum || !lat || !lon || !deltaLat || !deltaLon) return false;
+
+    MolodenskyTerms terms;
+
+    initMolodenskyTerms (datum, toWgs84, & terms);
+
+    if (method == MOLODENSKY_ABRIDGED)
+        calcMolodensky <true> (terms, lat, lon, 0, count, deltaLat, deltaLon, deltaHeight);
+    else
+        calcMolodensky <false> (terms, lat, lon, height, count, deltaLat, deltaLon, deltaHeight);
+
+    return true;
+}
+
+// Converts the points in place; height is optional and is converted in place too
+bool convertDatum (const DatumShift *datum, DatumShiftMethod method, bool toWgs84, PosBatch *points, double *height) {
+    static const size_t CHUNK_SIZE = 256;
+
+    if (!datum || !points) return false;
+
+    double deltaLat [CHUNK_SIZE], deltaLon [CHUNK_SIZE], deltaHeight [CHUNK_SIZE];
+
+    for (size_t first = 0; first < points->count; first += CHUNK_SIZE) {
+        auto count = points->count - first < CHUNK_SIZE ? points->count - first : CHUNK_SIZE;
+        auto lat = points->lat + first;
+        auto lon = points->lon + first;
+        auto h = height ? height + first : 0;
+
+        calcDatumShifts (datum, method, toWgs84, lat, lon, h, count, deltaLat, deltaLon, h ? deltaHeight : 0);
+
+        for (size_t i = 0; i < count; ++ i) {
+            lat [i] += deltaLat [i];
+            lon [i] += deltaLon [i];
+
+            normalizeLon (lon + i);
+        }
+
+        if (h) {
+            for (size_t i = 0; i < count; ++ i) h [i] += deltaHeight [i];
+        }
+    }
+
+    return true;
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,167 @@
+#define _INTERNAL_
+
+#include <math.h>
+#include "geo.h"
+
+#ifdef __cplusplus
+namespace geo {
+#endif
+
+static const double RAD_IN_ARC_SECOND = RAD_IN_DEG / 3600.0;
+
+// Ellipsoid terms calculated once for the whole batch
+struct EcefTerms {
+    double a, e2, e4, oneMinusE2, invA2;
+};
+
+struct HelmertTerms {
+    double tx, ty, tz, rx, ry, rz, scale;
+};
+
+static void initEcefTerms (const Ellipsoid *ellipsoid, EcefTerms *terms) {
+    auto el = ellipsoid ? *ellipsoid : WGS84_ELLIPSOID;
+
+    terms->a = el.equRadius;
+    terms->e2 = el.flattening * 2.0 - el.flattening * el.flattening;
+    terms->e4 = terms->e2 * terms->e2;
+    terms->oneMinusE2 = 1.0 - terms->e2;
+    terms->invA2 = 1.0 / (el.equRadius * el.equRadius);
+}
+
+static void initHelmertTerms (const HelmertParams *params, HelmertTerms *terms) {
+    terms->tx = params->tx;
+    terms->ty = params->ty;
+    terms->tz = params->tz;
+    terms->rx = params->rx * RAD_IN_ARC_SECOND;
+    terms->ry = params->ry * RAD_IN_ARC_SECOND;
+    terms->rz = params->rz * RAD_IN_ARC_SECOND;
+    terms->scale = 1.0 + params->scale * 1.0e-6;
+}
+
+static inline void toEcef (const EcefTerms& t, double lat, double lon, double h, double *x, double *y, double *z) {
+    auto sinLat = sin (lat), cosLat = cos (lat);
+    auto rn = t.a / sqrt (1.0 - t.e2 * sinLat * sinLat);
+
+    *x = (rn + h) * cosLat * cos (lon);
+    *y = (rn + h) * cosLat * sin (lon);
+    *z = (rn * t.oneMinusE2 + h) * sinLat;
+}
+
+// Closed form (iteration free) inverse by Vermeille, "Direct transformation from geocentric coordinates
+// to geodetic coordinates", J.Geodesy 76 (2002); valid out of the evolute of the meridian ellipse (the few dozen
+// kilometers around the center), false with nothing stored inside it
+static inline bool fromEcef (const EcefTerms& t, double x, double y, double z, double *lat, double *lon, double *h) {
+    auto xy2 = x * x + y * y;
+    auto xy = sqrt (xy2);
+    auto p = xy2 * t.invA2;
+    auto q = t.oneMinusE2 * z * z * t.invA2;
+    auto r = (p + q - t.e4) * ONE_SIXTH;
+    auto s = t.e4 * p * q / (4.0 * r * r * r);
+
+    // The cubic has three real roots inside the evolute (-2 < s <= 0 for r < 0), the center included
+    if (!(r > 0.0 || s <= -2.0)) return false;
+
+    auto tt = cbrt (1.0 + s + sqrt (s * (2.0 + s)));
+    auto u = r * (1.0 + tt + 1.0 / tt);
+    auto v = sqrt (u * u + t.e4 * q);
+    auto w = t.e2 * (u + v - q) / (2.0 * v);
+    auto k = sqrt (u + v + w * w) - w;
+    auto d = k * xy / (k + t.e2);
+    auto dz = sqrt (d * d + z * z);
+
+    *lat = 2.0 * atan2 (z, d + dz);
+    *lon = atan2 (y, x);
+    *h = (k + t.e2 - 1.0) / k * dz;
+
+    return true;
+}
+
+static inline void applyHelmert (const HelmertTerms& t, double *x, double *y, double *z) {
+    auto x0 = *x, y0 = *y, z0 = *z;
+
+    *x = t.tx + t.scale * (x0 - t.rz * y0 + t.ry * z0);
+    *y = t.ty + t.scale * (t.rz * x0 + y0 - t.rx * z0);
+    *z = t.tz + t.scale * (- t.ry * x0 + t.rx * y0 + z0);
+}
+
+// Latitudes and longitudes are in radians, heights (optional) and ECEF coordinates are in meters
+bool geodeticToEcef (const Ellipsoid *ellipsoid, const double *lat, const double *lon, const double *height, size_t count, double *x, double *y, double *z) {
+    if (!lat || !lon || !x || !y || !z) return false;
+
+    EcefTerms terms;
+
+    initEcefTerms (ellipsoid, & terms);
+
+    for (size_t i = 0; i < count; ++ i) toEcef (terms, lat [i], lon [i], height ? height [i] : 0.0, x + i, y + i, z + i);
+
+    return true;
+}
+
+bool ecefToGeodetic (const Ellipsoid *ellipsoid, const double *x, const double *y, const double *z, size_t count, double *lat, double *lon, double *height) {
+    if (!x || !y || !z || !lat || !lon) return false;
+
+    EcefTerms terms;
+    auto result = true;
+
+    initEcefTerms (ellipsoid, & terms);
+
+    for (size_t i = 0; i < count; ++ i) {
+        double h = 0.0;
+
+        if (!fromEcef (terms, x [i], y [i], z [i], lat + i, lon + i, & h)) {
+            lat [i] = lon [i] = 0.0;
+            result = false;
+        }
+
+        if (height) height [i] = h;
+    }
+
+    return result;
+}
+
+bool transformHelmert (const HelmertParams *params, size_t count, double *x, double *y, double *z) {
+    if (!params || !x || !y || !z) return false;
+
+    HelmertTerms terms;
+
+    initHelmertTerms (params, & terms);
+
+    for (size_t i = 0; i < count; ++ i) applyHelmert (terms, x + i, y + i, z + i);
+
+    return true;
+}
+
+// Fused geodetic -> ECEF -> Helmert -> geodetic pipeline converting the points in place; intermediate
+// ECEF coordinates never leave registers. Height is optional and is converted in place too
+bool convertHelmert (const Ellipsoid *source, const Ellipsoid *target, const HelmertParams *params, PosBatch *points, double *height) {
+    if (!params || !points) return false;
+
+    EcefTerms sourceTerms, targetTerms;
+    HelmertTerms helmertTerms;
+
+    initEcefTerms (source, & sourceTerms);
+    initEcefTerms (target, & targetTerms);
+    initHelmertTerms (params, & helmertTerms);
+
+    auto result = true;
+
+    for (size_t i = 0; i < points->count; ++ i) {
+        double x, y, z, h = height ? height [i] : 0.0;
+
+        toEcef (sourceTerms, points->lat [i], points->lon [i], h, & x, & y, & z);
+        applyHelmert (helmertTerms, & x, & y, & z);
+
+        if (!fromEcef (targetTerms, x, y, z, points->lat + i, points->lon + i, & h)) {
+            points->lat [i] = points->lon [i] = h = 0.0;
+            result = false;
+        }
+
+        if (height) height [i] = h;
+    }
+
+    return result;
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,534 @@
+#define _INTERNAL_
+
+#include <string.h>
+#include "geo.h"
+
+#ifdef __cplusplus
+namespace geo {
+#endif
+
+static const unsigned char NO_FIELD = 0xff;
+static const size_t MAX_FRACTION_DIGITS = 9;
+static const size_t MAX_MANTISSA_DIGITS = 18;
+
+static const double POWERS_OF_TEN [] = {
+    1.0e0, 1.0e1, 1.0e2, 1.0e3, 1.0e4, 1.0e5, 1.0e6, 1.0e7, 1.0e8, 1.0e9,
+    1.0e10, 1.0e11, 1.0e12, 1.0e13, 1.0e14, 1.0e15, 1.0e16, 1.0e17, 1.0e18,
+};
+
+// Last number group in degrees, minutes or seconds
+static const double GROUP_UNITS [] = { 1.0, 60.0, 3600.0 };
+
+static const char DIGIT_PAIRS [] =
+    "00010203040506070809101112131415161718192021222324"
+    "25262728293031323334353637383940414243444546474849"
+    "50515253545556575859606162636465666768697071727374"
+    "75767778798081828384858687888990919293949596979899";
+
+static const unsigned long long ASCII_ZEROS = 0x3030303030303030ull;
+
+// Writes the value as count digits ending right before the end pointer, two at a time; false if the value does not fit
+static inline bool writeDigits (char *end, unsigned char count, unsigned long long value) {
+    for (; count >= 2; count -= 2) {
+        end -= 2;
+        memcpy (end, DIGIT_PAIRS + value % 100 * 2, 2);
+        value /= 100;
+    }
+
+    if (count) {
+        *(-- end) = (char) ('0' + value % 10);
+        value /= 10;
+    }
+
+    return value == 0;
+}
+
+// Converts count (1..8) digits starting at text with one 4 or 8 byte load (little endian, the first digit in the
+// lowest byte); the bytes loaded must be readable and the digits checked by the caller
+static inline unsigned long long readDigits (const char *text, unsigned char count) {
+    // Digit values ('0'..'9' xor 0x30) aligned to the high bytes with the leading ones zero, then the pairs,
+    // quads and halves combined by multiplications
+    if (count > 4) {
+        unsigned long long chunk;
+
+        memcpy (& chunk, text, sizeof (chunk));
+
+        chunk = (chunk ^ ASCII_ZEROS) << ((8 - count) * 8);
+        chunk = chunk * 10 + (chunk >> 8);
+
+        return (unsigned) ((((chunk & 0x000000ff000000ffull) * (100 + (1000000ull << 32))) + (((chunk >> 16) & 0x000000ff000000ffull) * (1 + (10000ull << 32)))) >> 32);
+    }
+
+    // The usual minutes and seconds, cheaper directly
+    if (count == 2) return (text [0] - '0') * 10u + (text [1] - '0');
+
+    unsigned chunk;
+
+    memcpy (& chunk, text, sizeof (chunk));
+
+    chunk = (chunk ^ 0x30303030u) << ((4 - count) * 8);
+    chunk = chunk * 10 + (chunk >> 8);
+
+    return (((chunk & 0x00ff00ffu) * (1 + (100u << 16))) >> 16) & 0xffff;
+}
+
+// Format characters: d - degree digit, m - minute digit, s - second digit; the digits after the point are
+// the fraction of the last unit. S - world side (N/S or E/W), _ - space, other characters are copied as is.
+// Format without the side gets the leading minus for negative values
+bool compileGeoFormat (const char *format, bool latitude, GeoFormat *compiled) {
+    if (!format || !compiled) return false;
+
+    auto length = strlen (format);
+
+    if (length == 0 || length >= GEO_FORMAT_MAX) return false;
+
+    memset (compiled, 0, sizeof (*compiled));
+
+    compiled->length = (unsigned char) length;
+    compiled->degPos = compiled->minPos = compiled->secPos = compiled->fracPos = compiled->sidePos = NO_FIELD;
+    compiled->latitude = latitude;
+    compiled->positiveSide = latitude ? 'N' : 'E';
+    compiled->negativeSide = latitude ? 'S' : 'W';
+    compiled->fracUnit = 0;
+
+    bool afterPoint = false;
+    char prevField = 0;
+
+    for (size_t i = 0; i < length; ++ i) {
+        auto chr = format [i];
+        auto pos = (unsigned char) i;
+
+        compiled->pattern [i] = chr == '_' ? ' ' : chr;
+
+        if (chr == 'd' || chr == 'm' || chr == 's') {
+            if (afterPoint) {
+                if (compiled->fracPos == NO_FIELD)
+                    compiled->fracPos = pos;
+                else if (prevField != '.')
+                    return false;
+
+                ++ compiled->fracDigits;
+                prevField = '.';
+                continue;
+            }
+
+            auto fieldPos = chr == 'd' ? & compiled->degPos : (chr == 'm' ? & compiled->minPos : & compiled->secPos);
+            auto fieldDigits = chr == 'd' ? & compiled->degDigits : (chr == 'm' ? & compiled->minDigits : & compiled->secDigits);
+
+            // Every field must be contiguous
+            if (*fieldPos == NO_FIELD)
+                *fieldPos = pos;
+            else if (prevField != chr)
+                return false;
+
+            ++ (*fieldDigits);
+            compiled->fracUnit = chr;
+            prevField = chr;
+        } else {
+            if (chr == '.') {
+                if (afterPoint || !compiled->fracUnit) return false;
+
+                afterPoint = true;
+            } else if (chr == 'S') {
+                if (compiled->sidePos != NO_FIELD) return false;
+
+                compiled->sidePos = pos;
+            }
+
+            prevField = 0;
+        }
+    }
+
+    if (compiled->degPos == NO_FIELD || (compiled->secPos != NO_FIELD && compiled->minPos == NO_FIELD) || compiled->fracDigits > MAX_FRACTION_DIGITS)
+        return false;
+
+    compiled->fracScale = (unsigned long long) POWERS_OF_TEN [compiled->fracDigits];
+    compiled->fracInverse = 1.0 / POWERS_OF_TEN [compiled->fracDigits];
+    compiled->unitsPerDegree = (compiled->fracUnit == 's' ? 3600.0 : (compiled->fracUnit == 'm' ? 60.0 : 1.0)) * (double) compiled->fracScale;
+    compiled->degreesPerUnit = 1.0 / compiled->unitsPerDegree;
+
+    // The fixed layout parser compares the pattern a word at a time, checks the terminator and loads 4 or 8 bytes at
+    // every digit field; fields longer than one load leave it off (span zero)
+    size_t span = (length + 8) & ~(size_t) 7;
+
+    for (size_t i = 0; i < length; ++ i) {
+        auto chr = format [i];
+
+        if (chr == 'd' || chr == 'm' || chr == 's')
+            compiled->digitMask [i / 8] |= 0x80ull << (i % 8 * 8);
+        else if (i != compiled->sidePos)
+            compiled->literalMask [i / 8] |= 0xffull << (i % 8 * 8);
+    }
+
+    // The zero after the text
+    compiled->literalMask [length / 8] |= 0xffull << (length % 8 * 8);
+
+    const unsigned char fields [][2] = {
+        { compiled->degPos, compiled->degDigits }, { compiled->minPos, compiled->minDigits },
+        { compiled->secPos, compiled->secDigits }, { compiled->fracPos, compiled->fracDigits },
+    };
+
+    for (auto& field : fields) {
+        if (field [0] == NO_FIELD) continue;
+
+        if (field [1] > 8) {
+            span = 0;
+            break;
+        }
+
+        auto end = field [0] + (size_t) (field [1] > 4 ? 8 : 4);
+
+        if (end > span) span = end;
+    }
+
+    compiled->span = (unsigned char) span;
+
+    return true;
+}
+
+// Returns the length of the text written (without trailing zero) or zero if failed
+size_t formatGeoValue (const GeoFormat *format, double value, char *buffer, size_t size) {
+    if (!format || !buffer || invalidVal (value)) return 0;
+
+    auto negative = value < 0.0;
+    auto degrees = (negative ? - value : value) * DEG_IN_RAD;
+
+    if (degrees > (format->latitude ? 90.0 : 180.0)) return 0;
+
+    // Value is rounded once in the smallest unit; the rest is integer arithmetic
+    auto total = (unsigned long long) (degrees * format->unitsPerDegree + 0.5);
+
+    // Quotient by the fraction scale from the reciprocal, off by one at most before the correction
+    auto whole = (unsigned long long) ((double) total * format->fracInverse);
+    auto fraction = total - whole * format->fracScale;
+
+    if ((long long) fraction < 0) {
+        -- whole;
+        fraction += format->fracScale;
+    } else if (fraction >= format->fracScale) {
+        ++ whole;
+        fraction -= format->fracScale;
+    }
+    unsigned long long minutes = 0, seconds = 0;
+
+    if (format->fracUnit == 's') {
+        seconds = whole % 60;
+        whole /= 60;
+    }
+
+    if (format->fracUnit != 'd') {
+        minutes = whole % 60;
+        whole /= 60;
+    }
+
+    if (total == 0) negative = false;
+
+    auto prefix = negative && format->sidePos == NO_FIELD ? 1 : 0;
+    auto length = format->length + prefix;
+
+    if (size < (size_t) length + 1) return 0;
+
+    auto text = buffer + prefix;
+
+    // Pattern copied a word at a time as far as the buffer takes it (much faster than a copy of variable length)
+    size_t copied = 0;
+
+    for (; copied < format->length && copied + 8 <= size - prefix; copied += 8)
+        memcpy (text + copied, format->pattern + copied, 8);
+
+    if (copied < format->length) memcpy (text + copied, format->pattern + copied, format->length - copied);
+
+    if (prefix) buffer [0] = '-';
+
+    if (!writeDigits (text + format->degPos + format->degDigits, format->degDigits, whole)) return 0;
+
+    if (format->minPos != NO_FIELD) writeDigits (text + format->minPos + format->minDigits, format->minDigits, minutes);
+    if (format->secPos != NO_FIELD) writeDigits (text + format->secPos + format->secDigits, format->secDigits, seconds);
+    if (format->fracPos != NO_FIELD) writeDigits (text + format->fracPos + format->fracDigits, format->fracDigits, fraction);
+    if (format->sidePos != NO_FIELD) text [format->sidePos] = negative ? format->negativeSide : format->positiveSide;
+
+    buffer [length] = '\0';
+
+    return length;
+}
+
+// Values are written one by one into records of stride bytes each (zero terminated)
+bool formatGeoValues (const GeoFormat *format, const double *values, size_t count, char *buffer, size_t stride) {
+    if (!format || !values || !buffer) return false;
+
+    bool result = true;
+
+    for (size_t i = 0; i < count; ++ i, buffer += stride) {
+        if (!formatGeoValue (format, values [i], buffer, stride)) {
+            if (stride > 0) buffer [0] = '\0';
+
+            result = false;
+        }
+    }
+
+    return result;
+}
+
+// Accepts decimal degrees ("-12.5") as well as degrees, minutes and seconds in any of the formats above
+// ("12 30.000N", "012 30 15.5W"); up to three number groups, only the last one may have a fraction
+bool parseGeoValue (const char *text, size_t length, bool latitude, double *value) {
+    if (!text || !value) return false;
+
+    // Groups before the last one are whole numbers kept in the unit of the last one
+    double whole = 0.0;
+    unsigned long long mantissa = 0;
+    size_t groupCount = 0, digits = 0, fracDigits = 0;
+    bool inGroup = false, afterPoint = false, fractionSeen = false, negative = false, signSeen = false, sideSeen = false;
+
+    for (size_t i = 0; ; ++ i) {
+        auto chr = i < length ? text [i] : '\0';
+        auto digit = (unsigned) (unsigned char) chr - (unsigned) '0';
+
+        if (digit < 10) {
+            if (!inGroup) {
+                if (groupCount >= 3 || fractionSeen || sideSeen) return false;
+
+                inGroup = true;
+                whole = (whole + (double) mantissa) * 60.0;
+                mantissa = digits = 0;
+            }
+
+            if (++ digits > MAX_MANTISSA_DIGITS) return false;
+
+            mantissa = mantissa * 10 + digit;
+            fracDigits += afterPoint;
+
+            continue;
+        }
+
+        if (chr == '.') {
+            if (afterPoint || fractionSeen || sideSeen || (!inGroup && groupCount >= 3)) return false;
+
+            if (!inGroup) {
+                inGroup = true;
+                whole = (whole + (double) mantissa) * 60.0;
+                mantissa = digits = 0;
+            }
+
+            afterPoint = true;
+            continue;
+        }
+
+        // Any other character closes the current group
+        if (inGroup) {
+            if (digits == 0 || (groupCount > 0 && (double) mantissa >= 60.0 * POWERS_OF_TEN [fracDigits])) return false;
+
+            ++ groupCount;
+            fractionSeen = afterPoint;
+            inGroup = afterPoint = false;
+        }
+
+        if (chr == '\0') break;
+
+        switch (chr) {
+            case '-':
+            case '+':
+                if (signSeen || sideSeen || groupCount > 0) return false;
+
+                signSeen = true;
+                negative = chr == '-';
+                break;
+
+            case 'N': case 'n': case 'S': case 's':
+            case 'E': case 'e': case 'W': case 'w': {
+                auto upper = (char) (chr & ~0x20);
+
+                if (sideSeen || signSeen || groupCount == 0 || latitude != (upper == 'N' || upper == 'S')) return false;
+
+                sideSeen = true;
+                negative = upper == 'S' || upper == 'W';
+                break;
+            }
+
+            case ' ': case '_': case '\t': case ':': case '\'': case '"':
+                break;
+
+            default:
+                // Degree sign (Latin-1 or UTF-8)
+                if ((unsigned char) chr != 0xb0 && (unsigned char) chr != 0xc2) return false;
+        }
+    }
+
+    if (groupCount == 0) return false;
+
+    // Single rounding: the whole groups and the last one in its fraction unit, divided once
+    auto scale = POWERS_OF_TEN [fracDigits];
+    auto degrees = (whole * scale + (double) mantissa) / (GROUP_UNITS [groupCount - 1] * scale);
+
+    if (degrees > (latitude ? 90.0 : 180.0)) return false;
+
+    *value = (negative ? - degrees : degrees) * RAD_IN_DEG;
+
+    return true;
+}
+
+// Records of stride bytes each, zero terminated or taking the whole record; failed values are set to zero
+bool parseGeoValues (const char *buffer, size_t stride, size_t count, bool latitude, double *values) {
+    if (!buffer || !values) return false;
+
+    bool result = true;
+
+    for (size_t i = 0; i < count; ++ i, buffer += stride) {
+        if (!parseGeoValue (buffer, stride, latitude, values + i)) {
+            values [i] = 0.0;
+            result = false;
+        }
+    }
+
+    return result;
+}
+
+// Records laid out exactly as formatGeoValue writes them, readable for the span after the optional minus: pattern
+// compared and digits checked a word at a time, digit fields converted by readDigits at their compiled positions.
+// The field shape is in the template flags and the checks are combined into one test, so the record loop has no
+// branches on either. Values are within an ulp of parseGeoValue; records off the layout are parsed by it
+template <bool Minutes, bool Seconds, bool Fraction, bool Side> static bool parseFixedLayouts (const GeoFormat *format, const char *buffer, size_t stride,
+                                                                                           size_t count, double *values) {
+    // Sign from a table, a branch on it is mispredicted for mixed hemispheres
+    static const double SIGNED_RAD_IN_DEG [] = { RAD_IN_DEG, - RAD_IN_DEG };
+
+    // Local copy, the values written cannot alias it so its fields are not reloaded for every record
+    auto layout = *format;
+    auto limit = layout.latitude ? 90.0 : 180.0;
+    bool result = true;
+
+    for (size_t i = 0; i < count; ++ i, buffer += stride) {
+        auto prefix = (size_t) (!Side && buffer [0] == '-');
+        auto body = buffer + prefix;
+
+        // A digit byte xor '0' is 0..9, so neither it nor its sum with 0x76 has the high bit; the mask of the literals
+        // includes the terminator
+        unsigned long long differ = 0;
+
+        for (size_t j = 0; j <= layout.length; j += 8) {
+            unsigned long long word, pattern;
+
+            memcpy (& word, body + j, sizeof (word));
+            memcpy (& pattern, layout.pattern + j, sizeof (pattern));
+
+            auto digits = word ^ ASCII_ZEROS;
+
+            differ |= ((word ^ pattern) & layout.literalMask [j / 8]) | (((digits + 0x7676767676767676ull) | digits) & layout.digitMask [j / 8]);
+        }
+
+        auto whole = readDigits (body + layout.degPos, layout.degDigits);
+        auto invalid = (differ != 0) | (whole > 180);
+        unsigned long long fraction = 0;
+        auto negative = prefix != 0;
+
+        if (Minutes) {
+            auto minutes = readDigits (body + layout.minPos, layout.minDigits);
+
+            invalid |= minutes >= 60;
+            whole = whole * 60 + minutes;
+        }
+
+        if (Seconds) {
+            auto seconds = readDigits (body + layout.secPos, layout.secDigits);
+
+            invalid |= seconds >= 60;
+            whole = whole * 60 + seconds;
+        }
+
+        if (Fraction) fraction = readDigits (body + layout.fracPos, layout.fracDigits);
+
+        if (Side) {
+            auto side = body [layout.sidePos];
+
+            invalid |= (side != layout.positiveSide) & (side != layout.negativeSide);
+            negative = side == layout.negativeSide;
+        }
+
+        // Whole groups and the fraction are one exact integer in the smallest unit, scaled once
+        auto degrees = (double) (long long) (whole * layout.fracScale + fraction) * layout.degreesPerUnit;
+
+        if (!(invalid | (degrees > limit)))
+            values [i] = degrees * SIGNED_RAD_IN_DEG [negative];
+        else if (!parseGeoValue (buffer, stride, layout.latitude, values + i)) {
+            values [i] = 0.0;
+            result = false;
+        }
+    }
+
+    return result;
+}
+
+typedef bool (*FixedLayoutParser) (const GeoFormat *format, const char *buffer, size_t stride, size_t count, double *values);
+
+// By minutes, seconds, fraction and side; no format has seconds without minutes
+static const FixedLayoutParser FIXED_LAYOUT_PARSERS [2][2][2][2] = {
+    {
+        { { parseFixedLayouts <false, false, false, false>, parseFixedLayouts <false, false, false, true> },
+          { parseFixedLayouts <false, false, true, false>, parseFixedLayouts <false, false, true, true> } },
+        { { 0, 0 }, { 0, 0 } },
+    },
+    {
+        { { parseFixedLayouts <true, false, false, false>, parseFixedLayouts <true, false, false, true> },
+          { parseFixedLayouts <true, false, true, false>, parseFixedLayouts <true, false, true, true> } },
+        { { parseFixedLayouts <true, true, false, false>, parseFixedLayouts <true, true, false, true> },
+          { parseFixedLayouts <true, true, true, false>, parseFixedLayouts <true, true, true, true> } },
+    },
+};
+
+static inline FixedLayoutParser findFixedLayoutParser (const GeoFormat *format) {
+    return FIXED_LAYOUT_PARSERS [format->minPos != NO_FIELD] [format->secPos != NO_FIELD] [format->fracPos != NO_FIELD] [format->sidePos != NO_FIELD];
+}
+
+// Text written by formatGeoValue with the same format takes the fixed layout path, anything else parseGeoValue
+bool parseFormattedGeoValue (const GeoFormat *format, const char *text, size_t length, double *value) {
+    if (!format || !text || !value) return false;
+
+    if (!format->span) return parseGeoValue (text, length, format->latitude, value);
+
+    // Read in place when the text covers the span and the minus of a format without the side, otherwise from a zero
+    // padded copy; nothing is stored if the text is refused
+    char record [GEO_FORMAT_MAX + 16];
+    auto source = text;
+    double parsed;
+
+    if (length < format->span + (format->sidePos == NO_FIELD)) {
+        memset (record, 0, sizeof (record));
+        memcpy (record, text, length);
+        source = record;
+    }
+
+    if (!findFixedLayoutParser (format) (format, source, length, 1, & parsed)) return false;
+
+    *value = parsed;
+
+    return true;
+}
+
+// Records as written by formatGeoValues; failed values are set to zero
+bool parseFormattedGeoValues (const GeoFormat *format, const char *buffer, size_t stride, size_t count, double *values) {
+    if (!format || !buffer || !values) return false;
+
+    // Records covering the span are read in place; the minus of a format without the side may take the read into the
+    // next record, so the last one goes through the copy then as do all the records shorter than the span
+    size_t inPlace = 0;
+
+    if (format->span && stride >= format->span && count > 0)
+        inPlace = stride >= format->span + (format->sidePos == NO_FIELD) ? count : count - 1;
+
+    bool result = inPlace == 0 || findFixedLayoutParser (format) (format, buffer, stride, inPlace, values);
+
+    buffer += inPlace * stride;
+
+    for (size_t i = inPlace; i < count; ++ i, buffer += stride) {
+        if (!parseFormattedGeoValue (format, buffer, stride, values + i)) {
+            values [i] = 0.0;
+            result = false;
+        }
+    }
+
+    return result;
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -1,8 +1,12 @@
 #define _INTERNAL_
 
 #include <cstdint>
+#include <limits>
 #include <math.h>
+#include <utility>
 #include "geodefs.h"
+#include "geostats.h"
+#include "geocapture.h"
 
 #ifndef __cplusplus
 #include <stdbool.h>
@@ -12,265 +16,564 @@
 namespace geo {
 #endif
 
-bool calcGreatCircleDistAndBrg (bool useWgs84, Pos *origin, Pos *dest, double *range, double *bearing, double *endBearing) {
-    if (range) *range = 0.0;
-    if (bearing) *bearing = 0.0;
-    if (endBearing) *endBearing = 0.0;
+static const int MAX_BISECTIONS = 64;
+static const int MAX_INVERSE_ITERATIONS = 100;
 
-    if (geo::invalidVal (origin->lat) || geo::invalidVal (origin->lon) || geo::invalidVal (dest->lat) || geo::invalidVal (dest->lon)
-        || fabs (origin->lat) > 10000. || fabs (origin->lon) > 10000. || fabs (dest->lat) > 10000. || fabs (dest->lon) > 10000.)
-        return false;
+// Start azimuth precision of the bisection; the range and the bearings follow to 1e-14 rad as well
+static const double AZIMUTH_PRECISION = 1.0e-14;
 
-    geo::normalizeLon (& origin->lon);
-    geo::normalizeLon (& dest->lon);
+// Points closer than this to the antipodal ones (longitude difference to PI and the latitude sum) are solved by the
+// bisection on the start azimuth right away; the auxiliary longitude equation may have the spurious roots there
+static const double ANTIPODAL_ZONE = 0.05;
 
-    if (!geo::checkSegmentRag (origin->lat, origin->lon, dest->lat, dest->lon, true, false)) return false;
+static inline void calcReducedLat (double flattening, double lat, double *sinBeta, double *cosBeta) {
+    auto sinB = (1.0 - flattening) * sin (lat), cosB = cos (lat), norm = hypot (sinB, cosB);
 
-    // If both points are the same we cannot calculate as soon begin course as end one. In this case we return zero 
-    // distance and zero course
-    if (geo::isSame (origin->lon, dest->lat) && geo::isSame (origin->lon, dest->lon)) return true;
+    *sinBeta = sinB / norm;
+    *cosBeta = fmax (cosB / norm, 1.0e-150);
+}
 
-    // Calculation block
-    // This is a translation of the Fortran routine INVER1 found in the
-    // INVERS3D program at:
-    // ftp://ftp.ngs.noaa.gov/pub/pcsoft/for_inv.3d/source/invers3d.for
+// Inverse problem by the bisection on the start azimuth (Karney, Algorithms for geodesics, 2013). Nearly antipodal
+// points have either no root of the auxiliary longitude equation (both points on the equator, the geodesic leaves it)
+// or several ones, while the azimuth gives every geodesic once. Points are arranged so that lat1 <= 0,
+// |lat2| <= |lat1| and the longitude difference is in [0, PI]; the longitude difference reached along the geodesic
+// grows with the start azimuth over [0, PI] then. Longitude and distance integrals are Vincenty's series as in INVER1.
+// End bearing is the forward azimuth at the destination, the number of the steps is returned
+static int calcGcInverseByAzimuth (const Ellipsoid& ellipsoid, double lat1, double lat2, double deltaLon, double *range, double *bearing, double *endBearing) {
+    auto flattening = ellipsoid.flattening;
+    auto lonSign = deltaLon >= 0.0 ? 1.0 : -1.0;
+    auto swapSign = fabs (lat1) < fabs (lat2) ? -1.0 : 1.0;
+
+    deltaLon *= lonSign;
+
+    if (swapSign < 0.0) {
+        lonSign = - lonSign;
+
+        std::swap (lat1, lat2);
+    }
+
+    auto latSign = lat1 < 0.0 ? 1.0 : -1.0;
+    double sinBeta1, cosBeta1, sinBeta2, cosBeta2;
+
+    calcReducedLat (flattening, lat1 * latSign, & sinBeta1, & cosBeta1);
+    calcReducedLat (flattening, lat2 * latSign, & sinBeta2, & cosBeta2);
+
+    // Same latitude magnitudes must give the exact symmetry
+    if (cosBeta1 < - sinBeta1) {
+        if (cosBeta2 == cosBeta1) sinBeta2 = copysign (sinBeta1, sinBeta2);
+    } else if (fabs (sinBeta2) == - sinBeta1) {
+        cosBeta2 = cosBeta1;
+    }
+
+    auto sinLon = sin (deltaLon), cosLon = cos (deltaLon);
+    double sinAlpha1, cosAlpha1, sinAlpha2, cosAlpha2, sinAlpha0, cosAlpha0, sigma, cos2SigmaM;
+
+    // Longitude difference reached along the geodesic less the given one; the arcs sigma and omega are measured on
+    // the auxiliary sphere from the equator crossing
+    auto evaluate = [&] (double alpha1) {
+        sinAlpha1 = sin (alpha1);
+        cosAlpha1 = cos (alpha1);
+        sinAlpha0 = sinAlpha1 * cosBeta1;
+        cosAlpha0 = hypot (cosAlpha1, sinAlpha1 * sinBeta1);
+        sinAlpha2 = cosBeta2 != cosBeta1 ? sinAlpha0 / cosBeta2 : sinAlpha1;
+        cosAlpha2 = cosBeta2 != cosBeta1 || fabs (sinBeta2) != - sinBeta1 ?
+                    sqrt (cosAlpha1 * cosAlpha1 * cosBeta1 * cosBeta1 +
+                          (cosBeta1 < - sinBeta1 ? (cosBeta2 - cosBeta1) * (cosBeta1 + cosBeta2) : (sinBeta1 - sinBeta2) * (sinBeta1 + sinBeta2))) / cosBeta2 :
+                    fabs (cosAlpha1);
+
+        auto sigma1 = atan2 (sinBeta1, cosAlpha1 * cosBeta1), sigma2 = atan2 (sinBeta2, cosAlpha2 * cosBeta2);
+        auto sinSigma1 = sin (sigma1), cosSigma1 = cos (sigma1), sinSigma2 = sin (sigma2), cosSigma2 = cos (sigma2);
+        auto sinOmega1 = sinAlpha0 * sinBeta1, cosOmega1 = cosAlpha1 * cosBeta1;
+        auto sinOmega2 = sinAlpha0 * sinBeta2, cosOmega2 = cosAlpha2 * cosBeta2;
+        auto sinOmega12 = fmax (0.0, cosOmega1 * sinOmega2 - sinOmega1 * cosOmega2), cosOmega12 = cosOmega1 * cosOmega2 + sinOmega1 * sinOmega2;
+
+        sigma = atan2 (fmax (0.0, cosSigma1 * sinSigma2 - sinSigma1 * cosSigma2), cosSigma1 * cosSigma2 + sinSigma1 * sinSigma2);
+        cos2SigmaM = cosSigma1 * cosSigma2 - sinSigma1 * sinSigma2;
+
+        auto cos2Alpha0 = cosAlpha0 * cosAlpha0;
+        auto c = flattening * ONE_SIXTEENTH * cos2Alpha0 * (4.0 + flattening * (4.0 - 3.0 * cos2Alpha0));
+        auto correction = (1.0 - c) * flattening * sinAlpha0 * (sigma + c * sin (sigma) * (cos2SigmaM + c * cos (sigma) * (2.0 * cos2SigmaM * cos2SigmaM - 1.0)));
+
+        return atan2 (sinOmega12 * cosLon - cosOmega12 * sinLon, cosOmega12 * cosLon + sinOmega12 * sinLon) - correction;
+    };
+
+    double lower = 0.0, upper = PI;
+    int steps = 0;
+
+    for (; steps < MAX_BISECTIONS && upper - lower > AZIMUTH_PRECISION; ++ steps) {
+        auto alpha1 = 0.5 * (lower + upper);
+
+        if (evaluate (alpha1) < 0.0)
+            lower = alpha1;
+        else
+            upper = alpha1;
+    }
+
+    evaluate (0.5 * (lower + upper));
+
+    // Vincenty's distance series
+    auto u2 = cosAlpha0 * cosAlpha0 * flattening * (2.0 - flattening) / ((1.0 - flattening) * (1.0 - flattening));
+    auto a = 1.0 + u2 / 16384.0 * (4096.0 + u2 * (-768.0 + u2 * (320.0 - 175.0 * u2)));
+    auto b = u2 / 1024.0 * (256.0 + u2 * (-128.0 + u2 * (74.0 - 47.0 * u2)));
+    auto sinSigma = sin (sigma), cosSigma = cos (sigma);
+    auto deltaSigma = b * sinSigma * (cos2SigmaM + 0.25 * b * (cosSigma * (2.0 * cos2SigmaM * cos2SigmaM - 1.0) -
+                                      b * ONE_SIXTH * cos2SigmaM * (4.0 * sinSigma * sinSigma - 3.0) * (4.0 * cos2SigmaM * cos2SigmaM - 3.0)));
+
+    if (swapSign < 0.0) {
+        std::swap (sinAlpha1, sinAlpha2);
+        std::swap (cosAlpha1, cosAlpha2);
+    }
+
+    auto brg = atan2 (sinAlpha1 * swapSign * lonSign, cosAlpha1 * swapSign * latSign);
+    auto endBrg = atan2 (sinAlpha2 * swapSign * lonSign, cosAlpha2 * swapSign * latSign);
+
+    checkBearing (& brg);
+    checkBearing (& endBrg);
+
+    if (range) *range = ellipsoid.equRadius * (1.0 - flattening) * a * (sigma - deltaSigma) * NM_IN_METER;
+    if (bearing) *bearing = brg;
+    if (endBearing) *endBearing = endBrg;
+
+    return steps + 1;
+}
+
+// This is a translation of the Fortran routine INVER1 found in the
+// INVERS3D program at:
+// ftp://ftp.ngs.noaa.gov/pub/pcsoft/for_inv.3d/source/invers3d.for
+// The iteration is templated over the arithmetic type as DIRCT1 is; it converges to the precision or to the type
+// tolerance relative to the auxiliary longitude, whichever is larger. The iteration starts from the longitude
+// difference times auxLonScale and returns the converged ratio there. False is returned (results are left as they
+// are) for the nearly antipodal points, past the cap and if the iteration settles out of the root range; the caller
+// solves these by the bisection then. The number of the steps is returned in iterations either way
+template <typename Real> static inline bool calcGcInverseIteration (const Ellipsoid& ellipsoid, Real precision, Real originLat, Real originLon, Real destLat,
+                                                                    Real destLon, Real *range, Real *bearing, Real *endBearing, Real *auxLonScale,
+                                                                    int *iterations, int maxIterations) {
     // The ton most of variables used... (exclude args and global definitions)
-    {
-        
-        double brg = 0.0, endBrg = 0.0, rng  = 0.0;
-        double c           = 0.0;
-        double c_value_1   = 0.0;
-        double c_value_2   = 0.0;
-        double c2a         = 0.0;
-        double cosine_of_x = 0.0;
-        double cy          = 0.0;
-        double cz          = 0.0;
-        double d           = 0.0;
-        double e           = 0.0;
-        double r_value     = 0.0;
-        double s           = 0.0;
-        double s_value_1   = 0.0;
-        double sa          = 0.0;
-        double sine_of_x   = 0.0;
-        double sy          = 0.0;
-        double tangent_1   = 0.0;
-        double tangent_2   = 0.0;
-        double x           = 0.0;
-        double y           = 0.0;
-        double prev_d      = 1.0E300;
-
-        r_value = 1.0 - geo::WGS84_FLATTENING;
-        tangent_1 = r_value * tan(origin->lat);
-        tangent_2 = r_value * tan(dest->lat);
-        c_value_1 = 1.0 / sqrt((tangent_1 * tangent_1) + 1.0);
-        s_value_1 = c_value_1 * tangent_1;
-        c_value_2 = 1.0 / sqrt((tangent_2 * tangent_2) + 1.0);
-        s = c_value_1 * c_value_2;
-
-        endBrg = s * tangent_2; // backward_azimuth
-        brg = endBrg * tangent_1;
-
-        x = dest->lon - origin->lon;
+    Real brg = 0, endBrg = 0;
+    Real c           = 0;
+    Real c_value_1   = 0;
+    Real c_value_2   = 0;
+    Real c2a         = 0;
+    Real cosine_of_x = 0;
+    Real cy          = 0;
+    Real cz          = 0;
+    Real d           = 0;
+    Real e           = 0;
+    Real r_value     = 0;
+    Real s           = 0;
+    Real s_value_1   = 0;
+    Real sa          = 0;
+    Real sine_of_x   = 0;
+    Real sy          = 0;
+    Real tangent_1   = 0;
+    Real tangent_2   = 0;
+    Real x           = 0;
+    Real y           = 0;
+    Real prev_d      = std::numeric_limits <Real>::max ();
+    const Real one = 1, two = 2, flattening = (Real) ellipsoid.flattening;
+
+    r_value = one - flattening;
+    tangent_1 = r_value * tan(originLat);
+    tangent_2 = r_value * tan(destLat);
+    c_value_1 = one / sqrt((tangent_1 * tangent_1) + one);
+    s_value_1 = c_value_1 * tangent_1;
+    c_value_2 = one / sqrt((tangent_2 * tangent_2) + one);
+    s = c_value_1 * c_value_2;
+
+    endBrg = s * tangent_2; // backward_azimuth
+    brg = endBrg * tangent_1;
+
+    // Terms of the auxiliary sphere longitude difference; returns its correction by the geodetic one
+    auto evaluate = [&] (Real lambda) {
+        sine_of_x   = sin(lambda);
+        cosine_of_x = cos(lambda);
+        tangent_1 = c_value_2 * sine_of_x;
+        tangent_2 = endBrg - (s_value_1 * c_value_2 * cosine_of_x);
+        sy = sqrt((tangent_1 * tangent_1) + (tangent_2 * tangent_2));
+        cy = (s * cosine_of_x) + brg;
+        y = atan2(sy, cy);
+        sa = (s * sine_of_x) / sy;
+        c2a = ((-sa) * sa) + one;
+        cz = brg + brg;
+
+        if (c2a > (Real) 0)
+        {
+            cz = ((-cz) / c2a) + cy;
+        }
+
+        e = (cz * cz * two) - one;
+        c = (((((- (Real) 3 * c2a) + (Real) 4) * flattening) + (Real) 4) * c2a * flattening) * (Real) ONE_SIXTEENTH;
+
+        return (one - c) * (((((e * cy * c) + cz) * sy * c) + y) * sa) * flattening;
+    };
+
+    // First condition is required to eliminate the recycling
+    auto pending = [&] () {
+    #ifdef _USE_ITER_PRECISION_
+        return IsDiffLessThanPrecision ((double) prev_d, (double) x) && IsDiffLessThanPrecision ((double) d, (double) x);
+    #else
+        auto bound = fmax (precision, KernelTraits <Real>::tolerance * fabs (x));
+
+        return fabs (prev_d - x) > bound && fabs (d - x) > bound;
+    #endif
+    };
 
+    auto deltaLon = remainder (destLon - originLon, (Real) TWO_PI);
+    auto antipodal = (Real) PI - fabs (deltaLon) < (Real) ANTIPODAL_ZONE && fabs (originLat + destLat) < (Real) ANTIPODAL_ZONE;
+    auto cap = maxIterations > 0 ? maxIterations : MAX_INVERSE_ITERATIONS;
+    int iteration = 0;
+
+    x = destLon - originLon;
+
+    if (auxLonScale) x *= *auxLonScale;
+
+    if (!antipodal) {
         do
         {
-            sine_of_x   = sin(x);
-            cosine_of_x = cos(x);
-            tangent_1 = c_value_2 * sine_of_x;
-            tangent_2 = endBrg - (s_value_1 * c_value_2 * cosine_of_x);
-            sy = sqrt((tangent_1 * tangent_1) + (tangent_2 * tangent_2));
-            cy = (s * cosine_of_x) + brg;
-            y = atan2(sy, cy);
-            sa = (s * sine_of_x) / sy;
-            c2a = ((-sa) * sa) + 1.0;
-            cz = brg + brg;
-
-            if (c2a > 0.0)
-            {
-                cz = ((-cz) / c2a) + cy;
-            }
-
-            e = (cz * cz * 2.0) - 1.0;
-            c = (((((-3.0 * c2a) + 4.0) * geo::WGS84_FLATTENING) + 4.0) * c2a * geo::WGS84_FLATTENING) * ONE_SIXTEENTH;
+            ++ iteration;
 
             prev_d = d;
 
             d = x;
-            x = ((((e * cy * c) + cz) * sy * c) + y) * sa;
-            x = ((1.0 - c) * x * geo::WGS84_FLATTENING) + dest->lon - origin->lon;
+            x = evaluate (d) + destLon - originLon;
         }
-    #ifdef _USE_ITER_PRECISION_
-        while (IsDiffLessThanPrecision (prev_d, x) && IsDiffLessThanPrecision (d, x));
-    #else
-        while (geo::isNotSame (prev_d, x) && geo::isNotSame (d, x));
-    #endif
-        // First condition is required to eliminate the recycling
-
-        brg = atan2(tangent_1, tangent_2);
-        endBrg = atan2(c_value_1 * sine_of_x, ((endBrg * cosine_of_x) - (s_value_1 * c_value_2))) + PI;
-
-        x = sqrt((((1.0 / (r_value * r_value)) - 1) * c2a) + 1.0) + 1.0;
-        x = (x - 2.0) / x;
-        c = 1.0 - x;
-        c = (((x * x) * 0.25) + 1.0) / c;
-        d = ((0.375 * (x * x)) - 1.0) * x;
-        x = x * cy;
-
-        s = (1.0 - e) - e;
-
-        double ter1 = 0.0;
-        double ter2 = 0.0;
-        double ter3 = 0.0;
-        double ter4 = 0.0;
-        double ter5 = 0.0;
-
-        ter1 = (sy * sy * 4.0) - 3.0;
-        ter2 = ((s * cz * d) * geo::ONE_SIXTH) - x;
-        ter3 = ter1 * ter2;
-        ter4 = ((ter3 * d) * 0.25) + cz;
-        ter5 = (ter4 * sy * d) + y;
-
-        rng = ter5 * c * geo::WGS84_EQUAT_RAD_M * r_value * geo::NM_IN_METER;
-
-        // Check&Turn over to ECDIS
-        geo::checkBearing (& brg);
-        geo::checkBearing (& endBrg);
-        geo::reverseBearing (& endBrg);
-
-        if (bearing) *bearing = brg;
-        if (endBearing) *endBearing = endBrg;
-        if (range) *range = rng;
+        while (pending () && iteration < cap);
     }
 
+    *iterations = iteration;
+
+    // The correction is not negative for the longitude differences in [0, PI] and zero at PI, so lambda = L + correction
+    // has the root between L and PI (between -PI and L for the negative L). Iteration exceeding the cap or settling
+    // out of this range is replaced by the bisection on the start azimuth as well as the nearly antipodal points
+    auto lambda = remainder (x, (Real) TWO_PI);
+
+    if (antipodal || pending () || (deltaLon >= (Real) 0 ? lambda < deltaLon : lambda > deltaLon)) return false;
+
+    if (auxLonScale && destLon != originLon) *auxLonScale = x / (destLon - originLon);
+
+    brg = atan2(tangent_1, tangent_2);
+    endBrg = atan2(c_value_1 * sine_of_x, ((endBrg * cosine_of_x) - (s_value_1 * c_value_2))) + (Real) PI;
+
+    x = sqrt((((one / (r_value * r_value)) - one) * c2a) + one) + one;
+    x = (x - two) / x;
+    c = one - x;
+    c = (((x * x) * (Real) 0.25) + one) / c;
+    d = (((Real) 0.375 * (x * x)) - one) * x;
+    x = e * cy;
+
+    s = (one - e) - e;
+
+    Real ter1 = 0;
+    Real ter2 = 0;
+    Real ter3 = 0;
+    Real ter4 = 0;
+    Real ter5 = 0;
+
+    ter1 = (sy * sy * (Real) 4) - (Real) 3;
+    ter2 = ter1 * s * cz * d * (Real) geo::ONE_SIXTH;
+    ter3 = ter2 - x;
+    ter4 = ((ter3 * d) * (Real) 0.25) + cz;
+    ter5 = (ter4 * sy * d) + y;
+
+    // Check&Turn over to ECDIS
+    geo::normalizeAngle (& brg);
+    geo::normalizeAngle (& endBrg);
+    geo::reverseBearing (& endBrg);
+
+    if (bearing) *bearing = brg;
+    if (endBearing) *endBearing = endBrg;
+    if (range) *range = ter5 * c * (Real) ellipsoid.equRadius * r_value * (Real) geo::NM_IN_METER;
+
     return true;
 }
 
-// Calculate great circle end position by begin coordinates, prange and bearing
-bool calcGreatCirclePos (bool useWgs84, Pos *origin, double range, double bearing, Pos *dest, double *endBearing) {
-    if (!dest) return false;
+// Inverse problem on the ellipsoid; points must be checked and normalized by the caller. The iteration starts from
+// the longitude difference times auxLonScale (ratio of the auxiliary sphere longitude difference to the geodetic one)
+// if given, the converged ratio is returned there along with the number of the steps taken. Positive maxIterations
+// caps the iteration (100 steps otherwise): past the cap (or if the iteration settles out of the root range) and for
+// the nearly antipodal points the start azimuth is found by the bisection taking 48 steps, the path taken is
+// returned in path
+void calcGcInverse (const Ellipsoid& ellipsoid, double precision, const Pos *origin, const Pos *dest, double *range, double *bearing,
+                    double *endBearing, double *auxLonScale, int *iterations, int maxIterations, GcInversePath *path) {
+    GEO_PROBE (GEO_KERNEL_GC_INVERSE);
 
-    dest->lat = dest->lon = 0;
+    int iteration = 0;
+
+    if (calcGcInverseIteration (ellipsoid, precision, origin->lat, origin->lon, dest->lat, dest->lon, range, bearing, endBearing, auxLonScale, & iteration,
+                                maxIterations)) {
+        if (path) *path = GC_PATH_ITERATION;
+    } else {
+        iteration += calcGcInverseByAzimuth (ellipsoid, origin->lat, dest->lat, remainder (dest->lon - origin->lon, TWO_PI), range, bearing, endBearing);
+
+        GEO_PROBE_FALLBACKS (1);
+
+        if (auxLonScale) *auxLonScale = 1.0;
+        if (path) *path = GC_PATH_BISECTION;
+    }
 
+    GEO_PROBE_ITERATIONS (iteration);
+
+    if (iterations) *iterations = iteration;
+}
+
+static bool calcGreatCircleDistAndBrgUncaptured (bool useWgs84, Pos *origin, Pos *dest, double *range, double *bearing, double *endBearing) {
+    if (range) *range = 0.0;
+    if (bearing) *bearing = 0.0;
     if (endBearing) *endBearing = 0.0;
 
-    if (geo::invalidVal (origin->lat) || geo::invalidVal (origin->lon) || geo::invalidVal (range) || geo::invalidVal (bearing)) return false;
+    if (geo::invalidVal (origin->lat) || geo::invalidVal (origin->lon) || geo::invalidVal (dest->lat) || geo::invalidVal (dest->lon)
+        || fabs (origin->lat) > 10000. || fabs (origin->lon) > 10000. || fabs (dest->lat) > 10000. || fabs (dest->lon) > 10000.) {
+        GEO_COUNT_REJECT (GEO_KERNEL_GC_INVERSE);
+        return false;
+    }
 
     geo::normalizeLon (& origin->lon);
-    geo::normalizeAngle (& bearing);
+    geo::normalizeLon (& dest->lon);
 
-    if (!geo::checkBegPointCourseDist (origin->lat, origin->lon, bearing, range, false)) return false;
+    if (!geo::checkSegmentRag (origin->lat, origin->lon, dest->lat, dest->lon, true, false)) {
+        GEO_COUNT_REJECT (GEO_KERNEL_GC_INVERSE);
+        return false;
+    }
 
-    // Calculation block
-	// Best coincidence with 7Cs Great Circle methods
+    // If both points are the same we cannot calculate as soon begin course as end one. In this case we return zero 
+    // distance and zero course
+    if (geo::isSame (origin->lat, dest->lat) && geo::isSame (origin->lon, dest->lon)) return true;
 
-    // This is a translation of the Fortran routine DIRCT1 found in the
-    // FORWRD3D program at:
-    // ftp://ftp.ngs.noaa.gov/pub/pcsoft/for_inv.3d/source/forwrd3d.for
-    double endLat = 0.0, endLon = 0.0, endBrg = 0.0;
-    double c                                          = 0.0;
-    double c2a                                        = 0.0;
-    double cosine_of_direction                        = 0.0;
-    double cosine_of_y                                = 0.0;
-    double cu                                         = 0.0;
-    double cz                                         = 0.0;
-    double d                                          = 0.0;
-    double e                                          = 0.0;
-    double direction_in_radians                       = 0.0;
-    double r                                          = 0.0;
-    double sa                                         = 0.0;
-    double sine_of_direction                          = 0.0;
-    double sine_of_y                                  = 0.0;
-    double su                                         = 0.0;
-    double tangent_u                                  = 0.0;
-    double term_1                                     = 0.0;
-    double term_2                                     = 0.0;
-    double term_3                                     = 0.0;
-    double x                                          = 0.0;
-    double y                                          = 0.0;
-    double x_square;
-
-    if (geo::wrongDistance (range)) return false;
+    calcGcInverse (WGS84_ELLIPSOID, DEFPRECISION, origin, dest, range, bearing, endBearing);
 
-    if (range > -1.0e-8 && range < -1.0e-8) {
-        *dest = *origin;
+    return true;
+}
 
-        if (endBearing) *endBearing = bearing;
+bool calcGreatCircleDistAndBrg (bool useWgs84, Pos *origin, Pos *dest, double *range, double *bearing, double *endBearing) {
+    CallCapture capture (GEO_CALL_GC_DIST_BRG, useWgs84, origin, dest);
 
-        return true;
+    return capture.finish (calcGreatCircleDistAndBrgUncaptured (useWgs84, origin, dest, range, bearing, endBearing), range, bearing, endBearing);
+}
+
+void initGcSolver (const Ellipsoid *ellipsoid, GcSolver *solver) {
+    if (!solver) return;
+
+    solver->ellipsoid = ellipsoid ? *ellipsoid : WGS84_ELLIPSOID;
+    solver->auxLonScale = 1.0;
+    solver->queries = solver->iterations = solver->bisections = 0;
+    solver->maxIterations = 0;
+    solver->lastPath = GC_PATH_NONE;
+}
+
+// Inverse problem warm started by the last solution of the solver: the ratio of the auxiliary sphere longitude
+// difference to the geodetic one changes slowly with the positions, so the next query for the same pair of vessels
+// starts within the tolerance and takes one iteration
+bool solveGcInverse (GcSolver *solver, const Pos *origin, const Pos *dest, double *range, double *bearing, double *endBearing) {
+    if (!solver || !origin || !dest) return false;
+
+    Pos begin = *origin, end = *dest;
+    double rng = 0.0, brg = 0.0, endBrg = 0.0;
+    int iterations;
+
+    if (geo::invalidVal (begin.lat) || geo::invalidVal (begin.lon) || geo::invalidVal (end.lat) || geo::invalidVal (end.lon) ||
+        fabs (begin.lat) > HALF_PI || fabs (end.lat) > HALF_PI || fabs (begin.lon) > 10000. || fabs (end.lon) > 10000.) {
+        GEO_COUNT_REJECT (GEO_KERNEL_GC_INVERSE);
+        return false;
     }
 
-    direction_in_radians = bearing;
+    geo::normalizeLon (& begin.lon);
+    geo::normalizeLon (& end.lon);
+
+    solver->lastPath = GC_PATH_NONE;
+
+    if (geo::isNotSame (begin.lat, end.lat) || geo::isNotSame (begin.lon, end.lon)) {
+        calcGcInverse (solver->ellipsoid, DEFPRECISION, & begin, & end, & rng, & brg, & endBrg, & solver->auxLonScale, & iterations, solver->maxIterations,
+                       & solver->lastPath);
+
+        ++ solver->queries;
+        solver->iterations += iterations;
+
+        if (solver->lastPath == GC_PATH_BISECTION) ++ solver->bisections;
+    }
+
+    if (range) *range = rng;
+    if (bearing) *bearing = brg;
+    if (endBearing) *endBearing = endBrg;
+
+    return true;
+}
 
-    r = 1.0 - geo::WGS84_FLATTENING;
+static const int MAX_DIRECT_ITERATIONS = 100;
 
-    origin->lat  = origin->lat;
-    origin->lon = origin->lon;
+// Origin-dependent terms of DIRCT1; these do not depend on range and bearing so may be calculated once
+// for a series of points built from the same origin
+template <typename Real> struct GcOrigin {
+    Real lon, tangentU, cu, su, equRadius, flattening;
+};
 
-    tangent_u = r * tan(origin->lat);
+template <typename Real> static inline void initGcOrigin (const Ellipsoid& ellipsoid, const Pos *origin, GcOrigin <Real> *org) {
+    org->lon = (Real) origin->lon;
+    org->equRadius = (Real) ellipsoid.equRadius;
+    org->flattening = (Real) ellipsoid.flattening;
 
-    sine_of_direction = sin(direction_in_radians);
+    // Origin terms are calculated once so they are always rounded from the double values
+    auto tangentU = (1.0 - ellipsoid.flattening) * tan (origin->lat);
+    auto cu = 1.0 / sqrt ((tangentU * tangentU) + 1.0);
 
-    cosine_of_direction = cos(direction_in_radians);
+    org->tangentU = (Real) tangentU;
+    org->cu = (Real) cu;
+    org->su = (Real) (tangentU * cu);
+}
 
-    if (cosine_of_direction != 0.0)
-        endBrg = atan2(tangent_u, cosine_of_direction) * 2.0;
+// This is a translation of the Fortran routine DIRCT1 found in the
+// FORWRD3D program at:
+// ftp://ftp.ngs.noaa.gov/pub/pcsoft/for_inv.3d/source/forwrd3d.for
+// The kernel is templated over the arithmetic type; iterations are limited for the types converging slowly and
+// the convergence test is relative since the terms of the last iteration are used for short arcs as well; nonzero
+// precision bounds the arc change (radians) absolutely too. Returns the number of the iterations
+template <typename Real> static inline int calcGcPosFromOrigin (GcOrigin <Real> *org, Real range, Real bearing, Real *endLat, Real *endLon, Real *endBearing,
+                                                                Real precision = 0) {
+    Real endBrg = 0;
+    Real c                                          = 0;
+    Real c2a                                        = 0;
+    Real cosine_of_direction                        = 0;
+    Real cosine_of_y                                = 0;
+    Real cu                                         = org->cu;
+    Real cz                                         = 0;
+    Real d                                          = 0;
+    Real e                                          = 0;
+    Real r                                          = (Real) 1 - org->flattening;
+    Real sa                                         = 0;
+    Real sine_of_direction                          = 0;
+    Real sine_of_y                                  = 0;
+    Real su                                         = org->su;
+    Real tangent_u                                  = org->tangentU;
+    Real term_1                                     = 0;
+    Real term_2                                     = 0;
+    Real term_3                                     = 0;
+    Real x                                          = 0;
+    Real y                                          = 0;
+    Real x_square;
+    const Real one = 1, two = 2;
+
+    sine_of_direction = sin(bearing);
+
+    cosine_of_direction = cos(bearing);
+
+    if (cosine_of_direction != (Real) 0)
+        endBrg = atan2(tangent_u, cosine_of_direction) * two;
 
-    cu = 1.0 / sqrt((tangent_u * tangent_u) + 1.0);
-    su = tangent_u * cu;
     sa = cu * sine_of_direction;
-    c2a = 1.0 - sa * sa; 
-    x = sqrt((((1.0 / (r * r)) - 1.0) * c2a) + 1.0) + 1.0;
-    x = (x - 2.0) / x;
-    c = 1.0 - x;
+    c2a = one - sa * sa; 
+    x = sqrt((((one / (r * r)) - one) * c2a) + one) + one;
+    x = (x - two) / x;
+    c = one - x;
     x_square = x * x;
-    c = ((x_square * geo::QUARTER_PI) + 1.0) / c;
-    d = ((0.375 * x_square) - 1.0) * x;
+    c = ((x_square * (Real) 0.25) + one) / c;
+    d = (((Real) 0.375 * x_square) - one) * x;
 
-    tangent_u = range * geo::METERS_IN_NM / (r * geo::WGS84_EQUAT_RAD_M * c);
+    tangent_u = range * (Real) geo::METERS_IN_NM / (r * org->equRadius * c);
 
     y = tangent_u;
 
-    do {
+    auto iteration = 0;
+
+    while (iteration < MAX_DIRECT_ITERATIONS) {
+        ++ iteration;
+
         sine_of_y = sin(y);
         cosine_of_y = cos(y);
         cz = cos(endBrg + y);
-        e = (cz * cz * 2.0) - 1.0;
+        e = (cz * cz * two) - one;
         c = y;
         x = e * cosine_of_y;
-        y = (e + e) - 1.0;
+        y = (e + e) - one;
 
-        term_1 = (sine_of_y * sine_of_y * 4.0) - 3.0;
-        term_2 = ((term_1 * y * cz * d) * geo::ONE_SIXTH_PI) + x;
-        term_3 = ((term_2 * d) * geo::QUARTER_PI) - cz;
+        term_1 = (sine_of_y * sine_of_y * (Real) 4) - (Real) 3;
+        term_2 = ((term_1 * y * cz * d) * (Real) geo::ONE_SIXTH) + x;
+        term_3 = ((term_2 * d) * (Real) 0.25) - cz;
         y = (term_3 * sine_of_y * d) + tangent_u;
+
+        if (fabs (y - c) <= KernelTraits <Real>::tolerance * fabs (y) || fabs (y - c) <= precision) break;
     }
-#ifdef _USE_ITER_PRECISION_
-    while (IsDiffLessThanPrecision (y, c));
-#else
-    while (geo::isNotSame (y, c, 1.0e-14));
-#endif
 
     endBrg = (cu * cosine_of_y * cosine_of_direction) - (su * sine_of_y);
 
     c = r * geo::hypoLen (sa, endBrg);
     d = (su * cosine_of_y) + (cu * sine_of_y * cosine_of_direction);
 
-    endLat = atan2(d, c);
+    *endLat = atan2(d, c);
 
     c = (cu * cosine_of_y) - (su * sine_of_y * cosine_of_direction);
     x = atan2(sine_of_y * sine_of_direction, c);
-    c = (((((-3.0 * c2a) + 4.0) * geo::WGS84_FLATTENING) + 4.0) * c2a * geo::WGS84_FLATTENING) * ONE_SIXTEENTH;
+    c = (((((- (Real) 3 * c2a) + (Real) 4) * org->flattening) + (Real) 4) * c2a * org->flattening) * (Real) ONE_SIXTEENTH;
     d = ((((e * cosine_of_y * c) + cz) * sine_of_y * c) + y) * sa;
 
-    endLon = (origin->lon + x) - ((1.0 - c) * d * geo::WGS84_FLATTENING);
-
-    endBrg = atan2(sa, endBrg) + PI;
+    *endLon = (org->lon + x) - ((one - c) * d * org->flattening);
 
-    endLat  = endLat;
-    endLon = endLon;
+    endBrg = atan2(sa, endBrg) + (Real) PI;
 
     geo::reverseBearing (& endBrg);
-    geo::normalizeLon (& endLon);
+    geo::normalizeLon (endLon);
+
+    *endBearing = endBrg;
+
+    return iteration;
+}
+
+// Direct problem on the ellipsoid; origin must be checked and normalized by the caller
+void calcGcDirect (const Ellipsoid& ellipsoid, double precision, const Pos *origin, double range, double bearing, Pos *dest, double *endBearing) {
+    GEO_PROBE (GEO_KERNEL_GC_DIRECT);
+
+    GcOrigin <double> org;
+    double endBrg;
+
+    initGcOrigin (ellipsoid, origin, & org);
+
+    auto iterations = calcGcPosFromOrigin (& org, range, bearing, & dest->lat, & dest->lon, & endBrg, precision);
+
+    GEO_PROBE_ITERATIONS (iterations);
+
+    if (endBearing) *endBearing = endBrg;
+}
+
+// Calculate great circle end position by begin coordinates, prange and bearing
+static bool calcGreatCirclePosUncaptured (bool useWgs84, Pos *origin, double range, double bearing, Pos *dest, double *endBearing) {
+    if (!dest) return false;
+
+    dest->lat = dest->lon = 0;
+
+    if (endBearing) *endBearing = 0.0;
+
+    if (geo::invalidVal (origin->lat) || geo::invalidVal (origin->lon) || geo::invalidVal (range) || geo::invalidVal (bearing)) {
+        GEO_COUNT_REJECT (GEO_KERNEL_GC_DIRECT);
+        return false;
+    }
+
+    geo::normalizeLon (& origin->lon);
+    geo::normalizeAngle (& bearing);
+
+    if (!geo::checkBegPointCourseDist (origin->lat, origin->lon, bearing, range, false) || geo::wrongDistance (range)) {
+        GEO_COUNT_REJECT (GEO_KERNEL_GC_DIRECT);
+        return false;
+    }
+
+    // Calculation block
+	// Best coincidence with 7Cs Great Circle methods
+    double endLat = 0.0, endLon = 0.0, endBrg = 0.0;
+
+    if (range > -1.0e-8 && range < -1.0e-8) {
+        *dest = *origin;
+
+        if (endBearing) *endBearing = bearing;
+
+        return true;
+    }
+
+    GEO_PROBE (GEO_KERNEL_GC_DIRECT);
+
+    GcOrigin <double> org;
+
+    initGcOrigin (WGS84_ELLIPSOID, origin, & org);
+
+    auto iterations = calcGcPosFromOrigin (& org, range, bearing, & endLat, & endLon, & endBrg);
+
+    GEO_PROBE_ITERATIONS (iterations);
 
     if (endBearing) *endBearing = endBrg;
 
@@ -282,6 +585,147 @@ bool calcGreatCirclePos (bool useWgs84, Pos *origin, double range, double bearin
     return true;
 }
 
+bool calcGreatCirclePos (bool useWgs84, Pos *origin, double range, double bearing, Pos *dest, double *endBearing) {
+    CallCapture capture (GEO_CALL_GC_POS, useWgs84, origin, range, bearing);
+
+    return capture.finish (calcGreatCirclePosUncaptured (useWgs84, origin, range, bearing, dest, endBearing), dest ? & dest->lat : 0, dest ? & dest->lon : 0,
+                           endBearing);
+}
+
+// Calculate a series of great circle end positions from the same origin; origin terms are calculated once.
+// The destination buffer must be able to hold count points, invalid range/bearing pairs give zero positions
+bool calcGreatCirclePosBatch (bool useWgs84, Pos *origin, const double *ranges, const double *bearings, size_t count, PosBatch *dest, double *endBearings) {
+    if (!origin || !ranges || !bearings || !dest || dest->capacity < count) return false;
+
+    dest->count = 0;
+
+    if (geo::invalidVal (origin->lat) || geo::invalidVal (origin->lon)) return false;
+
+    geo::normalizeLon (& origin->lon);
+
+    if (!geo::checkGeoPointRange (origin->lat, origin->lon, true, false)) return false;
+
+    GcOrigin <double> org;
+    bool result = true;
+
+    initGcOrigin (WGS84_ELLIPSOID, origin, & org);
+
+    for (size_t i = 0; i < count; ++ i) {
+        double range = ranges [i], bearing = bearings [i], endBrg = 0.0;
+
+        dest->lat [i] = dest->lon [i] = 0.0;
+
+        if (geo::invalidVal (range) || geo::invalidVal (bearing) || geo::wrongDistance (range)) {
+            result = false;
+        } else {
+            geo::normalizeAngle (& bearing);
+            calcGcPosFromOrigin (& org, range, bearing, dest->lat + i, dest->lon + i, & endBrg);
+        }
+
+        if (endBearings) endBearings [i] = endBrg;
+    }
+
+    dest->count = count;
+
+    return result;
+}
+
+// Batch direct problem over the arithmetic type, one origin for all the points; invalid range/bearing pairs
+// give zero positions
+template <typename Real> bool calcGreatCirclePosT (const Ellipsoid *ellipsoid, const Pos *origin, const Real *ranges, const Real *bearings, size_t count, Real *lat, Real *lon) {
+    if (!origin || !ranges || !bearings || !lat || !lon) return false;
+
+    Pos begin = *origin;
+
+    if (geo::invalidVal (begin.lat) || geo::invalidVal (begin.lon)) return false;
+
+    geo::normalizeLon (& begin.lon);
+
+    if (!geo::checkGeoPointRange (begin.lat, begin.lon, true, false)) return false;
+
+    GcOrigin <Real> org;
+    Real endBrg;
+    bool result = true;
+
+    initGcOrigin (ellipsoid ? *ellipsoid : WGS84_ELLIPSOID, & begin, & org);
+
+    for (size_t i = 0; i < count; ++ i) {
+        Real range = ranges [i], bearing = bearings [i];
+
+        if (geo::invalidVal ((double) range) || geo::invalidVal ((double) bearing) || geo::wrongDistance ((double) range)) {
+            lat [i] = lon [i] = 0;
+            result = false;
+            continue;
+        }
+
+        geo::normalizeAngle (& bearing);
+        calcGcPosFromOrigin (& org, range, bearing, lat + i, lon + i, & endBrg);
+    }
+
+    return result;
+}
+
+template bool calcGreatCirclePosT <float> (const Ellipsoid *, const Pos *, const float *, const float *, size_t, float *, float *);
+template bool calcGreatCirclePosT <double> (const Ellipsoid *, const Pos *, const double *, const double *, size_t, double *, double *);
+template bool calcGreatCirclePosT <long double> (const Ellipsoid *, const Pos *, const long double *, const long double *, size_t, long double *, long double *);
+
+// Batch inverse problem over the arithmetic type from one origin to every point; the poles and invalid points give
+// zeros. The iteration runs to the type tolerance (the special case precision is 6 m in float), points it leaves to
+// the bisection are solved in double
+template <typename Real> bool calcGreatCircleDistAndBrgT (const Ellipsoid *ellipsoid, const Pos *origin, const Real *lat, const Real *lon, size_t count, Real *ranges, Real *bearings) {
+    if (!origin || !lat || !lon || !ranges || !bearings) return false;
+
+    Pos begin = *origin;
+
+    if (geo::invalidVal (begin.lat) || geo::invalidVal (begin.lon)) return false;
+
+    geo::normalizeLon (& begin.lon);
+
+    if (!geo::checkGeoPointRange (begin.lat, begin.lon, true, false)) return false;
+
+    auto el = ellipsoid ? *ellipsoid : WGS84_ELLIPSOID;
+    auto begLat = (Real) begin.lat, begLon = (Real) begin.lon;
+    bool result = true;
+
+    for (size_t i = 0; i < count; ++ i) {
+        auto endLon = lon [i];
+
+        ranges [i] = bearings [i] = 0;
+
+        if (geo::invalidVal ((double) lat [i]) || geo::invalidVal ((double) endLon) || fabs (endLon) > (Real) 10000) {
+            result = false;
+            continue;
+        }
+
+        geo::normalizeLon (& endLon);
+
+        if (!geo::checkGeoPointRange ((double) lat [i], (double) endLon, true, false)) {
+            result = false;
+            continue;
+        }
+
+        if (lat [i] == begLat && endLon == begLon) continue;
+
+        int iterations;
+
+        if (!calcGcInverseIteration (el, (Real) 0, begLat, begLon, lat [i], endLon, ranges + i, bearings + i, (Real *) 0, (Real *) 0,
+                                     & iterations, 0)) {
+            double range, bearing;
+
+            calcGcInverseByAzimuth (el, begin.lat, (double) lat [i], remainder ((double) endLon - begin.lon, TWO_PI), & range, & bearing, 0);
+
+            ranges [i] = (Real) range;
+            bearings [i] = (Real) bearing;
+        }
+    }
+
+    return result;
+}
+
+template bool calcGreatCircleDistAndBrgT <float> (const Ellipsoid *, const Pos *, const float *, const float *, size_t, float *, float *);
+template bool calcGreatCircleDistAndBrgT <double> (const Ellipsoid *, const Pos *, const double *, const double *, size_t, double *, double *);
+template bool calcGreatCircleDistAndBrgT <long double> (const Ellipsoid *, const Pos *, const long double *, const long double *, size_t, long double *, long double *);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,218 @@
+#define _INTERNAL_
+
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include "geo.h"
+
+#ifdef __cplusplus
+namespace geo {
+#endif
+
+static const char GRID_SHIFT_SIGNATURE [8] = { 'G', 'E', 'O', 'G', 'R', 'I', 'D', '1' };
+static const double RAD_IN_ARC_SECOND = RAD_IN_DEG / 3600.0;
+
+// The file is the header followed by tiles, both are used in place. Tiles go row by row from the south-west
+// corner, every tile holds (tileSize + 1) x (tileSize + 1) nodes (neighbour tiles share the edge nodes)
+#pragma pack(push, 8)
+struct GridShiftHeader {
+    char signature [8];
+    uint32_t rows, cols, tileSize, tileRows, tileCols, reserved;
+    double south, west, latStep, lonStep;
+};
+#pragma pack(pop)
+
+static inline size_t calcTileNodes (size_t tileSize) {
+    return (tileSize + 1) * (tileSize + 1);
+}
+
+// Bytes of the tiles in doubles, so the counts of a broken header cannot wrap around
+static inline double calcTileBytes (const GridShiftHeader *header) {
+    auto tileEdge = (double) header->tileSize + 1.0;
+
+    return (double) header->tileRows * (double) header->tileCols * tileEdge * tileEdge * 2.0 * sizeof (float);
+}
+
+// Header of the grid; the tile counts follow from the size of the grid and of the tiles
+static void initGridShiftHeader (double south, double west, double latStep, double lonStep, size_t rows, size_t cols, size_t tileSize,
+                                 GridShiftHeader *header) {
+    memset (header, 0, sizeof (*header));
+    memcpy (header->signature, GRID_SHIFT_SIGNATURE, sizeof (header->signature));
+
+    header->rows = (uint32_t) rows;
+    header->cols = (uint32_t) cols;
+    header->tileSize = (uint32_t) tileSize;
+    header->tileRows = (uint32_t) ((rows - 2) / tileSize + 1);
+    header->tileCols = (uint32_t) ((cols - 2) / tileSize + 1);
+    header->south = south;
+    header->west = west;
+    header->latStep = latStep;
+    header->lonStep = lonStep;
+}
+
+// Source shifts are row major from south to north and from west to east, in arc seconds
+bool writeGridShift (const char *path, double south, double west, double latStep, double lonStep, size_t rows, size_t cols,
+                     const float *latShifts, const float *lonShifts, size_t tileSize) {
+    if (!latShifts || !lonShifts || rows < 2 || cols < 2 || tileSize < 1 || latStep <= 0.0 || lonStep <= 0.0) return false;
+
+    GridShiftHeader header;
+
+    initGridShiftHeader (south, west, latStep, lonStep, rows, cols, tileSize, & header);
+
+    auto tileNodes = calcTileNodes (tileSize);
+    MappedFile file;
+
+    if (!mapFile (path, true, sizeof (header) + (size_t) header.tileRows * header.tileCols * tileNodes * 2 * sizeof (float), & file)) return false;
+
+    auto tiles = (float *) ((char *) file.data + sizeof (header));
+
+    memcpy (file.data, & header, sizeof (header));
+
+    for (size_t tileRow = 0; tileRow < header.tileRows; ++ tileRow) {
+        for (size_t tileCol = 0; tileCol < header.tileCols; ++ tileCol) {
+            auto node = tiles + (tileRow * header.tileCols + tileCol) * tileNodes * 2;
+
+            for (size_t i = 0; i <= tileSize; ++ i) {
+                // Nodes beyond the grid repeat the last row/column
+                auto row = tileRow * tileSize + i < rows ? tileRow * tileSize + i : rows - 1;
+
+                for (size_t j = 0; j <= tileSize; ++ j, node += 2) {
+                    auto col = tileCol * tileSize + j < cols ? tileCol * tileSize + j : cols - 1;
+
+                    node [0] = latShifts [row * cols + col];
+                    node [1] = lonShifts [row * cols + col];
+                }
+            }
+        }
+    }
+
+    unmapFile (& file);
+
+    return true;
+}
+
+// Opening checks the header only; pages of the grid are faulted in by the lookups. The header must be the one written
+// for its grid size, steps must be positive
+bool openGridShift (const char *path, GridShift *grid) {
+    if (!grid) return false;
+
+    memset (grid, 0, sizeof (*grid));
+
+    if (!mapFile (path, false, 0, & grid->file)) return false;
+
+    auto header = (const GridShiftHeader *) grid->file.data;
+    GridShiftHeader expected;
+
+    if (grid->file.size >= sizeof (*header) && header->rows >= 2 && header->cols >= 2 && header->tileSize >= 1)
+        initGridShiftHeader (header->south, header->west, header->latStep, header->lonStep, header->rows, header->cols, header->tileSize, & expected);
+
+    if (grid->file.size < sizeof (*header) || memcmp (header->signature, GRID_SHIFT_SIGNATURE, sizeof (header->signature)) != 0 ||
+        header->rows < 2 || header->cols < 2 || header->tileSize < 1 || memcmp (header, & expected, sizeof (expected)) != 0 ||
+        invalidVal (header->south) || invalidVal (header->west) || invalidVal (header->latStep) || invalidVal (header->lonStep) ||
+        header->latStep <= 0.0 || header->lonStep <= 0.0 ||
+        (double) grid->file.size < (double) sizeof (*header) + calcTileBytes (header)) {
+        unmapFile (& grid->file);
+        return false;
+    }
+
+    grid->tiles = (const float *) ((const char *) grid->file.data + sizeof (*header));
+    grid->rows = header->rows;
+    grid->cols = header->cols;
+    grid->tileSize = header->tileSize;
+    grid->tileRows = header->tileRows;
+    grid->tileCols = header->tileCols;
+    grid->south = header->south;
+    grid->west = header->west;
+    grid->latStep = header->latStep;
+    grid->lonStep = header->lonStep;
+
+    return true;
+}
+
+void closeGridShift (GridShift *grid) {
+    if (!grid) return;
+
+    unmapFile (& grid->file);
+    memset (grid, 0, sizeof (*grid));
+}
+
+static inline bool interpolateGridShift (const GridShift *grid, double lat, double lon, double *deltaLat, double *deltaLon) {
+    auto y = (lat - grid->south) / grid->latStep;
+    auto x = (lon - grid->west) / grid->lonStep;
+
+    if (!(y >= 0.0 && x >= 0.0 && y <= (double) (grid->rows - 1) && x <= (double) (grid->cols - 1))) {
+        *deltaLat = *deltaLon = 0.0;
+        return false;
+    }
+
+    auto row = (size_t) y < grid->rows - 1 ? (size_t) y : grid->rows - 2;
+    auto col = (size_t) x < grid->cols - 1 ? (size_t) x : grid->cols - 2;
+    auto fy = y - (double) row;
+    auto fx = x - (double) col;
+    auto rowSize = (grid->tileSize + 1) * 2;
+    auto tile = grid->tiles + ((row / grid->tileSize) * grid->tileCols + col / grid->tileSize) * calcTileNodes (grid->tileSize) * 2;
+    auto node00 = tile + (row % grid->tileSize) * rowSize + (col % grid->tileSize) * 2;
+    auto node10 = node00 + rowSize;
+    auto w00 = (1.0 - fx) * (1.0 - fy), w01 = fx * (1.0 - fy), w10 = (1.0 - fx) * fy, w11 = fx * fy;
+
+    *deltaLat = (w00 * node00 [0] + w01 * node00 [2] + w10 * node10 [0] + w11 * node10 [2]) * RAD_IN_ARC_SECOND;
+    *deltaLon = (w00 * node00 [1] + w01 * node00 [3] + w10 * node10 [1] + w11 * node10 [3]) * RAD_IN_ARC_SECOND;
+
+    return true;
+}
+
+// Bilinear interpolation of the shifts (radians); points outside of the grid get zero shifts and the
+// function returns false
+bool calcGridShifts (const GridShift *grid, const double *lat, const double *lon, size_t count, double *deltaLat, double *deltaLon) {
+    if (!grid || !grid->tiles || !lat || !lon || !deltaLat || !deltaLon) return false;
+
+    bool result = true;
+
+    for (size_t i = 0; i < count; ++ i) {
+        if (!interpolateGridShift (grid, lat [i], lon [i], deltaLat + i, deltaLon + i)) result = false;
+    }
+
+    return result;
+}
+
+// Applies the shifts in place; the backward conversion is solved by fixed point iteration. Points leaving the grid
+// are kept as they are and the function returns false
+bool convertGridShift (const GridShift *grid, bool forward, PosBatch *points) {
+    if (!grid || !grid->tiles || !points) return false;
+
+    bool result = true;
+
+    for (size_t i = 0; i < points->count; ++ i) {
+        double deltaLat, deltaLon, lat = points->lat [i], lon = points->lon [i];
+
+        if (!interpolateGridShift (grid, lat, lon, & deltaLat, & deltaLon)) {
+            result = false;
+            continue;
+        }
+
+        if (forward) {
+            points->lat [i] = lat + deltaLat;
+            points->lon [i] = lon + deltaLon;
+        } else {
+            auto inside = true;
+
+            // Shift is taken at the backward position twice
+            for (auto iteration = 0; iteration < 2 && inside; ++ iteration)
+                inside = interpolateGridShift (grid, lat - deltaLat, lon - deltaLon, & deltaLat, & deltaLon);
+
+            if (!inside) {
+                result = false;
+                continue;
+            }
+
+            points->lat [i] = lat - deltaLat;
+            points->lon [i] = lon - deltaLon;
+        }
+    }
+
+    return result;
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,171 @@
+#define _INTERNAL_
+
+#include <math.h>
+#include "geo.h"
+#include "geostats.h"
+
+#ifdef __cplusplus
+namespace geo {
+#endif
+
+// Beyond this ratio of the range to the parallel radius the terms dropped by the bound are not small any more
+static const double MAX_LOCAL_SPREAD = 0.1;
+
+// Rounding of the inputs and the plane solution, miles
+static const double LOCAL_ROUNDING = 1.0e-11;
+
+// Radii of curvature and their derivatives by the latitude are expanded at the anchor up to the second order so the
+// radii at the mid latitude of every point take no trigonometry. Derivatives follow from M' = 3 M q where
+// q = e^2 sin(lat) cos(lat) / W^2 and from (N cos(lat))' = -M sin(lat)
+bool initLocalFrame (const Ellipsoid *ellipsoid, const Pos *anchor, double maxError, LocalFrame *frame) {
+    if (!anchor || !frame || invalidVal (anchor->lat) || invalidVal (anchor->lon) || fabs (anchor->lat) > HALF_PI || invalidVal (maxError) || maxError < 0.0)
+        return false;
+
+    frame->ellipsoid = ellipsoid ? *ellipsoid : WGS84_ELLIPSOID;
+    frame->anchor = *anchor;
+    frame->maxError = maxError;
+
+    normalizeLon (& frame->anchor.lon);
+
+    auto flattening = frame->ellipsoid.flattening;
+    auto e2 = flattening * (2.0 - flattening);
+    auto sinLat = sin (anchor->lat);
+    auto cosLat = cos (anchor->lat);
+    auto w2 = 1.0 - e2 * sinLat * sinLat;
+    auto radius = frame->ellipsoid.equRadius * NM_IN_METER;
+    auto meridRadius = radius * (1.0 - e2) / (w2 * sqrt (w2));
+    auto primeRadius = radius / sqrt (w2);
+    auto q = e2 * sinLat * cosLat / w2;
+    auto meridSlope = 3.0 * meridRadius * q;
+
+    frame->sinLat = sinLat;
+    frame->cosLat = cosLat;
+    frame->meridRadius [0] = meridRadius;
+    frame->meridRadius [1] = meridSlope;
+    frame->meridRadius [2] = 1.5 * meridRadius * (5.0 * q * q + e2 * (cosLat * cosLat - sinLat * sinLat) / w2);
+    frame->parallelRadius [0] = primeRadius * cosLat;
+    frame->parallelRadius [1] = - meridRadius * sinLat;
+    frame->parallelRadius [2] = - 0.5 * (meridSlope * sinLat + meridRadius * cosLat);
+
+    // The meridional radius is the smallest one at any latitude; the third order terms of the range and cross track
+    // errors together are within range^3 / (11 R^2 cos^2 lat), 1/8 leaves the room for the higher order terms
+    frame->boundScale = 0.125 / (radius * radius * (1.0 - e2) * (1.0 - e2));
+
+    return true;
+}
+
+// Mid latitude solution in the local plane: north and east are the arcs along the meridian and the parallel at the
+// mid latitude, the bearing of the plane chord is turned back by half of the meridian convergence. Returns false
+// (leaving range and bearing unchanged) if the error bound exceeds the frame limit
+static inline bool calcLocalLeg (const LocalFrame *frame, double lat, double deltaLon, double *range, double *bearing, double *errorBound) {
+    auto deltaLat = lat - frame->anchor.lat;
+    auto half = deltaLat * 0.5;
+    auto meridRadius = frame->meridRadius [0] + half * (frame->meridRadius [1] + half * frame->meridRadius [2]);
+    auto parallelRadius = frame->parallelRadius [0] + half * (frame->parallelRadius [1] + half * frame->parallelRadius [2]);
+    auto sinMidLat = frame->sinLat + half * (frame->cosLat - half * 0.5 * frame->sinLat);
+    auto cosMidLat = frame->cosLat - half * (frame->sinLat + half * 0.5 * frame->cosLat);
+    auto north = meridRadius * deltaLat;
+    auto east = parallelRadius * deltaLon;
+    auto rng = hypoLen (north, east);
+
+    if (rng > MAX_LOCAL_SPREAD * parallelRadius) return false;
+
+    auto bound = frame->boundScale * rng * rng * rng / (cosMidLat * cosMidLat) + LOCAL_ROUNDING + rng * DBL_EPSILON * 16.0;
+
+    if (bound > frame->maxError) return false;
+
+    auto brg = rng > 0.0 ? atan2 (east, north) - 0.5 * deltaLon * sinMidLat : 0.0;
+
+    checkBearing (& brg);
+
+    *range = rng;
+    *bearing = brg;
+
+    if (errorBound) *errorBound = bound;
+
+    return true;
+}
+
+static inline bool loadLocalPoint (const LocalFrame *frame, double lat, double lon, double *deltaLon) {
+    if (invalidVal (lat) || invalidVal (lon) || fabs (lat) > HALF_PI || fabs (lon) > 10000.0) return false;
+
+    *deltaLon = lon - frame->anchor.lon;
+
+    normalizeLon (deltaLon);
+
+    return true;
+}
+
+// Exact solution (INVER1) for the points out of the local plane limits
+static inline void calcExactLeg (const LocalFrame *frame, double lat, double deltaLon, double *range, double *bearing) {
+    Pos dest { lat, frame->anchor.lon + deltaLon };
+
+    *range = *bearing = 0.0;
+
+    if (isNotSame (lat, frame->anchor.lat) || isNotSame (deltaLon, 0.0))
+        calcGcInverse (frame->ellipsoid, DEFPRECISION, & frame->anchor, & dest, range, bearing, 0);
+}
+
+// Range (miles) and bearing (radians) from the frame anchor; the local plane is used while its error bound is within
+// the frame limit, the exact inverse problem is solved otherwise and the bound returned is zero
+bool calcLocalDistAndBrg (const LocalFrame *frame, const Pos *dest, double *range, double *bearing, double *errorBound) {
+    double deltaLon, rng, brg, bound = 0.0;
+
+    if (!frame || !dest || !loadLocalPoint (frame, dest->lat, dest->lon, & deltaLon)) {
+        GEO_COUNT_REJECT (GEO_KERNEL_LOCAL_FRAME);
+        return false;
+    }
+
+    GEO_PROBE (GEO_KERNEL_LOCAL_FRAME);
+    GEO_PROBE_ITERATIONS (1);
+
+    if (!calcLocalLeg (frame, dest->lat, deltaLon, & rng, & brg, & bound)) {
+        calcExactLeg (frame, dest->lat, deltaLon, & rng, & brg);
+
+        GEO_PROBE_FALLBACKS (1);
+    }
+
+    if (range) *range = rng;
+    if (bearing) *bearing = brg;
+    if (errorBound) *errorBound = bound;
+
+    return true;
+}
+
+// Same for a batch of targets; exactCount (if given) receives the number of points solved by the exact inverse
+// problem. Invalid points give zero range and bearing
+bool calcLocalDistAndBrgBatch (const LocalFrame *frame, const double *lat, const double *lon, size_t count, double *ranges, double *bearings,
+                               size_t *exactCount) {
+    if (!frame || !lat || !lon || !ranges || !bearings) return false;
+
+    GEO_PROBE (GEO_KERNEL_LOCAL_FRAME);
+
+    size_t exact = 0;
+    bool result = true;
+
+    for (size_t i = 0; i < count; ++ i) {
+        double deltaLon;
+
+        if (!loadLocalPoint (frame, lat [i], lon [i], & deltaLon)) {
+            ranges [i] = bearings [i] = 0.0;
+            result = false;
+
+            GEO_COUNT_REJECT (GEO_KERNEL_LOCAL_FRAME);
+        } else if (!calcLocalLeg (frame, lat [i], deltaLon, ranges + i, bearings + i, 0)) {
+            calcExactLeg (frame, lat [i], deltaLon, ranges + i, bearings + i);
+
+            ++ exact;
+        }
+    }
+
+    if (exactCount) *exactCount = exact;
+
+    GEO_PROBE_ITERATIONS (count);
+    GEO_PROBE_FALLBACKS (exact);
+
+    return result;
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,276 @@
+#define _INTERNAL_
+
+#include <math.h>
+#include "geo.h"
+#include "geolanes.h"
+
+#ifdef __cplusplus
+namespace geo {
+#endif
+
+// Projection terms calculated once for the batch in double and rounded to the kernel type
+template <typename Real> struct MercatorTerms {
+    Real eccentricity, oneMinusE2, lat, lon, lonEast, lonWest, isoLat, scale, invScale;
+};
+
+template <typename Real> static bool initMercatorTerms (const Ellipsoid *ellipsoid, const Pos *origin, double k0, MercatorTerms <Real> *terms) {
+    if (!origin || invalidVal (origin->lat) || invalidVal (origin->lon) || invalidVal (k0) || k0 <= 0.0) return false;
+
+    auto el = ellipsoid ? *ellipsoid : WGS84_ELLIPSOID;
+    auto e2 = el.flattening * 2.0 - el.flattening * el.flattening;
+    auto lon = origin->lon;
+
+    normalizeLon (& lon);
+
+    if (!checkGeoPointRange (origin->lat, lon, true, false)) return false;
+
+    auto eccentricity = sqrt (e2);
+    auto part = eccentricity * sin (origin->lat);
+    auto scale = el.equRadius * k0 / METERS_IN_NM;
+
+    terms->eccentricity = (Real) eccentricity;
+    terms->oneMinusE2 = (Real) (1.0 - e2);
+    terms->lat = (Real) origin->lat;
+    terms->lon = (Real) lon;
+    terms->lonEast = (Real) (lon + TWO_PI);
+    terms->lonWest = (Real) (lon - TWO_PI);
+    terms->isoLat = (Real) (log (tan (QUARTER_PI + origin->lat * 0.5)) - 0.5 * eccentricity * log ((1.0 + part) / (1.0 - part)));
+    terms->scale = (Real) scale;
+    terms->invScale = (Real) (1.0 / scale);
+
+    return true;
+}
+
+// Longitude difference from the origin meridian in [-PI, PI); the origin shifted by the full turn is rounded once
+// per batch so crossing the antimeridian costs no precision
+template <typename Real> static inline Real calcMercatorEasting (const MercatorTerms <Real>& terms, Real lon) {
+    auto delta = lon - terms.lon;
+
+    if (delta >= (Real) PI)
+        delta = lon - terms.lonEast;
+    else if (delta < - (Real) PI)
+        delta = lon - terms.lonWest;
+
+    return delta * terms.scale;
+}
+
+template <typename Real> static inline Real calcMercatorLon (const MercatorTerms <Real>& terms, Real easting) {
+    auto delta = easting * terms.invScale;
+    auto lon = terms.lon + delta;
+
+    if (lon >= (Real) PI)
+        lon = terms.lonWest + delta;
+    else if (lon < - (Real) PI)
+        lon = terms.lonEast + delta;
+
+    return lon;
+}
+
+// Latitude by the isometric latitude difference from the origin
+template <typename Real> static inline Real findMercatorLat (const MercatorTerms <Real>& terms, Real deltaIso) {
+    return findIsoLatRoot (terms.eccentricity, terms.lat, terms.isoLat, deltaIso);
+}
+
+// Ellipsoidal Mercator relative to the chart origin: easting from the origin meridian, northing from the origin
+// parallel, both in miles of the equator scaled by k0. Points out of the latitude range give zeros
+template <typename Real> bool projectMercatorT (const Ellipsoid *ellipsoid, const Pos *origin, double k0, const Real *lat, const Real *lon, size_t count,
+                                                Real *easting, Real *northing) {
+    MercatorTerms <Real> terms;
+
+    if (!lat || !lon || !easting || !northing || !initMercatorTerms (ellipsoid, origin, k0, & terms)) return false;
+
+    bool result = true;
+
+    for (size_t i = 0; i < count; ++ i) {
+        if (!(fabs (lat [i]) < (Real) HALF_PI) || !(fabs (lon [i]) <= (Real) TWO_PI)) {
+            easting [i] = northing [i] = 0;
+            result = false;
+            continue;
+        }
+
+        easting [i] = calcMercatorEasting (terms, lon [i]);
+        northing [i] = deltaIsoLat (terms.eccentricity, terms.lat, lat [i]) * terms.scale;
+    }
+
+    return result;
+}
+
+template <typename Real> bool unprojectMercatorT (const Ellipsoid *ellipsoid, const Pos *origin, double k0, const Real *easting, const Real *northing, size_t count,
+                                                  Real *lat, Real *lon) {
+    MercatorTerms <Real> terms;
+
+    if (!easting || !northing || !lat || !lon || !initMercatorTerms (ellipsoid, origin, k0, & terms)) return false;
+
+    bool result = true;
+
+    for (size_t i = 0; i < count; ++ i) {
+        if (invalidVal ((double) easting [i]) || invalidVal ((double) northing [i])) {
+            lat [i] = lon [i] = 0;
+            result = false;
+            continue;
+        }
+
+        lat [i] = findMercatorLat (terms, northing [i] * terms.invScale);
+        lon [i] = calcMercatorLon (terms, easting [i]);
+    }
+
+    return result;
+}
+
+static const double MAX_FAST_ISO_LAT = 36.0;                          // tanh (18) is 1 in double
+
+// Terms of the exact kernels plus the conformal latitude series of the fast ones
+struct FastMercatorTerms {
+    MercatorTerms <double> base;
+    ConformalSeries series;
+};
+
+static bool initFastMercatorTerms (const Ellipsoid *ellipsoid, const Pos *origin, double k0, FastMercatorTerms *terms) {
+    if (!initMercatorTerms (ellipsoid, origin, k0, & terms->base)) return false;
+
+    initConformalSeries (terms->base.eccentricity, & terms->series);
+
+    return true;
+}
+
+// Isometric latitude by the half angle: log (tan (PI/4 + lat/2)) = log ((cos + sin) / (cos - sin)) of lat/2
+template <typename Lane> static inline Lane calcFastIsoLat (const FastMercatorTerms& terms, Lane lat) {
+    auto half = laneMul (lat, laneSplat <Lane> (0.5));
+    auto half2 = laneMul (half, half);
+    auto sinHalf = laneMul (half, calcFastPoly (half2, FAST_SIN_COEFS));
+    auto cosHalf = calcFastPoly (half2, FAST_COS_COEFS);
+    auto sinLat = laneMul (laneAdd (sinHalf, sinHalf), cosHalf);
+    auto isoLat = calcFastLog (laneDiv (laneAdd (cosHalf, sinHalf), laneSub (cosHalf, sinHalf)));
+
+    return laneSub (isoLat, calcFastEccentricityTerm (terms.series, sinLat));
+}
+
+// Conformal latitude chi = 4 atan (tan (chi/4)) with tan (chi/2) = tanh (iso/2), then the series in the eccentricity
+template <typename Lane> static inline Lane calcFastLat (const FastMercatorTerms& terms, Lane isoLat) {
+    auto one = laneSplat <Lane> (1.0);
+    auto limit = laneSplat <Lane> (MAX_FAST_ISO_LAT);
+    auto expIso = calcFastExp (laneMin (laneMax (isoLat, laneSub (laneSplat <Lane> (0.0), limit)), limit));
+    auto tanHalf = laneDiv (laneSub (expIso, one), laneAdd (expIso, one));
+    auto tanHalf2 = laneMul (tanHalf, tanHalf);
+    auto tanQuarter = laneDiv (tanHalf, laneAdd (one, laneSqrt (laneAdd (one, tanHalf2))));
+    auto chi = laneMul (laneMul (tanQuarter, laneSplat <Lane> (4.0)), calcFastPoly (laneMul (tanQuarter, tanQuarter), FAST_ATAN_COEFS));
+    auto invDenom = laneDiv (one, laneAdd (one, tanHalf2));
+
+    return calcFastGeodeticLat (terms.series, chi, laneMul (laneAdd (tanHalf, tanHalf), invDenom), laneMul (laneSub (one, tanHalf2), invDenom));
+}
+
+template <typename Lane> static inline bool projectMercatorLanes (const FastMercatorTerms& terms, const double *lat, const double *lon, double *easting, double *northing) {
+    auto zero = laneSplat <Lane> (0.0);
+    auto pi = laneSplat <Lane> (PI);
+    auto latVal = laneLoad <Lane> (lat);
+    auto lonVal = laneLoad <Lane> (lon);
+    auto valid = laneAnd (laneLess (laneAbs (latVal), laneSplat <Lane> (HALF_PI)), laneLessEqual (laneAbs (lonVal), laneSplat <Lane> (TWO_PI)));
+
+    // Invalid lanes are computed on zeros and cleared
+    latVal = laneSelect (valid, latVal, zero);
+    lonVal = laneSelect (valid, lonVal, zero);
+
+    auto delta = laneSub (lonVal, laneSplat <Lane> (terms.base.lon));
+
+    delta = laneSelect (laneLess (delta, pi), delta, laneSub (lonVal, laneSplat <Lane> (terms.base.lonEast)));
+    delta = laneSelect (laneLess (delta, laneSub (zero, pi)), laneSub (lonVal, laneSplat <Lane> (terms.base.lonWest)), delta);
+
+    auto scale = laneSplat <Lane> (terms.base.scale);
+
+    laneStore (easting, laneSelect (valid, laneMul (delta, scale), zero));
+    laneStore (northing, laneSelect (valid, laneMul (laneSub (calcFastIsoLat (terms, latVal), laneSplat <Lane> (terms.base.isoLat)), scale), zero));
+
+    return laneAll (valid);
+}
+
+template <typename Lane> static inline bool unprojectMercatorLanes (const FastMercatorTerms& terms, const double *easting, const double *northing, double *lat, double *lon) {
+    auto zero = laneSplat <Lane> (0.0);
+    auto pi = laneSplat <Lane> (PI);
+    auto eastingVal = laneLoad <Lane> (easting);
+    auto northingVal = laneLoad <Lane> (northing);
+    auto valid = laneAnd (laneLessEqual (laneAbs (eastingVal), laneSplat <Lane> (DBL_MAX)), laneLessEqual (laneAbs (northingVal), laneSplat <Lane> (DBL_MAX)));
+
+    eastingVal = laneSelect (valid, eastingVal, zero);
+    northingVal = laneSelect (valid, northingVal, zero);
+
+    auto invScale = laneSplat <Lane> (terms.base.invScale);
+    auto delta = laneMul (eastingVal, invScale);
+    auto lonVal = laneAdd (laneSplat <Lane> (terms.base.lon), delta);
+
+    lonVal = laneSelect (laneLess (lonVal, pi), lonVal, laneAdd (laneSplat <Lane> (terms.base.lonWest), delta));
+    lonVal = laneSelect (laneLess (lonVal, laneSub (zero, pi)), laneAdd (laneSplat <Lane> (terms.base.lonEast), delta), lonVal);
+
+    auto latVal = calcFastLat (terms, laneAdd (laneSplat <Lane> (terms.base.isoLat), laneMul (northingVal, invScale)));
+
+    laneStore (lat, laneSelect (valid, latVal, zero));
+    laneStore (lon, laneSelect (valid, lonVal, zero));
+
+    return laneAll (valid);
+}
+
+// Same contract as projectMercatorT <double>; AVX2 lanes (eight points in a register pair, then four) when compiled for it, SSE2 lanes, then the scalar tail
+bool projectMercatorFast (const Ellipsoid *ellipsoid, const Pos *origin, double k0, const double *lat, const double *lon, size_t count,
+                          double *easting, double *northing) {
+    FastMercatorTerms terms;
+
+    if (!lat || !lon || !easting || !northing || !initFastMercatorTerms (ellipsoid, origin, k0, & terms)) return false;
+
+    bool result = true;
+    size_t i = 0;
+
+#ifdef _USE_AVX2_
+    for (; i + 8 <= count; i += 8) result &= projectMercatorLanes <LanePair> (terms, lat + i, lon + i, easting + i, northing + i);
+    for (; i + 4 <= count; i += 4) result &= projectMercatorLanes <__m256d> (terms, lat + i, lon + i, easting + i, northing + i);
+#endif
+#ifdef _USE_SSE2_
+    for (; i + 2 <= count; i += 2) result &= projectMercatorLanes <__m128d> (terms, lat + i, lon + i, easting + i, northing + i);
+#endif
+    for (; i < count; ++ i) result &= projectMercatorLanes <double> (terms, lat + i, lon + i, easting + i, northing + i);
+
+    return result;
+}
+
+bool unprojectMercatorFast (const Ellipsoid *ellipsoid, const Pos *origin, double k0, const double *easting, const double *northing, size_t count,
+                            double *lat, double *lon) {
+    FastMercatorTerms terms;
+
+    if (!easting || !northing || !lat || !lon || !initFastMercatorTerms (ellipsoid, origin, k0, & terms)) return false;
+
+    bool result = true;
+    size_t i = 0;
+
+#ifdef _USE_AVX2_
+    for (; i + 8 <= count; i += 8) result &= unprojectMercatorLanes <LanePair> (terms, easting + i, northing + i, lat + i, lon + i);
+    for (; i + 4 <= count; i += 4) result &= unprojectMercatorLanes <__m256d> (terms, easting + i, northing + i, lat + i, lon + i);
+#endif
+#ifdef _USE_SSE2_
+    for (; i + 2 <= count; i += 2) result &= unprojectMercatorLanes <__m128d> (terms, easting + i, northing + i, lat + i, lon + i);
+#endif
+    for (; i < count; ++ i) result &= unprojectMercatorLanes <double> (terms, easting + i, northing + i, lat + i, lon + i);
+
+    return result;
+}
+
+// Batch of calcLatEquationRoot; the series and a single Newton step give the full precision for every point
+bool calcLatEquationRootBatch (double eccentricity, double begLat, const double *dNorthings, size_t count, double scaledEquRadius, double *lats) {
+    if (!dNorthings || !lats || invalidVal (begLat) || !(fabs (begLat) < HALF_PI) || !(scaledEquRadius > 0.0)) return false;
+
+    auto begIsoLat = calcIsoLat (begLat, eccentricity);
+    auto invRadius = 1.0 / scaledEquRadius;
+
+    for (size_t i = 0; i < count; ++ i) lats [i] = findIsoLatRoot (eccentricity, begLat, begIsoLat, dNorthings [i] * invRadius);
+
+    return true;
+}
+
+template bool projectMercatorT <float> (const Ellipsoid *, const Pos *, double, const float *, const float *, size_t, float *, float *);
+template bool projectMercatorT <double> (const Ellipsoid *, const Pos *, double, const double *, const double *, size_t, double *, double *);
+template bool projectMercatorT <long double> (const Ellipsoid *, const Pos *, double, const long double *, const long double *, size_t, long double *, long double *);
+
+template bool unprojectMercatorT <float> (const Ellipsoid *, const Pos *, double, const float *, const float *, size_t, float *, float *);
+template bool unprojectMercatorT <double> (const Ellipsoid *, const Pos *, double, const double *, const double *, size_t, double *, double *);
+template bool unprojectMercatorT <long double> (const Ellipsoid *, const Pos *, double, const long double *, const long double *, size_t, long double *, long double *);
+
+#ifdef __cplusplus
+}
+#endif
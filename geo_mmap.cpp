@@ -0,0 +1,119 @@
+#include <stdint.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "geo.h"
+
+#ifdef __cplusplus
+namespace geo {
+#endif
+
+bool mapFile (const char *path, bool writable, size_t size, MappedFile *file) {
+    if (!path || !file || (size > 0 && !writable)) return false;
+
+    memset (file, 0, sizeof (*file));
+
+#ifdef _WIN32
+    auto handle = CreateFileA (
+        path,
+        writable ? GENERIC_READ | GENERIC_WRITE : GENERIC_READ,
+        FILE_SHARE_READ,
+        0,
+        size > 0 ? CREATE_ALWAYS : OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL,
+        0
+    );
+
+    if (handle == INVALID_HANDLE_VALUE) return false;
+
+    if (size == 0) {
+        LARGE_INTEGER fileSize;
+
+        if (!GetFileSizeEx (handle, & fileSize) || fileSize.QuadPart == 0) {
+            CloseHandle (handle);
+            return false;
+        }
+
+        size = (size_t) fileSize.QuadPart;
+    }
+
+    auto mapping = CreateFileMappingA (handle, 0, writable ? PAGE_READWRITE : PAGE_READONLY, (DWORD) ((unsigned long long) size >> 32), (DWORD) size, 0);
+
+    if (!mapping) {
+        CloseHandle (handle);
+        return false;
+    }
+
+    auto data = MapViewOfFile (mapping, writable ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, size);
+
+    if (!data) {
+        CloseHandle (mapping);
+        CloseHandle (handle);
+        return false;
+    }
+
+    file->handle = handle;
+    file->mapping = mapping;
+#else
+    auto handle = open (path, size > 0 ? O_RDWR | O_CREAT | O_TRUNC : (writable ? O_RDWR : O_RDONLY), 0644);
+
+    if (handle < 0) return false;
+
+    if (size > 0) {
+        if (ftruncate (handle, (off_t) size) != 0) {
+            close (handle);
+            return false;
+        }
+    } else {
+        struct stat info;
+
+        if (fstat (handle, & info) != 0 || info.st_size == 0) {
+            close (handle);
+            return false;
+        }
+
+        size = (size_t) info.st_size;
+    }
+
+    auto data = mmap (0, size, writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, handle, 0);
+
+    if (data == MAP_FAILED) {
+        close (handle);
+        return false;
+    }
+
+    file->handle = (void *) (intptr_t) handle;
+#endif
+
+    file->data = data;
+    file->size = size;
+
+    return true;
+}
+
+void unmapFile (MappedFile *file) {
+    if (!file || !file->data) return;
+
+#ifdef _WIN32
+    UnmapViewOfFile (file->data);
+    CloseHandle ((HANDLE) file->mapping);
+    CloseHandle ((HANDLE) file->handle);
+#else
+    munmap (file->data, file->size);
+    close ((int) (intptr_t) file->handle);
+#endif
+
+    memset (file, 0, sizeof (*file));
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,288 @@
+#define _INTERNAL_
+
+#include <string.h>
+#include "geo.h"
+
+#if defined (_M_X64) || defined (__SSE2__)
+#define _USE_SSE2_
+#include <emmintrin.h>
+#endif
+
+#ifdef __cplusplus
+namespace geo {
+#endif
+
+static const size_t NMEA_MAX_FIELDS = 8;
+static const size_t NMEA_MAX_DIGITS = 15;
+
+static const double NMEA_POWERS_OF_TEN [] = {
+    1.0e0, 1.0e1, 1.0e2, 1.0e3, 1.0e4, 1.0e5, 1.0e6, 1.0e7, 1.0e8, 1.0e9, 1.0e10, 1.0e11, 1.0e12, 1.0e13, 1.0e14, 1.0e15,
+};
+
+// XOR of all the characters between '$' and '*'; 16 characters per step when SSE2 is available
+static inline unsigned char calcNmeaChecksum (const char *begin, const char *end) {
+    unsigned char checksum = 0;
+
+#ifdef _USE_SSE2_
+    auto accumulator = _mm_setzero_si128 ();
+
+    for (; end - begin >= 16; begin += 16) accumulator = _mm_xor_si128 (accumulator, _mm_loadu_si128 ((const __m128i *) begin));
+
+    accumulator = _mm_xor_si128 (accumulator, _mm_srli_si128 (accumulator, 8));
+    accumulator = _mm_xor_si128 (accumulator, _mm_srli_si128 (accumulator, 4));
+    accumulator = _mm_xor_si128 (accumulator, _mm_srli_si128 (accumulator, 2));
+    accumulator = _mm_xor_si128 (accumulator, _mm_srli_si128 (accumulator, 1));
+
+    checksum = (unsigned char) _mm_cvtsi128_si32 (accumulator);
+#endif
+
+    while (begin < end) checksum ^= (unsigned char) *(begin ++);
+
+    return checksum;
+}
+
+static inline int hexDigit (char chr) {
+    if (chr >= '0' && chr <= '9') return chr - '0';
+    if (chr >= 'A' && chr <= 'F') return chr - 'A' + 10;
+    if (chr >= 'a' && chr <= 'f') return chr - 'a' + 10;
+
+    return -1;
+}
+
+// Unsigned decimal number in place; false for empty or malformed field
+static inline bool parseNmeaNumber (const NmeaField& field, double *value) {
+    unsigned long long mantissa = 0;
+    size_t digits = 0, fracDigits = 0;
+    bool afterPoint = false;
+
+    for (auto chr = field.begin; chr < field.end; ++ chr) {
+        if (*chr >= '0' && *chr <= '9') {
+            if (++ digits > NMEA_MAX_DIGITS) return false;
+
+            mantissa = mantissa * 10 + (unsigned long long) (*chr - '0');
+
+            if (afterPoint) ++ fracDigits;
+        } else if (*chr == '.' && !afterPoint) {
+            afterPoint = true;
+        } else {
+            return false;
+        }
+    }
+
+    if (digits == 0) return false;
+
+    *value = (double) mantissa / NMEA_POWERS_OF_TEN [fracDigits];
+
+    return true;
+}
+
+// "ddmm.mmmm" or "dddmm.mmmm" with the world side in the next field; result is in radians
+static inline bool parseNmeaAngle (const NmeaField& value, const NmeaField& side, bool latitude, double *angle) {
+    double number;
+
+    if (!parseNmeaNumber (value, & number) || side.end - side.begin != 1) return false;
+
+    auto degrees = (double) (long long) (number * 0.01);
+    auto minutes = number - degrees * 100.0;
+
+    if (minutes >= 60.0) return false;
+
+    // Whole angle is checked as "9030.000" has the degrees in the range but is past the pole
+    degrees += minutes / 60.0;
+
+    if (degrees > (latitude ? 90.0 : 180.0)) return false;
+
+    switch (*side.begin) {
+        case 'N': if (!latitude) return false; break;
+        case 'E': if (latitude) return false; break;
+        case 'S': if (!latitude) return false; degrees = - degrees; break;
+        case 'W': if (latitude) return false; degrees = - degrees; break;
+        default: return false;
+    }
+
+    *angle = degrees * RAD_IN_DEG;
+
+    return true;
+}
+
+// "hhmmss.ss" to seconds of day; empty time gives a negative value
+static inline double parseNmeaTime (const NmeaField& field) {
+    double number;
+
+    if (!parseNmeaNumber (field, & number)) return -1.0;
+
+    auto hhmm = (long long) (number * 0.01);
+
+    return (double) (hhmm / 100) * 3600.0 + (double) (hhmm % 100) * 60.0 + (number - (double) hhmm * 100.0);
+}
+
+static inline const char *trimNmeaLine (const char *begin, const char *end) {
+    while (end > begin && (end [-1] == '\r' || end [-1] == ' ')) -- end;
+
+    return end;
+}
+
+static inline bool isFlag (const NmeaField& field, char flag) {
+    return field.end - field.begin == 1 && *field.begin == flag;
+}
+
+// Checks the sentence checksum; start points to the '$' or '!' character
+bool checkNmeaChecksum (const char *start, const char *end, const char **star) {
+    auto asterisk = (const char *) memchr (start, '*', end - start);
+
+    if (star) *star = asterisk;
+
+    return asterisk && end - asterisk >= 3 && hexDigit (asterisk [1]) >= 0 && hexDigit (asterisk [2]) >= 0 &&
+           calcNmeaChecksum (start + 1, asterisk) == (unsigned char) (hexDigit (asterisk [1]) * 16 + hexDigit (asterisk [2]));
+}
+
+// Splits the data between '<start>xxxxx,' and '*' into fields; returns the number of fields
+size_t splitNmeaFields (const char *start, const char *star, NmeaField *fields, size_t maxFields) {
+    size_t fieldCount = 0;
+
+    if (star - start < 7 || start [6] != ',') return 0;
+
+    for (auto field = start + 7; fieldCount < maxFields; ) {
+        auto comma = (const char *) memchr (field, ',', star - field);
+
+        fields [fieldCount].begin = field;
+        fields [fieldCount ++].end = comma ? comma : star;
+
+        if (!comma) break;
+
+        field = comma + 1;
+    }
+
+    return fieldCount;
+}
+
+static void parseNmeaSentence (NmeaParser *parser, const char *begin, const char *end, PosBatch *positions, void *context) {
+    auto times = (double *) context;
+    auto dollar = (const char *) memchr (begin, '$', end - begin);
+    const char *star;
+
+    if (!dollar) {
+        ++ parser->skipped;
+        return;
+    }
+
+    ++ parser->sentences;
+
+    if (!checkNmeaChecksum (dollar, end, & star)) {
+        ++ parser->badChecksums;
+        return;
+    }
+
+    // Address field is talker (2 characters) plus sentence type (3 characters)
+    NmeaField fields [NMEA_MAX_FIELDS];
+    auto fieldCount = splitNmeaFields (dollar, star, fields, NMEA_MAX_FIELDS);
+
+    if (fieldCount == 0) {
+        ++ parser->skipped;
+        return;
+    }
+
+    auto type = dollar + 3;
+    double lat, lon, time;
+    bool valid;
+
+    if (memcmp (type, "GGA", 3) == 0) {
+        valid = fieldCount >= 6 && !isFlag (fields [5], '0') &&
+                parseNmeaAngle (fields [1], fields [2], true, & lat) && parseNmeaAngle (fields [3], fields [4], false, & lon);
+        time = valid ? parseNmeaTime (fields [0]) : -1.0;
+    } else if (memcmp (type, "RMC", 3) == 0) {
+        valid = fieldCount >= 6 && isFlag (fields [1], 'A') &&
+                parseNmeaAngle (fields [2], fields [3], true, & lat) && parseNmeaAngle (fields [4], fields [5], false, & lon);
+        time = valid ? parseNmeaTime (fields [0]) : -1.0;
+    } else if (memcmp (type, "GLL", 3) == 0) {
+        // Status field has been added in NMEA 2.0
+        valid = fieldCount >= 4 && (fieldCount < 6 || !isFlag (fields [5], 'V')) &&
+                parseNmeaAngle (fields [0], fields [1], true, & lat) && parseNmeaAngle (fields [2], fields [3], false, & lon);
+        time = valid && fieldCount >= 5 ? parseNmeaTime (fields [4]) : -1.0;
+    } else {
+        valid = false;
+    }
+
+    if (!valid) {
+        ++ parser->skipped;
+        return;
+    }
+
+    positions->lat [positions->count] = lat;
+    positions->lon [positions->count] = lon;
+
+    if (times) times [positions->count] = time;
+
+    ++ positions->count;
+    ++ parser->fixes;
+}
+
+// Splits the data into lines and passes them to the handler while the output batch has room. Returns the
+// number of bytes consumed; the incomplete line at the end of the data is kept in the parser and completed
+// by the next call
+size_t scanNmeaSentences (NmeaParser *parser, const char *data, size_t size, NmeaSentenceHandler handler, PosBatch *output, void *context) {
+    if (!parser || !data || !output || output->count >= output->capacity) return 0;
+
+    auto ptr = data;
+    auto dataEnd = data + size;
+
+    if (parser->carryLength > 0) {
+        auto lineEnd = (const char *) memchr (ptr, '\n', size);
+        auto tail = (size_t) ((lineEnd ? lineEnd : dataEnd) - ptr);
+
+        // Full carry buffer means the garbage longer than any valid sentence
+        if (parser->carryLength + tail < NMEA_MAX_SENTENCE) {
+            memcpy (parser->carry + parser->carryLength, ptr, tail);
+            parser->carryLength += tail;
+        } else {
+            parser->carryLength = NMEA_MAX_SENTENCE;
+        }
+
+        if (!lineEnd) return size;
+
+        if (parser->carryLength < NMEA_MAX_SENTENCE)
+            handler (parser, parser->carry, trimNmeaLine (parser->carry, parser->carry + parser->carryLength), output, context);
+        else
+            ++ parser->skipped;
+
+        parser->carryLength = 0;
+        ptr = lineEnd + 1;
+    }
+
+    while (ptr < dataEnd && output->count < output->capacity) {
+        auto lineEnd = (const char *) memchr (ptr, '\n', dataEnd - ptr);
+
+        if (!lineEnd) {
+            auto tail = (size_t) (dataEnd - ptr);
+
+            if (tail < NMEA_MAX_SENTENCE) {
+                memcpy (parser->carry, ptr, tail);
+                parser->carryLength = tail;
+            } else {
+                parser->carryLength = NMEA_MAX_SENTENCE;
+            }
+
+            return size;
+        }
+
+        handler (parser, ptr, trimNmeaLine (ptr, lineEnd), output, context);
+
+        ptr = lineEnd + 1;
+    }
+
+    return ptr - data;
+}
+
+void initNmeaParser (NmeaParser *parser) {
+    if (parser) memset (parser, 0, sizeof (*parser));
+}
+
+// Scans the raw buffer in place and appends fixes to the batch until it is full; if the batch becomes full
+// the rest of the data should be passed again after flushing the batch
+size_t parseNmea (NmeaParser *parser, const char *data, size_t size, PosBatch *positions, double *times) {
+    return scanNmeaSentences (parser, data, size, parseNmeaSentence, positions, times);
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,360 @@
+#define _INTERNAL_
+
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <vector>
+#include "geo.h"
+
+#ifdef __cplusplus
+namespace geo {
+#endif
+
+static const char REGION_LIST_SIGNATURE [8] = { 'G', 'E', 'O', 'R', 'E', 'G', 'N', '1' };
+static const size_t REGION_LIST_ALIGNMENT = 64;
+static const size_t MAX_INDEX_SIDE = 1024;
+
+// The file is the header followed by region records, contour records, vertexes, cell starts and cell items;
+// every part starts at the 64 bytes boundary. Region contours are stored one by one, external ones first
+#pragma pack(push, 8)
+struct RegionListHeader {
+    char signature [8];
+    uint64_t regionCount, contourCount, vertexCount, itemCount;
+    uint32_t cellRows, cellCols;
+    double south, west, cellLat, cellLon;
+    uint64_t regionsOffset, contoursOffset, vertexesOffset, cellStartsOffset, cellItemsOffset;
+};
+#pragma pack(pop)
+
+static inline size_t alignRegionListOffset (size_t offset) {
+    return (offset + REGION_LIST_ALIGNMENT - 1) & ~(REGION_LIST_ALIGNMENT - 1);
+}
+
+static void initRegionListOffsets (RegionListHeader *header) {
+    header->regionsOffset = alignRegionListOffset (sizeof (*header));
+    header->contoursOffset = alignRegionListOffset (header->regionsOffset + header->regionCount * sizeof (RegionRecord));
+    header->vertexesOffset = alignRegionListOffset (header->contoursOffset + header->contourCount * sizeof (ContourRecord));
+    header->cellStartsOffset = alignRegionListOffset (header->vertexesOffset + header->vertexCount * sizeof (Pos));
+    header->cellItemsOffset = alignRegionListOffset (header->cellStartsOffset + ((uint64_t) header->cellRows * header->cellCols + 1) * sizeof (uint32_t));
+}
+
+static inline size_t getCellIndex (double value, double origin, double cellSize, size_t cellCount) {
+    auto index = (value - origin) / cellSize;
+
+    return index <= 0.0 ? 0 : (index >= (double) (cellCount - 1) ? cellCount - 1 : (size_t) index);
+}
+
+static void calcContourBounds (const Pos *vertexes, size_t count, ContourRecord *contour) {
+    contour->south = contour->west = 1.0e10;
+    contour->north = contour->east = -1.0e10;
+
+    for (size_t i = 0; i < count; ++ i) {
+        if (vertexes [i].lat < contour->south) contour->south = vertexes [i].lat;
+        if (vertexes [i].lat > contour->north) contour->north = vertexes [i].lat;
+        if (vertexes [i].lon < contour->west) contour->west = vertexes [i].lon;
+        if (vertexes [i].lon > contour->east) contour->east = vertexes [i].lon;
+    }
+}
+
+// Regions are usually built by gkCreateSingleBufferedRegion compatible code (see RegionBuffer); every region must
+// have at least one external contour of three vertexes or more
+bool writeRegionList (const char *path, const RegionBuffer *regions, size_t regionCount) {
+    if (!regions || regionCount == 0 || regionCount > UINT32_MAX) return false;
+
+    RegionListHeader header;
+
+    memset (& header, 0, sizeof (header));
+    memcpy (header.signature, REGION_LIST_SIGNATURE, sizeof (header.signature));
+
+    std::vector <RegionRecord> regionRecords (regionCount);
+    std::vector <ContourRecord> contourRecords;
+
+    for (size_t i = 0; i < regionCount; ++ i) {
+        auto region = regions + i;
+        auto record = & regionRecords [i];
+        auto contourCount = region->extContourCount + region->intContourCount;
+        auto vertexes = region->vertexes;
+
+        if (region->extContourCount < 1 || region->intContourCount < 0 || !region->contourSizes || !region->vertexes) return false;
+
+        record->firstContour = (uint32_t) contourRecords.size ();
+        record->extContourCount = (uint32_t) region->extContourCount;
+        record->intContourCount = (uint32_t) region->intContourCount;
+        record->reserved = 0;
+
+        for (auto j = 0; j < contourCount; ++ j) {
+            ContourRecord contour;
+
+            if (region->contourSizes [j] < 3) return false;
+
+            contour.firstVertex = header.vertexCount;
+            contour.vertexCount = (uint64_t) region->contourSizes [j];
+
+            calcContourBounds (vertexes, (size_t) contour.vertexCount, & contour);
+            contourRecords.push_back (contour);
+
+            vertexes += contour.vertexCount;
+            header.vertexCount += contour.vertexCount;
+        }
+
+        // Internal contours are inside the external ones so the region bounds are the external bounds
+        auto first = & contourRecords [record->firstContour];
+
+        record->south = first->south;
+        record->north = first->north;
+        record->west = first->west;
+        record->east = first->east;
+
+        for (auto j = 1; j < region->extContourCount; ++ j) {
+            if (first [j].south < record->south) record->south = first [j].south;
+            if (first [j].north > record->north) record->north = first [j].north;
+            if (first [j].west < record->west) record->west = first [j].west;
+            if (first [j].east > record->east) record->east = first [j].east;
+        }
+    }
+
+    // Index grid is about one region per cell
+    double south = regionRecords [0].south, north = regionRecords [0].north, west = regionRecords [0].west, east = regionRecords [0].east;
+
+    for (auto& record: regionRecords) {
+        if (record.south < south) south = record.south;
+        if (record.north > north) north = record.north;
+        if (record.west < west) west = record.west;
+        if (record.east > east) east = record.east;
+    }
+
+    auto side = (size_t) ceil (sqrt ((double) regionCount));
+
+    if (side > MAX_INDEX_SIDE) side = MAX_INDEX_SIDE;
+
+    header.regionCount = regionCount;
+    header.contourCount = contourRecords.size ();
+    header.cellRows = header.cellCols = (uint32_t) side;
+    header.south = south;
+    header.west = west;
+    header.cellLat = north > south ? (north - south) / (double) side : 1.0;
+    header.cellLon = east > west ? (east - west) / (double) side : 1.0;
+
+    auto cellCount = side * side;
+    std::vector <uint32_t> cellStarts (cellCount + 1, 0);
+
+    for (auto& record: regionRecords) {
+        auto row1 = getCellIndex (record.south, header.south, header.cellLat, side), row2 = getCellIndex (record.north, header.south, header.cellLat, side);
+        auto col1 = getCellIndex (record.west, header.west, header.cellLon, side), col2 = getCellIndex (record.east, header.west, header.cellLon, side);
+
+        for (auto row = row1; row <= row2; ++ row) {
+            for (auto col = col1; col <= col2; ++ col) ++ cellStarts [row * side + col + 1];
+        }
+    }
+
+    for (size_t i = 0; i < cellCount; ++ i) cellStarts [i + 1] += cellStarts [i];
+
+    header.itemCount = cellStarts [cellCount];
+
+    initRegionListOffsets (& header);
+
+    MappedFile file;
+
+    if (!mapFile (path, true, (size_t) (header.cellItemsOffset + header.itemCount * sizeof (uint32_t)), & file)) return false;
+
+    auto data = (char *) file.data;
+    auto cellItems = (uint32_t *) (data + header.cellItemsOffset);
+    auto vertexes = (Pos *) (data + header.vertexesOffset);
+    std::vector <uint32_t> cellFill (cellStarts.begin (), cellStarts.end () - 1);
+
+    memcpy (data, & header, sizeof (header));
+    memcpy (data + header.regionsOffset, regionRecords.data (), regionCount * sizeof (RegionRecord));
+    memcpy (data + header.contoursOffset, contourRecords.data (), contourRecords.size () * sizeof (ContourRecord));
+    memcpy (data + header.cellStartsOffset, cellStarts.data (), cellStarts.size () * sizeof (uint32_t));
+
+    for (size_t i = 0; i < regionCount; ++ i) {
+        auto record = & regionRecords [i];
+        auto row1 = getCellIndex (record->south, header.south, header.cellLat, side), row2 = getCellIndex (record->north, header.south, header.cellLat, side);
+        auto col1 = getCellIndex (record->west, header.west, header.cellLon, side), col2 = getCellIndex (record->east, header.west, header.cellLon, side);
+        auto contourCount = regions [i].extContourCount + regions [i].intContourCount;
+        size_t vertexCount = 0;
+
+        for (auto j = 0; j < contourCount; ++ j) vertexCount += (size_t) regions [i].contourSizes [j];
+
+        memcpy (vertexes + contourRecords [record->firstContour].firstVertex, regions [i].vertexes, vertexCount * sizeof (Pos));
+
+        for (auto row = row1; row <= row2; ++ row) {
+            for (auto col = col1; col <= col2; ++ col) cellItems [cellFill [row * side + col] ++] = (uint32_t) i;
+        }
+    }
+
+    unmapFile (& file);
+
+    return true;
+}
+
+// Counts must fit the file before the offsets are calculated from them so these never wrap
+static bool checkRegionListHeader (const RegionListHeader *header, size_t fileSize) {
+    if (fileSize < sizeof (*header) || memcmp (header->signature, REGION_LIST_SIGNATURE, sizeof (header->signature)) != 0) return false;
+
+    if (header->regionCount == 0 || header->regionCount > UINT32_MAX || header->regionCount > fileSize / sizeof (RegionRecord) ||
+        header->contourCount > fileSize / sizeof (ContourRecord) || header->vertexCount > fileSize / sizeof (Pos) ||
+        header->itemCount > fileSize / sizeof (uint32_t) || header->cellRows == 0 || header->cellCols == 0 || header->cellRows > MAX_INDEX_SIDE ||
+        header->cellCols > MAX_INDEX_SIDE) return false;
+
+    if (invalidVal (header->south) || invalidVal (header->west) || invalidVal (header->cellLat) || invalidVal (header->cellLon) ||
+        !(header->cellLat > 0.0) || !(header->cellLon > 0.0)) return false;
+
+    RegionListHeader expected;
+
+    memcpy (& expected, header, sizeof (expected));
+    initRegionListOffsets (& expected);
+
+    return memcmp (header, & expected, sizeof (expected)) == 0 && fileSize >= header->cellItemsOffset + header->itemCount * sizeof (uint32_t);
+}
+
+// Every record must stay within the parts of the file the lookups index by it
+static bool checkRegionListRecords (const RegionListHeader *header, const char *data) {
+    auto regions = (const RegionRecord *) (data + header->regionsOffset);
+    auto contours = (const ContourRecord *) (data + header->contoursOffset);
+    auto cellStarts = (const uint32_t *) (data + header->cellStartsOffset);
+    auto cellItems = (const uint32_t *) (data + header->cellItemsOffset);
+    auto cellCount = (size_t) header->cellRows * header->cellCols;
+
+    for (size_t i = 0; i < header->regionCount; ++ i) {
+        auto region = regions + i;
+
+        if (region->extContourCount < 1 ||
+            (uint64_t) region->firstContour + region->extContourCount + region->intContourCount > header->contourCount) return false;
+    }
+
+    // Even-odd rule needs three vertexes at least
+    for (size_t i = 0; i < header->contourCount; ++ i) {
+        auto contour = contours + i;
+
+        if (contour->vertexCount < 3 || contour->firstVertex > header->vertexCount || contour->vertexCount > header->vertexCount - contour->firstVertex)
+            return false;
+    }
+
+    if (cellStarts [0] != 0 || cellStarts [cellCount] != header->itemCount) return false;
+
+    for (size_t i = 0; i < cellCount; ++ i) {
+        if (cellStarts [i + 1] < cellStarts [i]) return false;
+    }
+
+    for (size_t i = 0; i < header->itemCount; ++ i) {
+        if (cellItems [i] >= header->regionCount) return false;
+    }
+
+    return true;
+}
+
+// Opening checks the header, the records and the index so no lookup leaves the file; vertexes are faulted in by the
+// lookups
+bool openRegionList (const char *path, RegionList *list) {
+    if (!list) return false;
+
+    memset (list, 0, sizeof (*list));
+
+    if (!mapFile (path, false, 0, & list->file)) return false;
+
+    auto header = (const RegionListHeader *) list->file.data;
+    auto data = (const char *) list->file.data;
+
+    if (!checkRegionListHeader (header, list->file.size) || !checkRegionListRecords (header, data)) {
+        unmapFile (& list->file);
+        return false;
+    }
+
+    list->regions = (const RegionRecord *) (data + header->regionsOffset);
+    list->contours = (const ContourRecord *) (data + header->contoursOffset);
+    list->vertexes = (const Pos *) (data + header->vertexesOffset);
+    list->cellStarts = (const unsigned int *) (data + header->cellStartsOffset);
+    list->cellItems = (const unsigned int *) (data + header->cellItemsOffset);
+    list->regionCount = (size_t) header->regionCount;
+    list->contourCount = (size_t) header->contourCount;
+    list->vertexCount = (size_t) header->vertexCount;
+    list->cellRows = header->cellRows;
+    list->cellCols = header->cellCols;
+    list->south = header->south;
+    list->west = header->west;
+    list->cellLat = header->cellLat;
+    list->cellLon = header->cellLon;
+
+    return true;
+}
+
+void closeRegionList (RegionList *list) {
+    if (!list) return;
+
+    unmapFile (& list->file);
+    memset (list, 0, sizeof (*list));
+}
+
+// Collects indexes of the regions which bounds intersect the box. A region touching several cells is reported
+// by the cell holding the south-west corner of the intersection only, so no duplicates are returned. Returns the
+// number of the regions found (may be greater than maxRegions, extra ones are not stored)
+size_t findRegions (const RegionList *list, double south, double north, double west, double east, size_t *regions, size_t maxRegions) {
+    if (!list || !list->regions || south > north || west > east) return 0;
+
+    auto row1 = getCellIndex (south, list->south, list->cellLat, list->cellRows), row2 = getCellIndex (north, list->south, list->cellLat, list->cellRows);
+    auto col1 = getCellIndex (west, list->west, list->cellLon, list->cellCols), col2 = getCellIndex (east, list->west, list->cellLon, list->cellCols);
+    size_t found = 0;
+
+    for (auto row = row1; row <= row2; ++ row) {
+        for (auto col = col1; col <= col2; ++ col) {
+            auto cell = row * list->cellCols + col;
+
+            for (auto item = list->cellItems + list->cellStarts [cell]; item < list->cellItems + list->cellStarts [cell + 1]; ++ item) {
+                auto region = list->regions + *item;
+
+                if (region->north < south || region->south > north || region->east < west || region->west > east) continue;
+
+                auto cornerLat = region->south > south ? region->south : south;
+                auto cornerLon = region->west > west ? region->west : west;
+
+                if (getCellIndex (cornerLat, list->south, list->cellLat, list->cellRows) != row ||
+                    getCellIndex (cornerLon, list->west, list->cellLon, list->cellCols) != col) continue;
+
+                if (regions && found < maxRegions) regions [found] = *item;
+
+                ++ found;
+            }
+        }
+    }
+
+    return found;
+}
+
+// Even-odd rule
+static bool isPointInContour (const RegionList *list, const ContourRecord *contour, double lat, double lon) {
+    if (lat < contour->south || lat > contour->north || lon < contour->west || lon > contour->east) return false;
+
+    auto vertexes = list->vertexes + contour->firstVertex;
+    auto count = (size_t) contour->vertexCount;
+    bool inside = false;
+
+    for (size_t i = 0, j = count - 1; i < count; j = i ++) {
+        if ((vertexes [i].lat > lat) != (vertexes [j].lat > lat) &&
+            lon < vertexes [i].lon + (vertexes [j].lon - vertexes [i].lon) * (lat - vertexes [i].lat) / (vertexes [j].lat - vertexes [i].lat))
+            inside = !inside;
+    }
+
+    return inside;
+}
+
+// The point is inside the region when it is inside any external contour and outside all the internal ones
+bool isPointInRegion (const RegionList *list, size_t region, const Pos *point) {
+    if (!list || !list->regions || !point || region >= list->regionCount) return false;
+
+    auto record = list->regions + region;
+    auto contours = list->contours + record->firstContour;
+    bool inside = false;
+
+    if (point->lat < record->south || point->lat > record->north || point->lon < record->west || point->lon > record->east) return false;
+
+    for (unsigned int i = 0; i < record->extContourCount && !inside; ++ i) inside = isPointInContour (list, contours + i, point->lat, point->lon);
+
+    for (unsigned int i = 0; i < record->intContourCount && inside; ++ i) inside = !isPointInContour (list, contours + record->extContourCount + i, point->lat, point->lon);
+
+    return inside;
+}
+
+#ifdef __cplusplus
+}
+#endif
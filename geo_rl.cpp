@@ -3,6 +3,8 @@
 #include <cstdint>
 #include <math.h>
 #include "geodefs.h"
+#include "geostats.h"
+#include "geocapture.h"
 
 #ifndef __cplusplus
 #include <stdbool.h>
@@ -12,29 +14,8 @@
 namespace geo {
 #endif
 
-bool calcRhumblinePos (bool useWgs84, Pos *origin, double range, double bearing, Pos *dest);
-bool calcRhumblineDistAndBrg (bool useWgs84, Pos *origin, Pos *dest, double *range, double *bearing);
-
-inline bool _calcRhumblinePos (bool useWgs84, double lat, double lon, double range, double bearing, double& destLat, double& destLon) {
-    Pos origin { lat, lon }, dest { 0.0, 0.0 };
-    
-    bool result = calcRhumblinePos (useWgs84, & origin, range, bearing, & dest);
-
-    if (result) {
-        destLat = dest.lat;
-        destLon = dest.lon;
-    }
-
-    return result;
-}
-
-inline bool _calcRhumblineDistAndBrg (bool useWgs84, double lat1, double lon1, double lat2, double lon2, double *range, double *bearing) {
-    Pos origin { lat1, lon1 }, dest { lat2, lon2 };
-
-    return calcRhumblineDistAndBrg (useWgs84, & origin, & dest, range, bearing);
-}
-
-bool calcRhumblineDistAndBrg (bool useWgs84, Pos *origin, Pos *dest, double *range, double *bearing) {
+// Rhumb line kernels on the ellipsoid; precision is the tolerance of the special cases (see GeoContext)
+bool calcRlInverse (const Ellipsoid& ellipsoid, double precision, const Pos *origin, const Pos *dest, double *range, double *bearing) {
     if (!origin || !dest) return false;
 
     auto begLat = origin->lat;
@@ -46,7 +27,12 @@ bool calcRhumblineDistAndBrg (bool useWgs84, Pos *origin, Pos *dest, double *ran
     if (bearing) *bearing = 0.0;
 
     if (invalidVal (begLat) || invalidVal (begLon) || invalidVal (endLat) || invalidVal (endLon) ||
-        fabs (begLat) > 10000. || fabs (begLon) > 10000. || fabs (endLat) > 10000. || fabs (endLon) > 10000.) return false;
+        fabs (begLat) > 10000. || fabs (begLon) > 10000. || fabs (endLat) > 10000. || fabs (endLon) > 10000.) {
+        GEO_COUNT_REJECT (GEO_KERNEL_RL_INVERSE);
+        return false;
+    }
+
+    GEO_PROBE (GEO_KERNEL_RL_INVERSE);
 
     normalizeLon (& begLon);
     normalizeLon (& endLon);
@@ -58,31 +44,31 @@ bool calcRhumblineDistAndBrg (bool useWgs84, Pos *origin, Pos *dest, double *ran
     else if (lonDiff > PI) lonDiff -= TWO_PI;
 
     auto latDif = endLat - begLat;
-    auto eccentricity = sqrt (WGS84_FLATTENING * 2.0 - WGS84_FLATTENING * WGS84_FLATTENING);
+    auto eccentricity = sqrt (ellipsoid.flattening * 2.0 - ellipsoid.flattening * ellipsoid.flattening);
 
     // Test special case of same meridian
-	if (fabs (latDif) < DEFPRECISION) {
+	if (fabs (latDif) < precision) {
         auto partial = eccentricity * sin (endLat);
 		
         if (bearing) *bearing = lonDiff > 0.0 ? HALF_PI : HALF_OF_THREE_PI;
-		if (range) *range = fabs (WGS84_EQUAT_RAD_M / METERS_IN_NM * lonDiff * cos (endLat) / sqrt (1.0 - partial * partial));
+		if (range) *range = fabs (ellipsoid.equRadius / METERS_IN_NM * lonDiff * cos (endLat) / sqrt (1.0 - partial * partial));
 
         return true;
 	}
 
     // Special case of parallel sailings
-	if (fabs (lonDiff) < DEFPRECISION) {
-        auto meridDist = meridionalDist (endLat, eccentricity, WGS84_EQUAT_RAD_M) - meridionalDist(begLat, eccentricity, WGS84_EQUAT_RAD_M);
+	if (fabs (lonDiff) < precision) {
+        auto meridDist = meridionalDist (endLat, eccentricity, ellipsoid.equRadius) - meridionalDist(begLat, eccentricity, ellipsoid.equRadius);
 		
         if (range) *range = fabs (meridDist);
-		if (bearing) *bearing = latDif > 0.0 ? 0.0 : 180.0;
+		if (bearing) *bearing = latDif > 0.0 ? 0.0 : PI;
 
         return true;
 	}	
 
     // General case
 	auto meridionalDiff = meridionalPart (endLat, eccentricity) - meridionalPart(begLat, eccentricity);
-	auto meridDistDiff  = meridionalDist (endLat, eccentricity, WGS84_EQUAT_RAD_M) - meridionalDist (begLat, eccentricity, WGS84_EQUAT_RAD_M);
+	auto meridDistDiff  = meridionalDist (endLat, eccentricity, ellipsoid.equRadius) - meridionalDist (begLat, eccentricity, ellipsoid.equRadius);
 	
     auto brg = atan2 (DEG_IN_RAD * lonDiff, meridionalDiff);
     auto rng = meridDistDiff / cos (brg);
@@ -95,11 +81,66 @@ bool calcRhumblineDistAndBrg (bool useWgs84, Pos *origin, Pos *dest, double *ran
     return true;
 }
 
+// Rhumb line inverse by the mean latitude scale; the line longer than stepDistance (miles) is split after the first step,
+// the rest is solved by calcRlInverse and the bearing is the mean of both. Points must be checked by the caller
+bool calcRlInverseSplit (const Ellipsoid& ellipsoid, double precision, double stepDistance, const Pos *origin, const Pos *dest, double *range,
+                         double *bearing) {
+    GEO_PROBE (GEO_KERNEL_RL_INVERSE_SPLIT);
+
+    auto begLat = origin->lat;
+    auto begLon = origin->lon;
+    auto endLat = dest->lat;
+    auto endLon = dest->lon;
+
+    normalizeLon (& begLon);
+    normalizeLon (& endLon);
+
+    auto westLonDiff  = fmod (endLon - begLon, TWO_PI);
+    auto eastLonDiff  = fmod (begLon - endLon, TWO_PI);
+    auto middleLat    = (begLat + endLat) * 0.5;
+    auto eccentricity = sqrt (ellipsoid.flattening + ellipsoid.flattening - ellipsoid.flattening * ellipsoid.flattening);
+    auto tempValue    = eccentricity * sin (middleLat);
+    auto scaleCoef    = cos (middleLat) / sqrt (1.0 - tempValue * tempValue);
+    auto scaledEquRadius = scaleCoef * ellipsoid.equRadius / METERS_IN_NM;
+    auto deltaPhi     = deltaPhiInline (eccentricity, begLat, endLat);
+    auto rng = hypoLen (scaledEquRadius * (westLonDiff < eastLonDiff ? westLonDiff : eastLonDiff), scaledEquRadius * deltaPhi);
+    auto brg = fmod (atan2 (westLonDiff < eastLonDiff ? westLonDiff : -eastLonDiff, deltaPhi), TWO_PI);
+
+    // Distance too big - must be splitted...
+    if (rng > stepDistance) {
+        Pos begin { begLat, begLon }, middle;
+        double milesLeft, midBrg;
+
+        GEO_PROBE_ITERATIONS (1);
+
+        // One step by elementary step distance, then the rest in one piece
+        if (!calcRlDirect (ellipsoid, precision, & begin, stepDistance, brg, & middle) ||
+            !calcRlInverse (ellipsoid, precision, & middle, dest, & milesLeft, & midBrg)) return false;
+
+        rng = stepDistance + milesLeft;
+        brg = (brg + midBrg) * 0.5;
+    }
+
+    if (range) *range = rng;
+    if (bearing) *bearing = brg;
+
+    return true;
+}
+
+bool calcRhumblineDistAndBrg (bool useWgs84, Pos *origin, Pos *dest, double *range, double *bearing) {
+    CallCapture capture (GEO_CALL_RL_DIST_BRG, useWgs84, origin, dest);
+
+    return capture.finish (calcRlInverse (WGS84_ELLIPSOID, DEFPRECISION, origin, dest, range, bearing), range, bearing, 0);
+}
+
 bool calcRhumblineDistAndBrg2 (bool useWgs84, Pos *origin, Pos *dest, double *range, double *bearing) {
     if (range) *range = 0.0f;
     if (bearing) *bearing = 0.0f;
 
-    if (!geo::checkPos (origin) || !geo::checkPos (dest)) return false;
+    if (!geo::checkPos (origin) || !geo::checkPos (dest)) {
+        GEO_COUNT_REJECT (GEO_KERNEL_RL_INVERSE_SPLIT);
+        return false;
+    }
 
     double begLat = origin->lat;
     double begLon = origin->lon;
@@ -115,7 +156,10 @@ bool calcRhumblineDistAndBrg2 (bool useWgs84, Pos *origin, Pos *dest, double *ra
     normalizeLon (& begLon);
     normalizeLon (& endLon);
 
-    if (!checkSegmentRag (begLat, begLon, endLat, endLon, true, false)) return false;
+    if (!checkSegmentRag (begLat, begLon, endLat, endLon, true, false)) {
+        GEO_COUNT_REJECT (GEO_KERNEL_RL_INVERSE_SPLIT);
+        return false;
+    }
 
     auto latDiff     = endLat - begLat;
     auto westLonDiff = fmod (endLon - begLon, TWO_PI);
@@ -127,6 +171,8 @@ bool calcRhumblineDistAndBrg2 (bool useWgs84, Pos *origin, Pos *dest, double *ra
     if (tangentRate <= 0.0) return false;
     
     if (!useWgs84) {
+        GEO_PROBE (GEO_KERNEL_RL_INVERSE_SPLIT);
+
         if (begLat == endLat) {
             // Rhumb line lays on the equator
             dirCosine = cos (begLat); 
@@ -145,49 +191,17 @@ bool calcRhumblineDistAndBrg2 (bool useWgs84, Pos *origin, Pos *dest, double *ra
             *bearing  = fmod (atan2 (eastLonDiff, deltaPhi), TWO_PI);
             *range = hypoLen (dirCosine * eastLonDiff, latDiff) * MILES_IN_RAD;
         }
-    } else {
-        // Use known ellipsoid
-        double  deltaEasting,
-                deltaNorthing,
-                scaleCoef,
-                stepDistance = STEP_RANGE,
-                middleLat    = (begLat + endLat) * 0.5,
-                eccentricity = sqrt (WGS84_FLATTENING + WGS84_FLATTENING - WGS84_FLATTENING * WGS84_FLATTENING),
-                tempValue    = eccentricity * sin (middleLat),
-                scaledEquRadius;
-
-        scaleCoef       = cos (middleLat) / sqrt (1.0 - tempValue * tempValue);
-        scaledEquRadius = scaleCoef * WGS84_EQUAT_RAD_M / METERS_IN_NM;
-        deltaPhi        = deltaPhiInline (eccentricity, begLat, endLat);
-
-        deltaEasting  = scaledEquRadius * (westLonDiff < eastLonDiff ? westLonDiff : eastLonDiff);
-        deltaNorthing = scaledEquRadius * deltaPhi;
-                                
-        *range   = hypoLen (deltaEasting, deltaNorthing);
-        *bearing = fmod (atan2 (westLonDiff < eastLonDiff ? westLonDiff : -eastLonDiff, deltaPhi), TWO_PI);
-
-        // Distance too big - must be splitted...
-        if (*range > stepDistance) {
-            double midLat, midLon, milesLeft, midBrg;
-
-            // One step by elementary step distance...
-            if (!_calcRhumblinePos (true, begLat, begLon, stepDistance, *bearing, midLat, midLon)) return false;
-
-            // Calc distance for rest of distance (this may be splitted too...)
-            if (!_calcRhumblineDistAndBrg (true, midLat, midLon, endLat, endLon, & milesLeft, & midBrg)) return false;
-
-            *range   = stepDistance + milesLeft;
-            *bearing = (*bearing + midBrg) * 0.5;
-        }
+    } else if (!calcRlInverseSplit (WGS84_ELLIPSOID, DEFPRECISION, STEP_RANGE, origin, dest, range, bearing)) {
+        return false;
     }
 
     return true;
 }
 
-bool calcRhumblinePos (bool useWgs84, Pos *origin, double range, double bearing, Pos *dest) {
+bool calcRlDirect (const Ellipsoid& ellipsoid, double precision, const Pos *origin, double range, double bearing, Pos *dest) {
     if (!origin || !dest) return false;
 
-    auto eccentricity = sqrt (WGS84_FLATTENING + WGS84_FLATTENING - WGS84_FLATTENING * WGS84_FLATTENING);
+    auto eccentricity = sqrt (ellipsoid.flattening + ellipsoid.flattening - ellipsoid.flattening * ellipsoid.flattening);
     auto begLat = origin->lat;
     auto begLon = origin->lon;
     auto endLat = begLat;
@@ -196,23 +210,28 @@ bool calcRhumblinePos (bool useWgs84, Pos *origin, double range, double bearing,
     dest->lat = dest->lon = 0.0;
 
     // Belousov 4.4.0.16
-    if (invalidVal (begLat) || invalidVal (begLon) || invalidVal (range) || invalidVal (bearing) || fabs (bearing) > 10000. || range > 50000. || range < 0.0) return false;
+    if (invalidVal (begLat) || invalidVal (begLon) || invalidVal (range) || invalidVal (bearing) || fabs (bearing) > 10000. || range > 50000. || range < 0.0) {
+        GEO_COUNT_REJECT (GEO_KERNEL_RL_DIRECT);
+        return false;
+    }
+
+    GEO_PROBE (GEO_KERNEL_RL_DIRECT);
 
     normalizeAngle (& bearing);
     normalizeLon (& begLon);
 
-    if (fabs (bearing) < DEFPRECISION || fabs (bearing - PI) < DEFPRECISION) {
+    if (fabs (bearing) < precision || fabs (bearing - PI) < precision) {
         // Special case for course of 0 or 180 degrees
-	    endLat = findEndLat (begLat, bearing, range, eccentricity, WGS84_EQUAT_RAD_M);
-    } else if (fabs (bearing - HALF_PI) < DEFPRECISION || fabs (bearing - HALF_OF_THREE_PI) < DEFPRECISION) {
+	    endLat = findEndLat (begLat, bearing, range, eccentricity, ellipsoid.equRadius);
+    } else if (fabs (bearing - HALF_PI) < precision || fabs (bearing - HALF_OF_THREE_PI) < precision) {
     	// Special case for course of 90 or 270
         auto partial  = eccentricity * sin (begLat);
-        auto longDist = (range * sqrt (1.0 - partial * partial) / WGS84_EQUAT_RAD_M / METERS_IN_NM * cos (begLat));
+        auto longDist = range * METERS_IN_NM * sqrt (1.0 - partial * partial) / (ellipsoid.equRadius * cos (begLat));
         
-        endLon += fabs (bearing - HALF_PI) < DEFPRECISION ? longDist : - longDist;
+        endLon += fabs (bearing - HALF_PI) < precision ? longDist : - longDist;
     } else {
         // General case
-        endLat = findEndLat (begLat, bearing, range, eccentricity, WGS84_EQUAT_RAD_M);
+        endLat = findEndLat (begLat, bearing, range, eccentricity, ellipsoid.equRadius);
 
         auto endLatDeg     = endLat * DEG_IN_RAD;
         auto meridPartDiff = meridionalPart (endLat, eccentricity) - meridionalPart (begLat, eccentricity);
@@ -233,6 +252,208 @@ bool calcRhumblinePos (bool useWgs84, Pos *origin, double range, double bearing,
     return true;
 }
 
+bool calcRhumblinePos (bool useWgs84, Pos *origin, double range, double bearing, Pos *dest) {
+    CallCapture capture (GEO_CALL_RL_POS, useWgs84, origin, range, bearing);
+
+    return capture.finish (calcRlDirect (WGS84_ELLIPSOID, DEFPRECISION, origin, range, bearing, dest), dest ? & dest->lat : 0, dest ? & dest->lon : 0, 0);
+}
+
+// Calculate a series of rhumb line end positions from the same origin.
+// The destination buffer must be able to hold count points, invalid range/bearing pairs give zero positions
+bool calcRhumblinePosBatch (bool useWgs84, Pos *origin, const double *ranges, const double *bearings, size_t count, PosBatch *dest) {
+    if (!origin || !ranges || !bearings || !dest || dest->capacity < count) return false;
+
+    bool result = true;
+
+    for (size_t i = 0; i < count; ++ i) {
+        Pos point;
+
+        if (!calcRhumblinePos (useWgs84, origin, ranges [i], bearings [i], & point)) result = false;
+
+        dest->lat [i] = point.lat;
+        dest->lon [i] = point.lon;
+    }
+
+    dest->count = count;
+
+    return result;
+}
+
+// Meridian distance difference (miles) in the difference form, same series as meridionalDist
+template <typename Real> static inline Real deltaMeridDist (Real begLat, Real endLat, Real eccentricity, Real equRadius) {
+    auto e2 = eccentricity * eccentricity;
+    auto e4 = e2 * e2;
+    auto e6 = e4 * e2;
+    auto v1 = (Real) 1 - e2 / (Real) 4 - (Real) 3 * e4 / (Real) 64 - (Real) 0.01953125 /*5.0 / 256.0*/ * e6;
+    auto v2 = (Real) 0.375 /*3.0 / 8.0*/ * (e2 + e4 / (Real) 4 + (Real) 0.1171875 /*15.0 / 128.0*/ * e6);
+    auto v3 = (Real) 0.05859375 /*15.0 / 256.0*/ * (e4 + (Real) 0.75 /*3.0 / 4.0*/ * e6);
+    auto v5 = (Real) 0.011393229166666666 /*35.0 / 3072.0*/ * e6;
+    auto delta = endLat - begLat;
+    auto sum = endLat + begLat;
+
+    return equRadius / (Real) METERS_IN_NM * (v1 * delta - (Real) 2 * v2 * cos (sum) * sin (delta) + (Real) 2 * v3 * cos (sum + sum) * sin (delta + delta) -
+                                              (Real) 2 * v5 * cos ((Real) 3 * sum) * sin ((Real) 3 * delta));
+}
+
+// End latitude by the meridian distance along the line; solved for the latitude difference (Newton steps on
+// deltaMeridDist) so the result keeps the type precision relative to the step rather than to the latitude
+template <typename Real> static inline Real findEndLatDelta (Real begLat, Real bearing, Real range, Real eccentricity, Real equRadius) {
+    auto e2 = eccentricity * eccentricity;
+    auto e4 = e2 * e2;
+    auto e6 = e4 * e2;
+    auto v1 = (Real) 1 - e2 / (Real) 4 - (Real) 3 * e4 / (Real) 64 - (Real) 0.01953125 /*5.0 / 256.0*/ * e6;
+    auto v2 = (Real) 0.375 /*3.0 / 8.0*/ * (e2 + e4 / (Real) 4 + (Real) 0.1171875 /*15.0 / 128.0*/ * e6);
+    auto v3 = (Real) 0.05859375 /*15.0 / 256.0*/ * (e4 + (Real) 0.75 /*3.0 / 4.0*/ * e6);
+    auto v4 = equRadius / (Real) METERS_IN_NM;
+    auto v5 = (Real) 0.011393229166666666 /*35.0 / 3072.0*/ * e6;
+    auto meridRng = range * cos (bearing);
+    auto delta = meridRng / v4;
+
+    for (auto iteration = 0; iteration < 4; ++ iteration) {
+        auto lat = begLat + delta;
+
+        delta += (meridRng - deltaMeridDist (begLat, lat, eccentricity, equRadius)) /
+                 (v4 * (v1 - (Real) 2 * v2 * cos (lat + lat) + (Real) 4 * v3 * cos ((Real) 4 * lat) - (Real) 6 * v5 * cos ((Real) 6 * lat)));
+    }
+
+    return begLat + delta;
+}
+
+// Direct problem kernel of calcRlDirect templated over the arithmetic type; special cases use the type precision
+template <typename Real> static inline void calcRlPosKernel (Real eccentricity, Real equRadius, Real begLat, Real begLon, Real range, Real bearing, Real *endLat, Real *endLon) {
+    const auto precision = KernelTraits <Real>::precision;
+    auto lat = begLat;
+    auto lon = begLon;
+
+    normalizeAngle (& bearing);
+
+    if (fabs (bearing) < precision || fabs (bearing - (Real) PI) < precision) {
+        lat = findEndLatDelta (begLat, bearing, range, eccentricity, equRadius);
+    } else if (fabs (bearing - (Real) HALF_PI) < precision || fabs (bearing - (Real) HALF_OF_THREE_PI) < precision) {
+        auto partial  = eccentricity * sin (begLat);
+        auto longDist = range * (Real) METERS_IN_NM * sqrt ((Real) 1 - partial * partial) / (equRadius * cos (begLat));
+
+        lon += fabs (bearing - (Real) HALF_PI) < precision ? longDist : - longDist;
+    } else {
+        lat = findEndLatDelta (begLat, bearing, range, eccentricity, equRadius);
+
+        // Longitude difference is the east/west distance times the ratio of the isometric latitude and meridian
+        // distance differences. Both differences come from the same end latitude so the ratio stays accurate
+        // when the latitude step is short (nearly east/west bearings) even in the single precision
+        auto deltaLat = lat - begLat;
+        Real ratio;
+
+        if (fabs (deltaLat) < precision) {
+            auto partial = eccentricity * sin (begLat);
+
+            ratio = (Real) METERS_IN_NM * sqrt ((Real) 1 - partial * partial) / (equRadius * cos (begLat));
+        } else {
+            ratio = deltaIsoLat (eccentricity, begLat, lat) / deltaMeridDist (begLat, lat, eccentricity, equRadius);
+        }
+
+        lon += range * sin (bearing) * ratio;
+    }
+
+    if (lon > (Real) PI)
+        lon -= (Real) TWO_PI;
+    else if (lon < - (Real) PI)
+        lon += (Real) TWO_PI;
+
+    *endLat = lat;
+    *endLon = lon;
+}
+
+// Batch direct problem over the arithmetic type, one origin for all the points; invalid range/bearing pairs
+// give zero positions
+template <typename Real> bool calcRhumblinePosT (const Ellipsoid *ellipsoid, const Pos *origin, const Real *ranges, const Real *bearings, size_t count, Real *lat, Real *lon) {
+    if (!origin || !ranges || !bearings || !lat || !lon || invalidVal (origin->lat) || invalidVal (origin->lon)) return false;
+
+    auto el = ellipsoid ? *ellipsoid : WGS84_ELLIPSOID;
+    auto eccentricity = (Real) sqrt (el.flattening + el.flattening - el.flattening * el.flattening);
+    auto begLon = origin->lon;
+    bool result = true;
+
+    normalizeLon (& begLon);
+
+    for (size_t i = 0; i < count; ++ i) {
+        if (invalidVal ((double) ranges [i]) || invalidVal ((double) bearings [i]) || ranges [i] < (Real) 0 || ranges [i] > (Real) 50000) {
+            lat [i] = lon [i] = 0;
+            result = false;
+            continue;
+        }
+
+        calcRlPosKernel (eccentricity, (Real) el.equRadius, (Real) origin->lat, (Real) begLon, ranges [i], bearings [i], lat + i, lon + i);
+    }
+
+    return result;
+}
+
+template bool calcRhumblinePosT <float> (const Ellipsoid *, const Pos *, const float *, const float *, size_t, float *, float *);
+template bool calcRhumblinePosT <double> (const Ellipsoid *, const Pos *, const double *, const double *, size_t, double *, double *);
+template bool calcRhumblinePosT <long double> (const Ellipsoid *, const Pos *, const long double *, const long double *, size_t, long double *, long double *);
+
+// Inverse problem kernel over the arithmetic type; the isometric latitude and the meridian distance differences are
+// taken in the difference form and the range is the leg times their ratio, so short and nearly east/west legs keep
+// the type precision relative to the leg without the special cases of the precision (those are off by the precision
+// in float). Only the legs along the parallel need their own formula
+template <typename Real> static inline void calcRlDistBrgKernel (Real eccentricity, Real equRadius, Real begLat, Real begLon, Real endLat, Real endLon, Real *range, Real *bearing) {
+    auto lonDiff = endLon - begLon;
+
+    if (lonDiff <= - (Real) PI) lonDiff += (Real) TWO_PI;
+    else if (lonDiff > (Real) PI) lonDiff -= (Real) TWO_PI;
+
+    if (endLat == begLat) {
+        auto partial = eccentricity * sin (endLat);
+
+        *bearing = lonDiff > (Real) 0 ? (Real) HALF_PI : (Real) HALF_OF_THREE_PI;
+        *range = fabs (equRadius / (Real) METERS_IN_NM * lonDiff * cos (endLat) / sqrt ((Real) 1 - partial * partial));
+
+        return;
+    }
+
+    auto deltaIso = deltaIsoLat (eccentricity, begLat, endLat);
+    auto brg = atan2 (lonDiff, deltaIso);
+
+    normalizeAngle (& brg);
+
+    *bearing = brg;
+    *range = hypot (lonDiff, deltaIso) * (deltaMeridDist (begLat, endLat, eccentricity, equRadius) / deltaIso);
+}
+
+// Batch inverse problem over the arithmetic type from one origin to every point; the poles and invalid points give
+// zeros
+template <typename Real> bool calcRhumblineDistAndBrgT (const Ellipsoid *ellipsoid, const Pos *origin, const Real *lat, const Real *lon, size_t count, Real *ranges, Real *bearings) {
+    if (!origin || !lat || !lon || !ranges || !bearings || invalidVal (origin->lat) || invalidVal (origin->lon) || fabs (origin->lat) >= HALF_PI ||
+        fabs (origin->lon) > 10000.) return false;
+
+    auto el = ellipsoid ? *ellipsoid : WGS84_ELLIPSOID;
+    auto eccentricity = (Real) sqrt (el.flattening + el.flattening - el.flattening * el.flattening);
+    auto begLon = origin->lon;
+    bool result = true;
+
+    normalizeLon (& begLon);
+
+    for (size_t i = 0; i < count; ++ i) {
+        auto endLon = lon [i];
+
+        if (invalidVal ((double) lat [i]) || invalidVal ((double) endLon) || fabs (lat [i]) >= (Real) HALF_PI || fabs (endLon) > (Real) 10000) {
+            ranges [i] = bearings [i] = 0;
+            result = false;
+            continue;
+        }
+
+        normalizeLon (& endLon);
+
+        calcRlDistBrgKernel (eccentricity, (Real) el.equRadius, (Real) origin->lat, (Real) begLon, lat [i], endLon, ranges + i, bearings + i);
+    }
+
+    return result;
+}
+
+template bool calcRhumblineDistAndBrgT <float> (const Ellipsoid *, const Pos *, const float *, const float *, size_t, float *, float *);
+template bool calcRhumblineDistAndBrgT <double> (const Ellipsoid *, const Pos *, const double *, const double *, size_t, double *, double *);
+template bool calcRhumblineDistAndBrgT <long double> (const Ellipsoid *, const Pos *, const long double *, const long double *, size_t, long double *, long double *);
+
 #ifdef __cplusplus
 }
 #endif
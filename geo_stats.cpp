@@ -0,0 +1,268 @@
+#define _INTERNAL_
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include "geo.h"
+#include "geostats.h"
+
+#ifdef _USE_GEO_STATS_
+#include <chrono>
+#include <mutex>
+#endif
+
+#ifdef __cplusplus
+namespace geo {
+#endif
+
+static const char *KERNEL_NAMES [GEO_KERNEL_COUNT] = {
+    "gc_inverse", "gc_direct", "rl_inverse", "rl_inverse_split", "rl_direct", "local_frame", "target_updater",
+};
+
+#ifdef _USE_GEO_STATS_
+// Live threads, counters of the finished threads and the totals at the last reset
+static std::mutex registryLock;
+static ThreadStats *threads = 0;
+static KernelStats retired [GEO_KERNEL_COUNT], baseline [GEO_KERNEL_COUNT];
+
+// Clock ticks are calibrated by the steady clock since the start
+static const auto startTime = std::chrono::steady_clock::now ();
+static const auto startTicks = readTicks ();
+
+thread_local ThreadStatsHolder threadStats;
+
+static void addKernelStats (KernelStats *totals, const ThreadKernelStats *stats) {
+    totals->calls += stats->calls.load (std::memory_order_relaxed);
+    totals->iterations += stats->iterations.load (std::memory_order_relaxed);
+    totals->fallbacks += stats->fallbacks.load (std::memory_order_relaxed);
+    totals->rejects += stats->rejects.load (std::memory_order_relaxed);
+    totals->ticks += stats->ticks.load (std::memory_order_relaxed);
+
+    for (size_t i = 0; i < LATENCY_BUCKETS; ++ i) totals->latency [i] += stats->latency [i].load (std::memory_order_relaxed);
+}
+
+// Registry must be locked by the caller
+static void collectStats (KernelStats *totals) {
+    memcpy (totals, retired, sizeof (retired));
+
+    for (auto stats = threads; stats; stats = stats->next) {
+        for (size_t kernel = 0; kernel < GEO_KERNEL_COUNT; ++ kernel) addKernelStats (totals + kernel, stats->kernels + kernel);
+    }
+}
+
+ThreadStats *registerThreadStats () {
+    auto stats = new ThreadStats ();
+    std::lock_guard <std::mutex> lock (registryLock);
+
+    stats->next = threads;
+    threads = stats;
+    threadStats.stats = stats;
+
+    return stats;
+}
+
+ThreadStatsHolder::~ThreadStatsHolder () {
+    if (!stats) return;
+
+    std::lock_guard <std::mutex> lock (registryLock);
+
+    for (size_t kernel = 0; kernel < GEO_KERNEL_COUNT; ++ kernel) addKernelStats (retired + kernel, stats->kernels + kernel);
+
+    for (auto link = & threads; *link; link = & (*link)->next) {
+        if (*link == stats) {
+            *link = stats->next;
+            break;
+        }
+    }
+
+    delete stats;
+
+    stats = 0;
+}
+#endif
+
+// Totals of all the threads since the last reset; false (and zeros) if the counters are compiled out
+bool getGeoStats (GeoStats *stats) {
+    if (!stats) return false;
+
+    memset (stats, 0, sizeof (*stats));
+
+#ifdef _USE_GEO_STATS_
+    std::chrono::duration <double> elapsed = std::chrono::steady_clock::now () - startTime;
+    auto ticks = readTicks () - startTicks;
+
+    {
+        std::lock_guard <std::mutex> lock (registryLock);
+
+        collectStats (stats->kernels);
+    }
+
+    for (size_t kernel = 0; kernel < GEO_KERNEL_COUNT; ++ kernel) {
+        auto totals = stats->kernels + kernel;
+        auto base = baseline + kernel;
+
+        totals->calls -= base->calls;
+        totals->iterations -= base->iterations;
+        totals->fallbacks -= base->fallbacks;
+        totals->rejects -= base->rejects;
+        totals->ticks -= base->ticks;
+
+        for (size_t i = 0; i < LATENCY_BUCKETS; ++ i) totals->latency [i] -= base->latency [i];
+    }
+
+    stats->ticksPerSecond = elapsed.count () > 0.0 ? ticks / elapsed.count () : 1.0e9;
+
+    return true;
+#else
+    return false;
+#endif
+}
+
+// Counters of the other threads are never written here; the current totals become the baseline instead
+void resetGeoStats () {
+#ifdef _USE_GEO_STATS_
+    std::lock_guard <std::mutex> lock (registryLock);
+
+    collectStats (baseline);
+#endif
+}
+
+// Bounds of the histogram buckets in ticks
+static inline double getBucketLowerBound (size_t bucket) {
+    return bucket < 4 ? (double) bucket : ldexp (4.0 + (double) (bucket & 3), (int) (bucket >> 2) - 1);
+}
+
+static inline double getBucketUpperBound (size_t bucket) {
+    return getBucketLowerBound (bucket + 1);
+}
+
+// Upper bound (ticks) of the bucket holding the given share of the calls
+static double findLatencyQuantile (const KernelStats *stats, double share) {
+    unsigned long long count = 0, total = 0;
+
+    for (size_t i = 0; i < LATENCY_BUCKETS; ++ i) total += stats->latency [i];
+
+    for (size_t i = 0; i < LATENCY_BUCKETS; ++ i) {
+        count += stats->latency [i];
+
+        if (count > 0 && count >= share * total) return getBucketUpperBound (i);
+    }
+
+    return 0.0;
+}
+
+// Text accumulated in the caller buffer; any overflow fails the whole text
+struct TextBuffer {
+    char *text;
+    size_t size, length;
+    bool overflow;
+};
+
+static void appendText (TextBuffer *buffer, const char *format, ...) {
+    if (buffer->overflow) return;
+
+    va_list args;
+
+    va_start (args, format);
+
+    auto length = vsnprintf (buffer->text + buffer->length, buffer->size - buffer->length, format, args);
+
+    va_end (args);
+
+    if (length < 0 || (size_t) length >= buffer->size - buffer->length)
+        buffer->overflow = true;
+    else
+        buffer->length += (size_t) length;
+}
+
+static void formatStatsTable (const GeoStats *stats, TextBuffer *buffer) {
+    auto nsInTick = 1.0e9 / stats->ticksPerSecond;
+
+    appendText (buffer, "%-18s %14s %14s %12s %12s %10s %10s %10s %10s\n", "kernel", "calls", "iterations", "fallbacks", "rejects",
+                "mean ns", "p50 ns", "p99 ns", "max ns");
+
+    for (size_t kernel = 0; kernel < GEO_KERNEL_COUNT; ++ kernel) {
+        auto totals = stats->kernels + kernel;
+        auto mean = totals->calls > 0 ? (double) totals->ticks / totals->calls : 0.0;
+
+        appendText (buffer, "%-18s %14llu %14llu %12llu %12llu %10.1f %10.1f %10.1f %10.1f\n", KERNEL_NAMES [kernel], totals->calls,
+                    totals->iterations, totals->fallbacks, totals->rejects, mean * nsInTick, findLatencyQuantile (totals, 0.5) * nsInTick,
+                    findLatencyQuantile (totals, 0.99) * nsInTick, findLatencyQuantile (totals, 1.0) * nsInTick);
+    }
+}
+
+// Upper bounds (seconds) of the exposed latency histogram; the series must not change between the scrapes, so these
+// do not depend on the clock rate or on the buckets filled
+static const double LATENCY_BOUNDS [] = {
+    25.0e-9, 50.0e-9, 100.0e-9, 250.0e-9, 500.0e-9, 1.0e-6, 2.5e-6, 5.0e-6, 10.0e-6, 25.0e-6, 50.0e-6, 100.0e-6, 250.0e-6, 500.0e-6,
+    1.0e-3, 10.0e-3,
+};
+
+// Prometheus text exposition; the histogram gives the cumulative counts at every one of LATENCY_BOUNDS, a tick bucket
+// counts at the first bound not below its upper bound (never early)
+static void formatStatsExposition (const GeoStats *stats, TextBuffer *buffer) {
+    static const char *COUNTERS [] = { "calls", "iterations", "fallbacks", "rejects" };
+    static const char *COUNTER_HELP [] = {
+        "Kernel calls passed the input checks", "Kernel iterations (points of the batch kernels)", "Kernel fallbacks to the slow path",
+        "Kernel calls refused by the input checks",
+    };
+
+    auto secondsInTick = 1.0 / stats->ticksPerSecond;
+
+    for (size_t counter = 0; counter < 4; ++ counter) {
+        appendText (buffer, "# HELP geo_kernel_%s_total %s\n# TYPE geo_kernel_%s_total counter\n", COUNTERS [counter], COUNTER_HELP [counter],
+                    COUNTERS [counter]);
+
+        for (size_t kernel = 0; kernel < GEO_KERNEL_COUNT; ++ kernel) {
+            auto totals = stats->kernels + kernel;
+            unsigned long long values [] = { totals->calls, totals->iterations, totals->fallbacks, totals->rejects };
+
+            appendText (buffer, "geo_kernel_%s_total{kernel=\"%s\"} %llu\n", COUNTERS [counter], KERNEL_NAMES [kernel], values [counter]);
+        }
+    }
+
+    appendText (buffer, "# HELP geo_kernel_latency_seconds Kernel call latency\n# TYPE geo_kernel_latency_seconds histogram\n");
+
+    for (size_t kernel = 0; kernel < GEO_KERNEL_COUNT; ++ kernel) {
+        auto totals = stats->kernels + kernel;
+        unsigned long long count = 0;
+        size_t bucket = 0;
+
+        // Last tick bucket holds the longer calls as well so it is only counted at +Inf
+        for (auto bound : LATENCY_BOUNDS) {
+            for (; bucket < LATENCY_BUCKETS - 1 && getBucketUpperBound (bucket) * secondsInTick <= bound; ++ bucket) count += totals->latency [bucket];
+
+            appendText (buffer, "geo_kernel_latency_seconds_bucket{kernel=\"%s\",le=\"%g\"} %llu\n", KERNEL_NAMES [kernel], bound, count);
+        }
+
+        for (; bucket < LATENCY_BUCKETS; ++ bucket) count += totals->latency [bucket];
+
+        appendText (buffer, "geo_kernel_latency_seconds_bucket{kernel=\"%s\",le=\"+Inf\"} %llu\n", KERNEL_NAMES [kernel], count);
+        appendText (buffer, "geo_kernel_latency_seconds_sum{kernel=\"%s\"} %.9g\n", KERNEL_NAMES [kernel], totals->ticks * secondsInTick);
+        appendText (buffer, "geo_kernel_latency_seconds_count{kernel=\"%s\"} %llu\n", KERNEL_NAMES [kernel], count);
+    }
+}
+
+// Returns the length of the text written (without trailing zero) or zero if the buffer is too short
+size_t formatGeoStats (const GeoStats *stats, bool prometheus, char *buffer, size_t size) {
+    if (!stats || !buffer || size == 0 || !(stats->ticksPerSecond > 0.0)) return 0;
+
+    TextBuffer text { buffer, size, 0, false };
+
+    if (prometheus)
+        formatStatsExposition (stats, & text);
+    else
+        formatStatsTable (stats, & text);
+
+    if (text.overflow) {
+        buffer [0] = '\0';
+
+        return 0;
+    }
+
+    return text.length;
+}
+
+#ifdef __cplusplus
+}
+#endif
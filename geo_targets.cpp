@@ -0,0 +1,173 @@
+#define _INTERNAL_
+
+#include <math.h>
+#include "geo.h"
+#include "geostats.h"
+
+#ifdef __cplusplus
+namespace geo {
+#endif
+
+// Error left after the plane combination is about drift^2 * (0.1 + tan (lat)) / R (displacements along the parallels
+// are not straight and the meridians converge); the scale keeps it within half of the error limit
+static const double DRIFT_ERROR_SCALE = 2.0;
+
+bool initTargetUpdater (const Ellipsoid *ellipsoid, double maxError, TargetGeodesic *targets, size_t capacity, TargetUpdater *updater) {
+    if (!targets || !updater || invalidVal (maxError) || maxError < 0.0) return false;
+
+    updater->ellipsoid = ellipsoid ? *ellipsoid : WGS84_ELLIPSOID;
+    updater->targets = targets;
+    updater->capacity = capacity;
+    updater->count = 0;
+    updater->maxError = maxError;
+    updater->exactCount = 0;
+
+    return true;
+}
+
+// Own ship terms of the tick: radii of curvature (miles) and the Gaussian radius at the own ship latitude, squared
+// drift limit of both ships since the exact solution
+struct OwnShipTerms {
+    Pos pos;
+    double meridRadius, parallelRadius, gaussRadius, driftLimit;
+};
+
+static inline void calcRadii (const Ellipsoid& ellipsoid, double lat, double *meridRadius, double *primeRadius) {
+    auto e2 = ellipsoid.flattening * (2.0 - ellipsoid.flattening);
+    auto sinLat = sin (lat);
+    auto w2 = 1.0 - e2 * sinLat * sinLat;
+
+    *primeRadius = ellipsoid.equRadius * NM_IN_METER / sqrt (w2);
+    *meridRadius = *primeRadius * (1.0 - e2) / w2;
+}
+
+static inline void initOwnShipTerms (const Ellipsoid& ellipsoid, const Pos *ownShip, double maxError, OwnShipTerms *own) {
+    double primeRadius;
+
+    calcRadii (ellipsoid, ownShip->lat, & own->meridRadius, & primeRadius);
+
+    own->pos = *ownShip;
+    own->parallelRadius = primeRadius * cos (ownShip->lat);
+    own->gaussRadius = sqrt (own->meridRadius * primeRadius);
+    own->driftLimit = maxError * own->gaussRadius / (DRIFT_ERROR_SCALE * (0.1 + fabs (tan (ownShip->lat))));
+}
+
+// Exact solution (INVER1) and the first order displacements of the target relative to the own ship along the geodesic
+// and across it by the own ship latitude, the target latitude and the longitude difference. The across terms are the
+// bearing derivatives times the reduced length m12; m12 and the geodesic scale M21 are taken on the sphere of the
+// Gaussian radius. Same points give the local north and east
+static void solveTarget (const TargetUpdater *updater, const OwnShipTerms *own, double lat, double lon, TargetGeodesic *target) {
+    Pos dest { lat, lon };
+    double range = 0.0, bearing = 0.0, endBearing = 0.0, meridRadius, primeRadius;
+
+    if (isNotSame (lat, own->pos.lat) || isNotSame (lon, own->pos.lon))
+        calcGcInverse (updater->ellipsoid, DEFPRECISION, & own->pos, & dest, & range, & bearing, & endBearing);
+
+    calcRadii (updater->ellipsoid, lat, & meridRadius, & primeRadius);
+
+    auto sinBrg = sin (bearing), cosBrg = cos (bearing), sinEndBrg = sin (endBearing), cosEndBrg = cos (endBearing);
+    auto eastScale = primeRadius * cos (lat);
+
+    target->ownLat = own->pos.lat;
+    target->ownLon = own->pos.lon;
+    target->lat = lat;
+    target->lon = lon;
+    target->range = range;
+    target->bearing = bearing;
+    target->reducedLength = own->gaussRadius * sin (range / own->gaussRadius);
+    target->eastScale = eastScale;
+    target->alongSlope [0] = - own->meridRadius * cosBrg;
+    target->alongSlope [1] = meridRadius * cosEndBrg;
+    target->alongSlope [2] = own->parallelRadius * sinBrg;
+    target->acrossSlope [0] = own->meridRadius * sinBrg * cos (range / own->gaussRadius);
+    target->acrossSlope [1] = - meridRadius * sinEndBrg;
+    target->acrossSlope [2] = eastScale * cosEndBrg;
+}
+
+// Range (miles) and bearing (radians) from the own ship to every target. Target i keeps its slot between the calls: its
+// solution is corrected by the first order terms for the displacements of both ships since it was solved exactly,
+// and solved again once the displacements exceed the drift limit derived from the updater error limit. A slot given
+// to another target is solved again as well since the displacement is large. Invalid targets give zero range and bearing
+bool updateTargets (TargetUpdater *updater, const Pos *ownShip, const double *lat, const double *lon, size_t count, double *ranges, double *bearings) {
+    if (!updater || !ownShip || !lat || !lon || !ranges || !bearings || count > updater->capacity) return false;
+
+    Pos pos = *ownShip;
+
+    if (invalidVal (pos.lat) || invalidVal (pos.lon) || fabs (pos.lat) > HALF_PI || fabs (pos.lon) > 10000.0) {
+        GEO_COUNT_REJECT (GEO_KERNEL_TARGET_UPDATER);
+        return false;
+    }
+
+    GEO_PROBE (GEO_KERNEL_TARGET_UPDATER);
+
+    normalizeLon (& pos.lon);
+
+    OwnShipTerms own;
+    size_t exactCount = 0;
+    bool result = true;
+
+    initOwnShipTerms (updater->ellipsoid, & pos, updater->maxError, & own);
+
+    for (size_t i = 0; i < count; ++ i) {
+        auto target = updater->targets + i;
+        auto targetLon = lon [i];
+
+        if (invalidVal (lat [i]) || invalidVal (targetLon) || fabs (lat [i]) > HALF_PI || fabs (targetLon) > 10000.0) {
+            target->range = -1.0;
+            ranges [i] = bearings [i] = 0.0;
+            result = false;
+
+            GEO_COUNT_REJECT (GEO_KERNEL_TARGET_UPDATER);
+            continue;
+        }
+
+        normalizeLon (& targetLon);
+
+        auto ownDeltaLat = pos.lat - target->ownLat;
+        auto ownDeltaLon = pos.lon - target->ownLon;
+        auto deltaLat = lat [i] - target->lat;
+        auto deltaLon = targetLon - target->lon;
+
+        normalizeLon (& ownDeltaLon);
+        normalizeLon (& deltaLon);
+
+        auto ownNorth = own.meridRadius * ownDeltaLat, ownEast = own.parallelRadius * ownDeltaLon;
+        auto north = own.meridRadius * deltaLat, east = target->eastScale * deltaLon;
+        auto drift = ownNorth * ownNorth + ownEast * ownEast + north * north + east * east;
+
+        if (i >= updater->count || target->range < 0.0 || drift > own.driftLimit) {
+            solveTarget (updater, & own, lat [i], targetLon, target);
+
+            ranges [i] = target->range;
+            bearings [i] = target->bearing;
+
+            ++ exactCount;
+            continue;
+        }
+
+        // Displacements are combined with the solution in the plane, so the second order terms of the plane
+        // geometry (across^2 / range and so on) are exact
+        auto deltaLonDiff = deltaLon - ownDeltaLon;
+        auto along = target->alongSlope [0] * ownDeltaLat + target->alongSlope [1] * deltaLat + target->alongSlope [2] * deltaLonDiff;
+        auto across = target->acrossSlope [0] * ownDeltaLat + target->acrossSlope [1] * deltaLat + target->acrossSlope [2] * deltaLonDiff;
+        auto bearing = target->bearing + atan2 (across, target->reducedLength + along);
+
+        checkBearing (& bearing);
+
+        ranges [i] = hypoLen (target->range + along, across);
+        bearings [i] = bearing;
+    }
+
+    if (count > updater->count) updater->count = count;
+
+    updater->exactCount = exactCount;
+
+    GEO_PROBE_ITERATIONS (count);
+    GEO_PROBE_FALLBACKS (exactCount);
+
+    return result;
+}
+
+#ifdef __cplusplus
+}
+#endif
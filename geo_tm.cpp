@@ -0,0 +1,365 @@
+#define _INTERNAL_
+
+#include <math.h>
+#include "geo.h"
+#include "geolanes.h"
+
+#ifdef __cplusplus
+namespace geo {
+#endif
+
+static const double UTM_SCALE = 0.9996;
+static const double UTM_FALSE_EASTING = 500000.0;
+static const double UTM_FALSE_NORTHING = 10000000.0;
+static const double MAX_FAST_TM_ETA = 18.0;                           // cosh (36) still fits, tanh is 1
+
+// Kruger series of the ellipsoid by the third flattening n, 6th order (Karney, 2011); the coefficients are stored from
+// the highest one for the Clenshaw summation
+struct TmTerms {
+    double scale;                                   // k0 * rectifying radius, meters
+    double alpha [6];                               // conformal to rectifying latitude (forward)
+    double beta [6];                                // rectifying to conformal latitude (inverse)
+    ConformalSeries series;
+};
+
+static void initTmTerms (const Ellipsoid *ellipsoid, double k0, TmTerms *terms) {
+    auto el = ellipsoid ? *ellipsoid : WGS84_ELLIPSOID;
+    auto n = el.flattening / (2.0 - el.flattening);
+    auto n2 = n * n, n3 = n2 * n, n4 = n3 * n, n5 = n4 * n, n6 = n5 * n;
+
+    terms->scale = k0 * el.equRadius / (1.0 + n) * (1.0 + n2 / 4.0 + n4 / 64.0 + n6 / 256.0);
+
+    terms->alpha [5] = n / 2.0 - n2 * 2.0 / 3.0 + n3 * 5.0 / 16.0 + n4 * 41.0 / 180.0 - n5 * 127.0 / 288.0 + n6 * 7891.0 / 37800.0;
+    terms->alpha [4] = n2 * 13.0 / 48.0 - n3 * 3.0 / 5.0 + n4 * 557.0 / 1440.0 + n5 * 281.0 / 630.0 - n6 * 1983433.0 / 1935360.0;
+    terms->alpha [3] = n3 * 61.0 / 240.0 - n4 * 103.0 / 140.0 + n5 * 15061.0 / 26880.0 + n6 * 167603.0 / 181440.0;
+    terms->alpha [2] = n4 * 49561.0 / 161280.0 - n5 * 179.0 / 168.0 + n6 * 6601661.0 / 7257600.0;
+    terms->alpha [1] = n5 * 34729.0 / 80640.0 - n6 * 3418889.0 / 1995840.0;
+    terms->alpha [0] = n6 * 212378941.0 / 319334400.0;
+
+    terms->beta [5] = n / 2.0 - n2 * 2.0 / 3.0 + n3 * 37.0 / 96.0 - n4 / 360.0 - n5 * 81.0 / 512.0 + n6 * 96199.0 / 604800.0;
+    terms->beta [4] = n2 / 48.0 + n3 / 15.0 - n4 * 437.0 / 1440.0 + n5 * 46.0 / 105.0 - n6 * 1118711.0 / 3870720.0;
+    terms->beta [3] = n3 * 17.0 / 480.0 - n4 * 37.0 / 840.0 - n5 * 209.0 / 4480.0 + n6 * 5569.0 / 90720.0;
+    terms->beta [2] = n4 * 4397.0 / 161280.0 - n5 * 11.0 / 504.0 - n6 * 830251.0 / 7257600.0;
+    terms->beta [1] = n5 * 4583.0 / 161280.0 - n6 * 108847.0 / 3991680.0;
+    terms->beta [0] = n6 * 20648693.0 / 638668800.0;
+
+    initConformalSeries (sqrt (el.flattening * (2.0 - el.flattening)), & terms->series);
+}
+
+// Sum of coefs (k) sin (2k zeta) for the complex zeta = xi + i eta given by sin/cos (2 xi) and sinh/cosh (2 eta);
+// Clenshaw summation in the complex arithmetic
+template <typename Lane> static inline void calcKrugerSum (const double (&coefs) [6], Lane sinXi2, Lane cosXi2, Lane sinhEta2, Lane coshEta2,
+                                                           Lane *sumXi, Lane *sumEta) {
+    auto two = laneSplat <Lane> (2.0);
+    auto cosRe = laneMul (two, laneMul (cosXi2, coshEta2));               // 2 cos (2 zeta)
+    auto cosIm = laneSub (laneSplat <Lane> (0.0), laneMul (two, laneMul (sinXi2, sinhEta2)));
+    auto currentRe = laneSplat <Lane> (coefs [0]), currentIm = laneSplat <Lane> (0.0);
+    auto nextRe = laneSplat <Lane> (0.0), nextIm = laneSplat <Lane> (0.0);
+
+    for (auto k = 1; k < 6; ++ k) {
+        auto prevRe = laneSub (laneAdd (laneSub (laneMul (cosRe, currentRe), laneMul (cosIm, currentIm)), laneSplat <Lane> (coefs [k])), nextRe);
+        auto prevIm = laneSub (laneAdd (laneMul (cosRe, currentIm), laneMul (cosIm, currentRe)), nextIm);
+
+        nextRe = currentRe;
+        nextIm = currentIm;
+        currentRe = prevRe;
+        currentIm = prevIm;
+    }
+
+    // Times sin (2 zeta)
+    auto sinRe = laneMul (sinXi2, coshEta2);
+    auto sinIm = laneMul (cosXi2, sinhEta2);
+
+    *sumXi = laneSub (laneMul (currentRe, sinRe), laneMul (currentIm, sinIm));
+    *sumEta = laneAdd (laneMul (currentRe, sinIm), laneMul (currentIm, sinRe));
+}
+
+// Latitude and the longitude difference from the central meridian (|deltaLon| < PI/2) to x (east) and y (north)
+template <typename Lane> static inline bool projectTmLanes (const TmTerms& terms, const double *lat, const double *deltaLon, double *x, double *y) {
+    auto zero = laneSplat <Lane> (0.0);
+    auto one = laneSplat <Lane> (1.0);
+    auto latVal = laneLoad <Lane> (lat);
+    auto lonVal = laneLoad <Lane> (deltaLon);
+    auto valid = laneAnd (laneLess (laneAbs (latVal), laneSplat <Lane> (HALF_PI)), laneLess (laneAbs (lonVal), laneSplat <Lane> (HALF_PI)));
+
+    latVal = laneSelect (valid, latVal, zero);
+    lonVal = laneSelect (valid, lonVal, zero);
+
+    Lane sinLat, cosLat, sinLon, cosLon;
+
+    calcFastSinCos (latVal, & sinLat, & cosLat);
+    calcFastSinCos (lonVal, & sinLon, & cosLon);
+
+    // Conformal latitude: tan (chi) = tan (lat) sqrt (1 + sigma^2) - sigma sec (lat), sigma = sinh (e atanh (e sin (lat)));
+    // kept as the vector (sinChi, cosChi) times cos (lat) since the mapping below is homogeneous in it
+    auto eccTerm = calcFastEccentricityTerm (terms.series, sinLat);
+    auto eccTerm2 = laneMul (eccTerm, eccTerm);
+    auto sigma = laneMul (eccTerm, laneMulAdd (eccTerm2, laneMulAdd (eccTerm2, laneSplat <Lane> (1.0 / 120.0), laneSplat <Lane> (1.0 / 6.0)), one));
+    auto sinChi = laneSub (laneMul (sinLat, laneSqrt (laneMulAdd (sigma, sigma, one))), sigma);
+
+    // Spherical transverse Mercator of the conformal sphere: xi' = atan2 (sin (chi), cos (chi) cos (lon)),
+    // eta' = atanh (cos (chi) sin (lon)) = atanh (q / r); double angle functions follow algebraically
+    auto p = laneMul (cosLat, cosLon);
+    auto q = laneMul (cosLat, sinLon);
+    auto pq = laneMulAdd (sinChi, sinChi, laneMul (p, p));                          // (1 - q^2 / r^2) r^2
+    auto r = laneSqrt (laneMulAdd (q, q, pq));
+    auto invDenom = laneDiv (one, pq);
+    auto xi = calcFastAtan2 (sinChi, p);
+    auto eta = laneMul (laneSplat <Lane> (0.5), calcFastLog (laneDiv (laneAdd (r, q), laneSub (r, q))));
+    auto sinXi2 = laneMul (laneMul (laneAdd (sinChi, sinChi), p), invDenom);
+    auto cosXi2 = laneMul (laneSub (laneMul (p, p), laneMul (sinChi, sinChi)), invDenom);
+    auto sinhEta2 = laneMul (laneMul (laneAdd (q, q), r), invDenom);
+    auto coshEta2 = laneMul (laneMulAdd (q, q, laneMul (r, r)), invDenom);
+    Lane sumXi, sumEta;
+
+    calcKrugerSum (terms.alpha, sinXi2, cosXi2, sinhEta2, coshEta2, & sumXi, & sumEta);
+
+    auto scale = laneSplat <Lane> (terms.scale);
+
+    laneStore (x, laneSelect (valid, laneMul (laneAdd (eta, sumEta), scale), laneSplat <Lane> (NAN)));
+    laneStore (y, laneSelect (valid, laneMul (laneAdd (xi, sumXi), scale), laneSplat <Lane> (NAN)));
+
+    return laneAll (valid);
+}
+
+// x (east) and y (north) to the latitude and the longitude difference from the central meridian
+template <typename Lane> static inline bool unprojectTmLanes (const TmTerms& terms, const double *x, const double *y, double *lat, double *deltaLon) {
+    auto zero = laneSplat <Lane> (0.0);
+    auto one = laneSplat <Lane> (1.0);
+    auto half = laneSplat <Lane> (0.5);
+    auto invScale = laneSplat <Lane> (1.0 / terms.scale);
+    auto xi = laneMul (laneLoad <Lane> (y), invScale);
+    auto eta = laneMul (laneLoad <Lane> (x), invScale);
+    auto valid = laneAnd (laneLess (laneAbs (xi), laneSplat <Lane> (HALF_PI)), laneLess (laneAbs (eta), laneSplat <Lane> (MAX_FAST_TM_ETA)));
+
+    xi = laneSelect (valid, xi, zero);
+    eta = laneSelect (valid, eta, zero);
+
+    Lane sinXi, cosXi, sumXi, sumEta;
+
+    calcFastSinCos (xi, & sinXi, & cosXi);
+
+    auto expEta2 = calcFastExp (laneAdd (eta, eta));
+    auto invExpEta2 = laneDiv (one, expEta2);
+
+    calcKrugerSum (terms.beta, laneMul (laneAdd (sinXi, sinXi), cosXi), laneSub (one, laneMul (laneAdd (sinXi, sinXi), sinXi)),
+                   laneMul (half, laneSub (expEta2, invExpEta2)), laneMul (half, laneAdd (expEta2, invExpEta2)), & sumXi, & sumEta);
+
+    auto xiPrime = laneSub (xi, sumXi);
+    auto etaPrime = laneSub (eta, sumEta);
+    Lane sinXiPrime, cosXiPrime;
+
+    calcFastSinCos (xiPrime, & sinXiPrime, & cosXiPrime);
+
+    auto expEta = calcFastExp (etaPrime);
+    auto invExpEta = laneDiv (one, expEta);
+    auto sinhEta = laneMul (half, laneSub (expEta, invExpEta));
+    auto coshEta = laneMul (half, laneAdd (expEta, invExpEta));
+
+    // Conformal latitude and the longitude on the conformal sphere
+    auto meridianRadius = laneSqrt (laneMulAdd (sinhEta, sinhEta, laneMul (cosXiPrime, cosXiPrime)));
+    auto chi = calcFastAtan2 (sinXiPrime, meridianRadius);
+    auto lonVal = calcFastAtan2 (sinhEta, cosXiPrime);
+    auto latVal = calcFastGeodeticLat (terms.series, chi, laneDiv (sinXiPrime, coshEta), laneDiv (meridianRadius, coshEta));
+
+    laneStore (lat, laneSelect (valid, latVal, laneSplat <Lane> (NAN)));
+    laneStore (deltaLon, laneSelect (valid, lonVal, laneSplat <Lane> (NAN)));
+
+    return laneAll (valid);
+}
+
+// Both kernels work in place on the longitude differences (forward) and the coordinates less the false origin
+// (inverse) prepared by the callers and give NaN for the invalid points; the callers finish the results and
+// clear these. AVX2 lanes when compiled for it, SSE2 lanes, then the scalar tail
+static bool projectTmBatch (const TmTerms& terms, const double *lat, size_t count, double *x, double *y) {
+    bool result = true;
+    size_t i = 0;
+
+#ifdef _USE_AVX2_
+    for (; i + 4 <= count; i += 4) result &= projectTmLanes <__m256d> (terms, lat + i, x + i, x + i, y + i);
+#endif
+#ifdef _USE_SSE2_
+    for (; i + 2 <= count; i += 2) result &= projectTmLanes <__m128d> (terms, lat + i, x + i, x + i, y + i);
+#endif
+    for (; i < count; ++ i) result &= projectTmLanes <double> (terms, lat + i, x + i, x + i, y + i);
+
+    return result;
+}
+
+static bool unprojectTmBatch (const TmTerms& terms, size_t count, double *lat, double *lon) {
+    bool result = true;
+    size_t i = 0;
+
+#ifdef _USE_AVX2_
+    for (; i + 4 <= count; i += 4) result &= unprojectTmLanes <__m256d> (terms, lon + i, lat + i, lat + i, lon + i);
+#endif
+#ifdef _USE_SSE2_
+    for (; i + 2 <= count; i += 2) result &= unprojectTmLanes <__m128d> (terms, lon + i, lat + i, lat + i, lon + i);
+#endif
+    for (; i < count; ++ i) result &= unprojectTmLanes <double> (terms, lon + i, lat + i, lat + i, lon + i);
+
+    return result;
+}
+
+// Longitude difference from the central meridian in [-PI, PI]; out of range values give NaN (rejected by the kernels)
+static inline double calcTmDeltaLon (double lon, double centralMeridian) {
+    if (invalidVal (lon) || fabs (lon) > TWO_PI) return NAN;
+
+    auto delta = lon - centralMeridian;
+
+    normalizeLon (& delta);
+
+    return delta;
+}
+
+bool projectTransverseMercator (const Ellipsoid *ellipsoid, double centralMeridian, double k0, const double *lat, const double *lon, size_t count,
+                                double *x, double *y) {
+    if (!lat || !lon || !x || !y || invalidVal (centralMeridian) || fabs (centralMeridian) > TWO_PI || !(k0 > 0.0)) return false;
+
+    TmTerms terms;
+
+    initTmTerms (ellipsoid, k0, & terms);
+
+    for (size_t i = 0; i < count; ++ i) x [i] = calcTmDeltaLon (lon [i], centralMeridian);
+
+    auto result = projectTmBatch (terms, lat, count, x, y);
+
+    for (size_t i = 0; i < count; ++ i) {
+        if (invalidVal (x [i])) x [i] = y [i] = 0.0;
+    }
+
+    return result;
+}
+
+bool unprojectTransverseMercator (const Ellipsoid *ellipsoid, double centralMeridian, double k0, const double *x, const double *y, size_t count,
+                                  double *lat, double *lon) {
+    if (!x || !y || !lat || !lon || invalidVal (centralMeridian) || fabs (centralMeridian) > TWO_PI || !(k0 > 0.0)) return false;
+
+    TmTerms terms;
+
+    initTmTerms (ellipsoid, k0, & terms);
+
+    for (size_t i = 0; i < count; ++ i) {
+        lat [i] = y [i];
+        lon [i] = x [i];
+    }
+
+    auto result = unprojectTmBatch (terms, count, lat, lon);
+
+    for (size_t i = 0; i < count; ++ i) {
+        if (invalidVal (lat [i])) {
+            lat [i] = lon [i] = 0.0;
+            continue;
+        }
+
+        lon [i] += centralMeridian;
+
+        normalizeLon (& lon [i]);
+    }
+
+    return result;
+}
+
+// Zone number by the longitude with the Norway and Svalbard exceptions, negative in the southern hemisphere
+int findUtmZone (double lat, double lon) {
+    if (invalidVal (lat) || invalidVal (lon) || fabs (lon) > TWO_PI) return 0;
+
+    normalizeLon (& lon);
+
+    auto latDeg = lat * DEG_IN_RAD;
+    auto lonDeg = lon * DEG_IN_RAD;
+
+    if (latDeg < -80.0 || latDeg > 84.0) return 0;
+
+    auto zone = (int) ((lonDeg + 180.0) / 6.0) + 1;
+
+    if (zone > 60) zone = 1;
+
+    if (latDeg >= 56.0 && latDeg < 64.0 && lonDeg >= 3.0 && lonDeg < 12.0) {
+        zone = 32;
+    } else if (latDeg >= 72.0) {
+        if (lonDeg >= 0.0 && lonDeg < 9.0)
+            zone = 31;
+        else if (lonDeg >= 9.0 && lonDeg < 21.0)
+            zone = 33;
+        else if (lonDeg >= 21.0 && lonDeg < 33.0)
+            zone = 35;
+        else if (lonDeg >= 33.0 && lonDeg < 42.0)
+            zone = 37;
+    }
+
+    return lat < 0.0 ? - zone : zone;
+}
+
+static inline double getUtmCentralMeridian (int zone) {
+    auto number = zone < 0 ? - zone : zone;
+
+    return (double) (number * 6 - 183) * RAD_IN_DEG;
+}
+
+// Zone of every point is found (zone 0) or forced (e.g. to keep a survey crossing the zone border in one grid); the
+// central meridians are resolved per point first so the lanes run over any mix of the zones
+bool projectUtm (const Ellipsoid *ellipsoid, const double *lat, const double *lon, size_t count, int zone, int *zones, double *easting, double *northing) {
+    if (!lat || !lon || !easting || !northing || zone < -60 || zone > 60) return false;
+
+    TmTerms terms;
+
+    initTmTerms (ellipsoid, UTM_SCALE, & terms);
+
+    for (size_t i = 0; i < count; ++ i) {
+        auto pointZone = zone ? zone : findUtmZone (lat [i], lon [i]);
+
+        if (zones) zones [i] = pointZone;
+
+        easting [i] = pointZone ? calcTmDeltaLon (lon [i], getUtmCentralMeridian (pointZone)) : NAN;
+    }
+
+    auto result = projectTmBatch (terms, lat, count, easting, northing);
+
+    for (size_t i = 0; i < count; ++ i) {
+        if (invalidVal (easting [i])) {
+            easting [i] = northing [i] = 0.0;
+            continue;
+        }
+
+        easting [i] += UTM_FALSE_EASTING;
+
+        if (zone ? zone < 0 : lat [i] < 0.0) northing [i] += UTM_FALSE_NORTHING;
+    }
+
+    return result;
+}
+
+bool unprojectUtm (const Ellipsoid *ellipsoid, const int *zones, const double *easting, const double *northing, size_t count, double *lat, double *lon) {
+    if (!zones || !easting || !northing || !lat || !lon) return false;
+
+    TmTerms terms;
+
+    initTmTerms (ellipsoid, UTM_SCALE, & terms);
+
+    for (size_t i = 0; i < count; ++ i) {
+        auto valid = zones [i] != 0 && zones [i] >= -60 && zones [i] <= 60;
+
+        lat [i] = valid ? (zones [i] < 0 ? northing [i] - UTM_FALSE_NORTHING : northing [i]) : NAN;
+        lon [i] = easting [i] - UTM_FALSE_EASTING;
+    }
+
+    auto result = unprojectTmBatch (terms, count, lat, lon);
+
+    for (size_t i = 0; i < count; ++ i) {
+        if (invalidVal (lat [i])) {
+            lat [i] = lon [i] = 0.0;
+            continue;
+        }
+
+        lon [i] += getUtmCentralMeridian (zones [i]);
+
+        normalizeLon (& lon [i]);
+    }
+
+    return result;
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,172 @@
+#define _INTERNAL_
+
+#include <stdint.h>
+#include <string.h>
+#include "geo.h"
+
+#ifdef __cplusplus
+namespace geo {
+#endif
+
+static const char TRACK_SIGNATURE [8] = { 'G', 'E', 'O', 'T', 'R', 'A', 'K', '1' };
+static const size_t TRACK_ALIGNMENT = 64;
+
+// The file is the header, the block headers and then lat, lon and time columns; every part starts at the
+// 64 bytes boundary so the columns may be loaded by any SIMD width straight from the mapped pages
+#pragma pack(push, 8)
+struct TrackHeader {
+    char signature [8];
+    uint64_t pointCount, blockCount, blockSize;
+    uint64_t blocksOffset, latOffset, lonOffset, timeOffset;
+};
+#pragma pack(pop)
+
+static inline size_t alignTrackOffset (size_t offset) {
+    return (offset + TRACK_ALIGNMENT - 1) & ~(TRACK_ALIGNMENT - 1);
+}
+
+static void initTrackHeader (size_t count, size_t blockSize, TrackHeader *header) {
+    memcpy (header->signature, TRACK_SIGNATURE, sizeof (header->signature));
+
+    header->pointCount = count;
+    header->blockSize = blockSize;
+    header->blockCount = count / blockSize + (count % blockSize != 0 ? 1 : 0);
+    header->blocksOffset = alignTrackOffset (sizeof (*header));
+    header->latOffset = alignTrackOffset (header->blocksOffset + header->blockCount * sizeof (TrackBlock));
+    header->lonOffset = alignTrackOffset (header->latOffset + count * sizeof (double));
+    header->timeOffset = alignTrackOffset (header->lonOffset + count * sizeof (double));
+}
+
+bool writeTrackFile (const char *path, const double *lat, const double *lon, const double *time, size_t count, size_t blockSize) {
+    if (!lat || !lon || !time || count == 0 || blockSize == 0) return false;
+
+    TrackHeader header;
+    MappedFile file;
+
+    initTrackHeader (count, blockSize, & header);
+
+    if (!mapFile (path, true, (size_t) header.timeOffset + count * sizeof (double), & file)) return false;
+
+    auto data = (char *) file.data;
+    auto blocks = (TrackBlock *) (data + header.blocksOffset);
+
+    memcpy (data, & header, sizeof (header));
+    memcpy (data + header.latOffset, lat, count * sizeof (double));
+    memcpy (data + header.lonOffset, lon, count * sizeof (double));
+    memcpy (data + header.timeOffset, time, count * sizeof (double));
+
+    for (size_t i = 0; i < header.blockCount; ++ i) {
+        auto block = blocks + i;
+        auto first = i * blockSize;
+        auto last = first + blockSize < count ? first + blockSize : count;
+
+        block->first = first;
+        block->count = last - first;
+        block->south = block->north = lat [first];
+        block->west = block->east = lon [first];
+        block->beginTime = time [first];
+        block->endTime = time [last - 1];
+
+        for (auto j = first + 1; j < last; ++ j) {
+            if (lat [j] < block->south) block->south = lat [j];
+            if (lat [j] > block->north) block->north = lat [j];
+            if (lon [j] < block->west) block->west = lon [j];
+            if (lon [j] > block->east) block->east = lon [j];
+        }
+    }
+
+    unmapFile (& file);
+
+    return true;
+}
+
+// Counts are bounded by the file size before any offset is derived from them, so the layout cannot wrap
+static bool checkTrackHeader (const TrackHeader *header, size_t fileSize) {
+    if (fileSize < sizeof (*header) || memcmp (header->signature, TRACK_SIGNATURE, sizeof (header->signature)) != 0) return false;
+
+    if (header->pointCount == 0 || header->pointCount > fileSize / (sizeof (double) * 3) || header->blockSize == 0 ||
+        header->blockCount > fileSize / sizeof (TrackBlock)) return false;
+
+    TrackHeader expected;
+
+    initTrackHeader ((size_t) header->pointCount, (size_t) header->blockSize, & expected);
+
+    return memcmp (header, & expected, sizeof (expected)) == 0 && fileSize >= header->timeOffset + header->pointCount * sizeof (double);
+}
+
+// Blocks must tile the columns in order, so the points of every block are within them
+static bool checkTrackBlocks (const TrackHeader *header, const TrackBlock *blocks) {
+    uint64_t next = 0;
+
+    for (size_t i = 0; i < header->blockCount; ++ i) {
+        auto block = blocks + i;
+
+        if (block->first != next || block->count == 0 || block->count > header->blockSize || block->count > header->pointCount - block->first)
+            return false;
+
+        next = block->first + block->count;
+    }
+
+    return next == header->pointCount;
+}
+
+// Opening checks the header, the layout and the block headers only; column pages are faulted in by the readers
+bool openTrackFile (const char *path, TrackFile *track) {
+    if (!track) return false;
+
+    memset (track, 0, sizeof (*track));
+
+    if (!mapFile (path, false, 0, & track->file)) return false;
+
+    auto header = (const TrackHeader *) track->file.data;
+
+    if (!checkTrackHeader (header, track->file.size) || !checkTrackBlocks (header, (const TrackBlock *) ((const char *) track->file.data + header->blocksOffset))) {
+        unmapFile (& track->file);
+        return false;
+    }
+
+    auto data = (const char *) track->file.data;
+
+    track->blocks = (const TrackBlock *) (data + header->blocksOffset);
+    track->lat = (const double *) (data + header->latOffset);
+    track->lon = (const double *) (data + header->lonOffset);
+    track->time = (const double *) (data + header->timeOffset);
+    track->pointCount = (size_t) header->pointCount;
+    track->blockCount = (size_t) header->blockCount;
+    track->blockSize = (size_t) header->blockSize;
+
+    return true;
+}
+
+void closeTrackFile (TrackFile *track) {
+    if (!track) return;
+
+    unmapFile (& track->file);
+    memset (track, 0, sizeof (*track));
+}
+
+// Collects indexes of the blocks intersecting both the box and the time range; only the block headers are
+// touched. Returns the number of the blocks found (may be greater than maxBlocks, extra ones are not stored)
+size_t findTrackBlocks (const TrackFile *track, double south, double north, double west, double east, double beginTime, double endTime,
+                        size_t *blocks, size_t maxBlocks) {
+    if (!track || !track->blocks) return 0;
+
+    size_t found = 0;
+
+    for (size_t i = 0; i < track->blockCount; ++ i) {
+        auto block = track->blocks + i;
+
+        if (block->north < south || block->south > north || block->east < west || block->west > east ||
+            block->endTime < beginTime || block->beginTime > endTime) continue;
+
+        if (blocks && found < maxBlocks) blocks [found] = i;
+
+        ++ found;
+    }
+
+    return found;
+}
+
+#ifdef __cplusplus
+}
+#endif
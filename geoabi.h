@@ -0,0 +1,53 @@
+#pragma once
+
+#include <stddef.h>
+
+// Stable C ABI for the foreign callers (ctypes/cffi, numpy, JNI/Panama): one call runs the legacy kernel over a whole
+// batch taken from the caller buffers as they are. Every column is a pointer and a stride in bytes, so numpy arrays
+// (including the lat/lon columns of an N x 2 array and the broadcast ones of zero stride) are passed without copies.
+// Angles are in radians, ranges in miles, useWgs84 is the flag of the legacy calls. Invalid points give zeros, the
+// number of points solved is returned. Symbols carry the ABI version and are never changed once published; the names
+// without the suffix are for the C and C++ sources
+#define GEO_ABI_VERSION 1
+
+#ifdef _WIN32
+#ifdef _INTERNAL_
+#define GEO_ABI __declspec (dllexport)
+#else
+#define GEO_ABI
+#endif
+#else
+#define GEO_ABI __attribute__ ((visibility ("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+GEO_ABI int geo_abi_version (void);
+
+GEO_ABI size_t geo_rl_pos_v1 (int useWgs84, size_t count, const double *originLat, ptrdiff_t originLatStride, const double *originLon,
+                              ptrdiff_t originLonStride, const double *range, ptrdiff_t rangeStride, const double *bearing, ptrdiff_t bearingStride,
+                              double *destLat, ptrdiff_t destLatStride, double *destLon, ptrdiff_t destLonStride);
+GEO_ABI size_t geo_rl_dist_brg_v1 (int useWgs84, size_t count, const double *originLat, ptrdiff_t originLatStride, const double *originLon,
+                                   ptrdiff_t originLonStride, const double *destLat, ptrdiff_t destLatStride, const double *destLon,
+                                   ptrdiff_t destLonStride, double *range, ptrdiff_t rangeStride, double *bearing, ptrdiff_t bearingStride);
+
+// End bearing columns may be null
+GEO_ABI size_t geo_gc_pos_v1 (int useWgs84, size_t count, const double *originLat, ptrdiff_t originLatStride, const double *originLon,
+                              ptrdiff_t originLonStride, const double *range, ptrdiff_t rangeStride, const double *bearing, ptrdiff_t bearingStride,
+                              double *destLat, ptrdiff_t destLatStride, double *destLon, ptrdiff_t destLonStride, double *endBearing,
+                              ptrdiff_t endBearingStride);
+GEO_ABI size_t geo_gc_dist_brg_v1 (int useWgs84, size_t count, const double *originLat, ptrdiff_t originLatStride, const double *originLon,
+                                   ptrdiff_t originLonStride, const double *destLat, ptrdiff_t destLatStride, const double *destLon,
+                                   ptrdiff_t destLonStride, double *range, ptrdiff_t rangeStride, double *bearing, ptrdiff_t bearingStride,
+                                   double *endBearing, ptrdiff_t endBearingStride);
+
+#ifdef __cplusplus
+}
+#endif
+
+#define geo_rl_pos geo_rl_pos_v1
+#define geo_rl_dist_brg geo_rl_dist_brg_v1
+#define geo_gc_pos geo_gc_pos_v1
+#define geo_gc_dist_brg geo_gc_dist_brg_v1
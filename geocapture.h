@@ -0,0 +1,36 @@
+#pragma once
+
+#include <atomic>
+#include "geodefs.h"
+
+// Capture of the legacy calls (geo_capture.cpp)
+
+namespace geo {
+    extern std::atomic <bool> captureOn;
+
+    // Records one legacy call if the capture is on: inputs are copied before the call since the legacy API normalizes
+    // them in place, outputs after it. Calls made by another call being captured on the same thread are not recorded
+    class CallCapture {
+    public:
+        CallCapture (GeoCall call, bool useWgs84, const Pos *origin, double range, double bearing) : active (false) {
+            if (captureOn.load (std::memory_order_relaxed)) begin (call, useWgs84, origin, range, bearing);
+        }
+
+        CallCapture (GeoCall call, bool useWgs84, const Pos *origin, const Pos *dest) : active (false) {
+            if (captureOn.load (std::memory_order_relaxed)) begin (call, useWgs84, origin, dest ? dest->lat : NAN, dest ? dest->lon : NAN);
+        }
+
+        bool finish (bool result, const double *output0, const double *output1, const double *output2) {
+            if (active) commit (result, output0 ? *output0 : 0.0, output1 ? *output1 : 0.0, output2 ? *output2 : 0.0);
+
+            return result;
+        }
+
+    private:
+        GeoCallRecord record;
+        bool active;
+
+        void begin (GeoCall call, bool useWgs84, const Pos *origin, double input2, double input3);
+        void commit (bool result, double output0, double output1, double output2);
+    };
+}
@@ -0,0 +1,466 @@
+#pragma once
+
+#include "geodefs.h"
+
+// Compile time evaluation of the rhumb line and great circle problems, e.g. to bake route and separation scheme
+// tables into the binary:
+//
+//     constexpr geo::ce::Leg leg = geo::ce::calcGreatCircleLeg ({ 0.8976, 0.0 }, { 0.7106, -1.2915 });
+//
+// Math functions of the namespace are constexpr versions of the libm ones, within a few ulp of them for the
+// arguments met in navigation; domain errors give zero (or the largest value) instead of NaN/infinity. The
+// kernels follow the runtime ones (geo_rl.cpp, geo_gc.cpp) step by step so the tables match the runtime results
+namespace geo {
+namespace ce {
+    static constexpr double LN2_HI = 6.93147180369123816490e-01;
+    static constexpr double LN2_LO = 1.90821492927058770002e-10;
+    static constexpr double HALF_PI_HI = 1.57079632673412561417e+00;
+    static constexpr double HALF_PI_LO = 6.07710050650619224932e-11;
+    static constexpr double SQRT_TWO = 1.41421356237309504880;
+    static constexpr double SQRT_THREE = 1.73205080756887729353;
+    static constexpr double TAN_TWELFTH_PI = 0.26794919243112270647;
+
+    constexpr double fabs (double x) {
+        return x < 0.0 ? - x : x;
+    }
+
+    constexpr double scaleByPowerOfTwo (double x, long long exponent) {
+        for (; exponent > 0; -- exponent) x *= 2.0;
+        for (; exponent < 0; ++ exponent) x *= 0.5;
+
+        return x;
+    }
+
+    // Newton iterations from above the root decrease until the result is exact
+    constexpr double sqrt (double x) {
+        if (x <= 0.0) return 0.0;
+
+        double scale = 1.0;
+
+        for (; x > 4.0; x *= 0.25) scale *= 2.0;
+        for (; x < 0.25; x *= 4.0) scale *= 0.5;
+
+        double root = x > 1.0 ? x : 1.0;
+
+        for (auto iteration = 0; iteration < 64; ++ iteration) {
+            auto next = (root + x / root) * 0.5;
+
+            if (next >= root) break;
+
+            root = next;
+        }
+
+        return root * scale;
+    }
+
+    constexpr double exp (double x) {
+        if (x > 709.0) return DBL_MAX;
+        if (x < -745.0) return 0.0;
+
+        auto power = (long long) (x / (LN2_HI + LN2_LO) + (x < 0.0 ? -0.5 : 0.5));
+        auto r = (x - (double) power * LN2_HI) - (double) power * LN2_LO;
+        double term = 1.0, sum = 1.0;
+
+        for (auto i = 1; i < 30; ++ i) {
+            term *= r / (double) i;
+
+            if (sum + term == sum) break;
+
+            sum += term;
+        }
+
+        return scaleByPowerOfTwo (sum, power);
+    }
+
+    // Mantissa in [sqrt (0.5), sqrt (2)), then the atanh series
+    constexpr double log (double x) {
+        if (x <= 0.0) return - DBL_MAX;
+
+        long long power = 0;
+
+        for (; x > SQRT_TWO; x *= 0.5) ++ power;
+        for (; x < SQRT_TWO * 0.5; x *= 2.0) -- power;
+
+        auto s = (x - 1.0) / (x + 1.0);
+        double term = s, sum = 0.0;
+
+        for (auto i = 1; i < 64; i += 2) {
+            auto next = sum + term / (double) i;
+
+            if (next == sum) break;
+
+            sum = next;
+            term *= s * s;
+        }
+
+        return (double) power * LN2_HI + (sum * 2.0 + (double) power * LN2_LO);
+    }
+
+    constexpr double log1p (double x) {
+        auto u = 1.0 + x;
+
+        return u == 1.0 ? x : log (u) * (x / (u - 1.0));
+    }
+
+    constexpr double pow (double x, double y) {
+        return x > 0.0 ? exp (y * log (x)) : 0.0;
+    }
+
+    constexpr double sinSeries (double x) {
+        double term = x, sum = x;
+
+        for (auto i = 2; i < 40; i += 2) {
+            term *= - x * x / (double) (i * (i + 1));
+
+            if (sum + term == sum) break;
+
+            sum += term;
+        }
+
+        return sum;
+    }
+
+    constexpr double cosSeries (double x) {
+        double term = 1.0, sum = 1.0;
+
+        for (auto i = 1; i < 40; i += 2) {
+            term *= - x * x / (double) (i * (i + 1));
+
+            if (sum + term == sum) break;
+
+            sum += term;
+        }
+
+        return sum;
+    }
+
+    // Reduction to [-PI/4, PI/4] and the quadrant; two part PI/2 keeps it exact for |x| up to 1e5
+    constexpr double reduceQuadrant (double x, int *quadrant) {
+        auto count = (long long) (x / (HALF_PI_HI + HALF_PI_LO) + (x < 0.0 ? -0.5 : 0.5));
+
+        *quadrant = (int) (((count % 4) + 4) % 4);
+
+        return (x - (double) count * HALF_PI_HI) - (double) count * HALF_PI_LO;
+    }
+
+    constexpr double sin (double x) {
+        int quadrant = 0;
+        auto r = reduceQuadrant (x, & quadrant);
+
+        switch (quadrant) {
+            case 0: return sinSeries (r);
+            case 1: return cosSeries (r);
+            case 2: return - sinSeries (r);
+            default: return - cosSeries (r);
+        }
+    }
+
+    constexpr double cos (double x) {
+        int quadrant = 0;
+        auto r = reduceQuadrant (x, & quadrant);
+
+        switch (quadrant) {
+            case 0: return cosSeries (r);
+            case 1: return - sinSeries (r);
+            case 2: return - cosSeries (r);
+            default: return sinSeries (r);
+        }
+    }
+
+    constexpr double tan (double x) {
+        auto cosine = cos (x);
+
+        return cosine == 0.0 ? DBL_MAX : sin (x) / cosine;
+    }
+
+    // Argument above 1 is inverted, above tan (PI/12) is shifted by PI/6; the series converges fast after that
+    constexpr double atan (double x) {
+        auto negative = x < 0.0;
+        auto inverted = fabs (x) > 1.0;
+        double base = 0.0;
+
+        if (negative) x = - x;
+        if (inverted) x = 1.0 / x;
+
+        if (x > TAN_TWELFTH_PI) {
+            base = PI / 6.0;
+            x = (x * SQRT_THREE - 1.0) / (x + SQRT_THREE);
+        }
+
+        double term = x, sum = 0.0;
+
+        for (auto i = 1; i < 64; i += 2) {
+            auto next = sum + term / (double) i;
+
+            if (next == sum) break;
+
+            sum = next;
+            term *= - x * x;
+        }
+
+        sum += base;
+
+        if (inverted) sum = HALF_PI - sum;
+
+        return negative ? - sum : sum;
+    }
+
+    constexpr double atan2 (double y, double x) {
+        if (x > 0.0) return atan (y / x);
+        if (x < 0.0) return y >= 0.0 ? atan (y / x) + PI : atan (y / x) - PI;
+
+        return y > 0.0 ? HALF_PI : (y < 0.0 ? - HALF_PI : 0.0);
+    }
+
+    // Arithmetic type for the templated ellipsoid math of geodefs.h; its math functions below are found by the
+    // argument dependent lookup so the same templates evaluate at compile time
+    struct ConstReal {
+        double value;
+
+        constexpr ConstReal (double val = 0.0) : value (val) {}
+        constexpr explicit operator double () const { return value; }
+
+        constexpr ConstReal& operator += (ConstReal arg) { value += arg.value; return *this; }
+        constexpr ConstReal& operator -= (ConstReal arg) { value -= arg.value; return *this; }
+        constexpr ConstReal& operator *= (ConstReal arg) { value *= arg.value; return *this; }
+        constexpr ConstReal& operator /= (ConstReal arg) { value /= arg.value; return *this; }
+    };
+
+    constexpr ConstReal operator - (ConstReal arg) { return ConstReal (- arg.value); }
+    constexpr ConstReal operator + (ConstReal arg1, ConstReal arg2) { return ConstReal (arg1.value + arg2.value); }
+    constexpr ConstReal operator - (ConstReal arg1, ConstReal arg2) { return ConstReal (arg1.value - arg2.value); }
+    constexpr ConstReal operator * (ConstReal arg1, ConstReal arg2) { return ConstReal (arg1.value * arg2.value); }
+    constexpr ConstReal operator / (ConstReal arg1, ConstReal arg2) { return ConstReal (arg1.value / arg2.value); }
+
+    constexpr bool operator < (ConstReal arg1, ConstReal arg2) { return arg1.value < arg2.value; }
+    constexpr bool operator > (ConstReal arg1, ConstReal arg2) { return arg1.value > arg2.value; }
+    constexpr bool operator <= (ConstReal arg1, ConstReal arg2) { return arg1.value <= arg2.value; }
+    constexpr bool operator >= (ConstReal arg1, ConstReal arg2) { return arg1.value >= arg2.value; }
+    constexpr bool operator == (ConstReal arg1, ConstReal arg2) { return arg1.value == arg2.value; }
+    constexpr bool operator != (ConstReal arg1, ConstReal arg2) { return arg1.value != arg2.value; }
+
+    constexpr ConstReal fabs (ConstReal x) { return ConstReal (fabs (x.value)); }
+    constexpr ConstReal sqrt (ConstReal x) { return ConstReal (sqrt (x.value)); }
+    constexpr ConstReal exp (ConstReal x) { return ConstReal (exp (x.value)); }
+    constexpr ConstReal log (ConstReal x) { return ConstReal (log (x.value)); }
+    constexpr ConstReal log1p (ConstReal x) { return ConstReal (log1p (x.value)); }
+    constexpr ConstReal pow (ConstReal x, ConstReal y) { return ConstReal (pow (x.value, y.value)); }
+    constexpr ConstReal sin (ConstReal x) { return ConstReal (sin (x.value)); }
+    constexpr ConstReal cos (ConstReal x) { return ConstReal (cos (x.value)); }
+    constexpr ConstReal tan (ConstReal x) { return ConstReal (tan (x.value)); }
+    constexpr ConstReal atan (ConstReal x) { return ConstReal (atan (x.value)); }
+    constexpr ConstReal atan2 (ConstReal y, ConstReal x) { return ConstReal (atan2 (y.value, x.value)); }
+
+    // Range in miles, bearings in radians; rhumb line legs have the end bearing equal to the bearing
+    struct Leg {
+        double range, bearing, endBearing;
+    };
+
+    static constexpr int MAX_ITERATIONS = 100;
+    static constexpr double TOLERANCE = 1.0e-14;
+
+    // calcRhumblineDistAndBrg
+    constexpr Leg calcRhumblineLeg (const Pos& origin, const Pos& dest, const Ellipsoid& ellipsoid = WGS84_ELLIPSOID) {
+        const ConstReal precision = DEFPRECISION;
+        ConstReal begLat = origin.lat, begLon = origin.lon, endLat = dest.lat, endLon = dest.lon;
+
+        normalizeLon (& begLon);
+        normalizeLon (& endLon);
+
+        auto lonDiff = endLon - begLon;
+
+        if (lonDiff <= - PI) lonDiff += TWO_PI;
+        else if (lonDiff > PI) lonDiff -= TWO_PI;
+
+        auto latDif = endLat - begLat;
+        auto eccentricity = sqrt (ConstReal (ellipsoid.flattening * 2.0 - ellipsoid.flattening * ellipsoid.flattening));
+        ConstReal equRadius = ellipsoid.equRadius;
+
+        // Same parallel
+        if (fabs (latDif) < precision) {
+            auto partial = eccentricity * sin (endLat);
+            auto brg = lonDiff > 0.0 ? HALF_PI : HALF_OF_THREE_PI;
+
+            return Leg { (double) fabs (equRadius / METERS_IN_NM * lonDiff * cos (endLat) / sqrt (1.0 - partial * partial)), brg, brg };
+        }
+
+        // Same meridian
+        if (fabs (lonDiff) < precision) {
+            auto brg = latDif > 0.0 ? 0.0 : PI;
+
+            return Leg { (double) fabs (meridionalDist (endLat, eccentricity, equRadius) - meridionalDist (begLat, eccentricity, equRadius)), brg, brg };
+        }
+
+        auto meridionalDiff = meridionalPart (endLat, eccentricity) - meridionalPart (begLat, eccentricity);
+        auto meridDistDiff = meridionalDist (endLat, eccentricity, equRadius) - meridionalDist (begLat, eccentricity, equRadius);
+        auto brg = atan2 (DEG_IN_RAD * lonDiff, meridionalDiff);
+        auto rng = meridDistDiff / cos (brg);
+
+        normalizeAngle (& brg);
+
+        return Leg { (double) rng, (double) brg, (double) brg };
+    }
+
+    // calcRhumblinePos
+    constexpr Pos calcRhumblinePos (const Pos& origin, double range, double bearing, const Ellipsoid& ellipsoid = WGS84_ELLIPSOID) {
+        const ConstReal precision = DEFPRECISION;
+        ConstReal begLat = origin.lat, endLon = origin.lon, brg = bearing, rng = range, equRadius = ellipsoid.equRadius;
+        auto eccentricity = sqrt (ConstReal (ellipsoid.flattening * 2.0 - ellipsoid.flattening * ellipsoid.flattening));
+        auto endLat = begLat;
+
+        normalizeAngle (& brg);
+        normalizeLon (& endLon);
+
+        if (fabs (brg) < precision || fabs (brg - PI) < precision) {
+            endLat = findEndLat (begLat, brg, rng, eccentricity, equRadius);
+        } else if (fabs (brg - HALF_PI) < precision || fabs (brg - HALF_OF_THREE_PI) < precision) {
+            auto partial = eccentricity * sin (begLat);
+            auto longDist = rng * METERS_IN_NM * sqrt (1.0 - partial * partial) / (equRadius * cos (begLat));
+
+            endLon += fabs (brg - HALF_PI) < precision ? longDist : - longDist;
+        } else {
+            endLat = findEndLat (begLat, brg, rng, eccentricity, equRadius);
+
+            auto meridPartDiff = meridionalPart (endLat, eccentricity) - meridionalPart (begLat, eccentricity);
+            auto longDist = fabs (meridPartDiff * tan (brg)) * RAD_IN_DEG;
+
+            endLon += brg < PI ? longDist : - longDist;
+        }
+
+        if (endLon > PI)
+            endLon -= TWO_PI;
+        else if (endLon < - PI)
+            endLon += TWO_PI;
+
+        return Pos { (double) endLat, (double) endLon };
+    }
+
+    // calcGreatCircleDistAndBrg (INVER1); the iterations are limited as the compiler would give up anyway
+    constexpr Leg calcGreatCircleLeg (const Pos& origin, const Pos& dest, const Ellipsoid& ellipsoid = WGS84_ELLIPSOID) {
+        ConstReal begLat = origin.lat, begLon = origin.lon, endLat = dest.lat, endLon = dest.lon, flattening = ellipsoid.flattening;
+
+        normalizeLon (& begLon);
+        normalizeLon (& endLon);
+
+        if (fabs (begLat - endLat) <= DEFPRECISION && fabs (begLon - endLon) <= DEFPRECISION) return Leg { 0.0, 0.0, 0.0 };
+
+        auto r = 1.0 - flattening;
+        auto tangent1 = r * tan (begLat);
+        auto tangent2 = r * tan (endLat);
+        auto c1 = 1.0 / sqrt (tangent1 * tangent1 + 1.0);
+        auto s1 = c1 * tangent1;
+        auto c2 = 1.0 / sqrt (tangent2 * tangent2 + 1.0);
+        auto s = c1 * c2;
+        auto endBrg = s * tangent2;
+        auto brg = endBrg * tangent1;
+        auto x = endLon - begLon;
+        ConstReal sineX = 0.0, cosineX = 0.0, sy = 0.0, cy = 0.0, y = 0.0, c2a = 0.0, cz = 0.0, e = 0.0, c = 0.0, d = 0.0, prevD = 1.0e300;
+
+        for (auto iteration = 0; iteration < MAX_ITERATIONS; ++ iteration) {
+            sineX = sin (x);
+            cosineX = cos (x);
+            tangent1 = c2 * sineX;
+            tangent2 = endBrg - s1 * c2 * cosineX;
+            sy = sqrt (tangent1 * tangent1 + tangent2 * tangent2);
+            cy = s * cosineX + brg;
+            y = atan2 (sy, cy);
+
+            auto sa = s * sineX / sy;
+
+            c2a = - sa * sa + 1.0;
+            cz = brg + brg;
+
+            if (c2a > 0.0) cz = - cz / c2a + cy;
+
+            e = cz * cz * 2.0 - 1.0;
+            c = ((- 3.0 * c2a + 4.0) * flattening + 4.0) * c2a * flattening * ONE_SIXTEENTH;
+            prevD = d;
+            d = x;
+            x = ((e * cy * c + cz) * sy * c + y) * sa;
+            x = (1.0 - c) * x * flattening + endLon - begLon;
+
+            if (fabs (prevD - x) <= DEFPRECISION || fabs (d - x) <= DEFPRECISION) break;
+        }
+
+        brg = atan2 (tangent1, tangent2);
+        endBrg = atan2 (c1 * sineX, endBrg * cosineX - s1 * c2) + PI;
+
+        x = sqrt ((1.0 / (r * r) - 1.0) * c2a + 1.0) + 1.0;
+        x = (x - 2.0) / x;
+        c = (x * x * 0.25 + 1.0) / (1.0 - x);
+        d = (x * x * 0.375 - 1.0) * x;
+        x = e * cy;
+        s = 1.0 - e - e;
+
+        auto rng = ((((sy * sy * 4.0 - 3.0) * s * cz * d * ONE_SIXTH - x) * d * 0.25 + cz) * sy * d + y) * c * ellipsoid.equRadius * r * NM_IN_METER;
+
+        normalizeAngle (& brg);
+        normalizeAngle (& endBrg);
+        reverseBearing (& endBrg);
+
+        return Leg { (double) rng, (double) brg, (double) endBrg };
+    }
+
+    // calcGreatCirclePos (DIRCT1 with the same constants as the runtime kernel)
+    constexpr Pos calcGreatCirclePos (const Pos& origin, double range, double bearing, const Ellipsoid& ellipsoid = WGS84_ELLIPSOID, double *endBearing = 0) {
+        ConstReal begLon = origin.lon, brg = bearing, flattening = ellipsoid.flattening;
+
+        normalizeLon (& begLon);
+        normalizeAngle (& brg);
+
+        auto r = 1.0 - flattening;
+        auto tangentU = r * tan (ConstReal (origin.lat));
+        auto cu = 1.0 / sqrt (tangentU * tangentU + 1.0);
+        auto su = tangentU * cu;
+        auto sineDir = sin (brg);
+        auto cosineDir = cos (brg);
+        ConstReal sigma1 = 0.0;
+
+        if (cosineDir != 0.0) sigma1 = atan2 (tangentU, cosineDir) * 2.0;
+
+        auto sa = cu * sineDir;
+        auto c2a = 1.0 - sa * sa;
+        auto x = sqrt ((1.0 / (r * r) - 1.0) * c2a + 1.0) + 1.0;
+
+        x = (x - 2.0) / x;
+
+        auto c = (x * x * 0.25 + 1.0) / (1.0 - x);
+        auto d = (x * x * 0.375 - 1.0) * x;
+        auto sigma0 = range * METERS_IN_NM / (r * ellipsoid.equRadius * c);
+        auto y = sigma0;
+        ConstReal sy = 0.0, cy = 0.0, cz = 0.0, e = 0.0;
+
+        for (auto iteration = 0; iteration < MAX_ITERATIONS; ++ iteration) {
+            sy = sin (y);
+            cy = cos (y);
+            cz = cos (sigma1 + y);
+            e = cz * cz * 2.0 - 1.0;
+            c = y;
+            x = e * cy;
+            y = e + e - 1.0;
+            y = (((sy * sy * 4.0 - 3.0) * y * cz * d * ONE_SIXTH + x) * d * 0.25 - cz) * sy * d + sigma0;
+
+            if (fabs (y - c) <= TOLERANCE * fabs (y)) break;
+        }
+
+        auto endBrg = cu * cy * cosineDir - su * sy;
+        auto endLat = atan2 (su * cy + cu * sy * cosineDir, r * hypoLen (sa, endBrg));
+
+        c = cu * cy - su * sy * cosineDir;
+        x = atan2 (sy * sineDir, c);
+        c = ((- 3.0 * c2a + 4.0) * flattening + 4.0) * c2a * flattening * ONE_SIXTEENTH;
+        d = ((e * cy * c + cz) * sy * c + y) * sa;
+
+        auto endLon = begLon + x - (1.0 - c) * d * flattening;
+
+        endBrg = atan2 (sa, endBrg) + PI;
+
+        reverseBearing (& endBrg);
+        normalizeLon (& endLon);
+
+        if (endBearing) *endBearing = (double) endBrg;
+
+        return Pos { (double) endLat, (double) endLon };
+    }
+}
+}
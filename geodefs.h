@@ -4,43 +4,52 @@
 #include <math.h>
 #include <stdlib.h>
 
+#ifdef __cplusplus
+#define GEO_CONSTANT static constexpr
+#else
+#define GEO_CONSTANT static const
+#endif
+
 #ifdef __cplusplus
 namespace geo {
 #else
 struct geo {
 #endif
 
-static const double RAD_IN_MILE = 2.90888208665721596153703703703e-4;
-static const double RAD_IN_DEG = 0.01745329251994329576923690768489;
-static const double DEG_IN_RAD = 57.295779513082320876798154814105;
-static const double MILES_IN_RAD = 3437.7467707849392526107818606515;
-static const double DEG_IN_MILE = 1.0 / 60.0;
-static const double MILES_IN_DEG = 60.0;
-static const double METERS_IN_NM = 1852.0;
-static const double NM_IN_METER = 1.0 / METERS_IN_NM;
+GEO_CONSTANT double RAD_IN_MILE = 2.90888208665721596153703703703e-4;
+GEO_CONSTANT double RAD_IN_DEG = 0.01745329251994329576923690768489;
+GEO_CONSTANT double DEG_IN_RAD = 57.295779513082320876798154814105;
+GEO_CONSTANT double MILES_IN_RAD = 3437.7467707849392526107818606515;
+GEO_CONSTANT double DEG_IN_MILE = 1.0 / 60.0;
+GEO_CONSTANT double MILES_IN_DEG = 60.0;
+GEO_CONSTANT double METERS_IN_NM = 1852.0;
+GEO_CONSTANT double NM_IN_METER = 1.0 / METERS_IN_NM;
 
-static const double WGS84_EQUAT_RAD_M = 6378137.0;
-static const double WGS84_POLAR_RAD_M = 6356752.3142451793;
-static const double WGS84_FLATTENING = 3.35281066474751169502944198282e-3;
-static const double SPHERE_RAD_M = 6366707.0194937074958298109629434;
+GEO_CONSTANT double WGS84_EQUAT_RAD_M = 6378137.0;
+GEO_CONSTANT double WGS84_POLAR_RAD_M = 6356752.3142451793;
+GEO_CONSTANT double WGS84_FLATTENING = 3.35281066474751169502944198282e-3;
+GEO_CONSTANT double SPHERE_RAD_M = 6366707.0194937074958298109629434;
 
-static const double PI = 3.1415926535897932384626433832795;
-static const double TWO_PI = PI * 2.0;
-static const double HALF_PI = PI * 0.5;
-static const double HALF_OF_THREE_PI = PI * 1.5;
-static const double QUARTER_PI = PI * 0.25;
-static const double ONE_SIXTH_PI = PI / 6.0;
+GEO_CONSTANT double PI = 3.1415926535897932384626433832795;
+GEO_CONSTANT double TWO_PI = PI * 2.0;
+GEO_CONSTANT double HALF_PI = PI * 0.5;
+GEO_CONSTANT double HALF_OF_THREE_PI = PI * 1.5;
+GEO_CONSTANT double QUARTER_PI = PI * 0.25;
+GEO_CONSTANT double ONE_SIXTH_PI = PI / 6.0;
 
-static const double ONE_SIXTH = 1.0 / 6.0;
-static const double ONE_SIXTEENTH = 1.0 / 16.0;
+GEO_CONSTANT double ONE_SIXTH = 1.0 / 6.0;
+GEO_CONSTANT double ONE_SIXTEENTH = 1.0 / 16.0;
 
-static const double STEP_RANGE = 10.0;
+GEO_CONSTANT double STEP_RANGE = 10.0;
 
-static const double DEFPRECISION = 1.0E-10;
+GEO_CONSTANT double DEFPRECISION = 1.0E-10;
 
 enum Operation {
     CALC_BRG_RNG = 'b',
     CALC_DEST_POINT = 'p',
+    RUN_BENCHMARK = 't',
+    REPLAY_CAPTURE = 'r',
+    RUN_CHECKS = 'v',
 };
 
 enum Method {
@@ -48,125 +57,486 @@ enum Method {
     GREAT_CIRCLE = 'g',
 };
 
+enum DatumShiftMethod {
+    MOLODENSKY_STANDARD = 's',
+    MOLODENSKY_ABRIDGED = 'a',
+};
+
+struct Ellipsoid {
+    double equRadius, flattening;
+};
+
+GEO_CONSTANT Ellipsoid WGS84_ELLIPSOID = { WGS84_EQUAT_RAD_M, WGS84_FLATTENING };
+
+// Status codes of the context based API
+enum GeoStatus {
+    GEO_OK = 0,
+    GEO_INVALID_ARGUMENT,
+    GEO_OUT_OF_RANGE,
+    GEO_BUFFER_TOO_SMALL,
+};
+
+// Path taken by the great circle inverse problem
+enum GcInversePath {
+    GC_PATH_NONE = 0,               // same points, nothing to solve
+    GC_PATH_ITERATION,              // INVER1 iteration has converged within the cap
+    GC_PATH_BISECTION,              // nearly antipodal points, iteration cap is exceeded or the iteration has left the
+                                    // root range; the start azimuth is found by the bisection
+};
+
+// Per caller settings and error state replacing gkSetPrecision, gkSetStepDistance, gkSetRadianMode and
+// gkGetErrorCode/gkSetError; initialized by initGeoContext. The context is owned by a single thread and is cache
+// line aligned so the contexts of different threads never share a line
+struct alignas (64) GeoContext {
+    Ellipsoid ellipsoid;
+    double precision;               // tolerance of the comparisons and of the great circle iterations (radians)
+    double stepDistance;            // miles between intermediate points of the lines built and the split rhumb line step
+    bool radians;                   // degrees are used for latitudes, longitudes and bearings otherwise
+    GeoStatus lastError;            // last failure, GEO_OK is never stored here
+    int maxIterations;              // great circle inverse iteration cap, zero for none
+    GcInversePath lastGcPath;       // path taken by the last great circle inverse problem
+};
+
+// Three-parameter datum (see SDatumInfo); shifts are from the local datum to WGS84 in meters
+struct DatumShift {
+    int datumId;
+    Ellipsoid ellipsoid;
+    double dx, dy, dz;
+};
+
+// Latitude/longitude format compiled by compileGeoFormat from the GD_LATITUDE_FORMAT like string; literalMask has
+// 0xff for the literal bytes of the pattern, digitMask 0x80 for the digit bytes; span is the bytes read by the fixed
+// layout parser
+static const size_t GEO_FORMAT_MAX = 32;
+
+struct GeoFormat {
+    char pattern [GEO_FORMAT_MAX];
+    unsigned long long literalMask [GEO_FORMAT_MAX / 8], digitMask [GEO_FORMAT_MAX / 8];
+    unsigned char length, span, degPos, degDigits, minPos, minDigits, secPos, secDigits, fracPos, fracDigits, sidePos;
+    char fracUnit, positiveSide, negativeSide;
+    double unitsPerDegree, degreesPerUnit, fracInverse;
+    unsigned long long fracScale;
+    bool latitude;
+};
+
+// Memory mapped file; handles are platform specific
+struct MappedFile {
+    void *data;
+    size_t size;
+    void *handle, *mapping;
+};
+
+// Grid shift file opened by openGridShift; the grid is tiled, each tile keeps (tileSize + 1)^2 nodes so any
+// bilinear lookup touches one tile only. Node shifts are float arc seconds, latitude first
+struct GridShift {
+    MappedFile file;
+    const float *tiles;
+    size_t rows, cols, tileSize, tileRows, tileCols;
+    double south, west, latStep, lonStep;
+};
+
+// Track file block header as stored in the file; bounds are in radians, times in seconds
+struct TrackBlock {
+    double south, north, west, east, beginTime, endTime;
+    unsigned long long first, count;
+};
+
+// Track file opened by openTrackFile; columns are used in place (each one is 64 bytes aligned), the block
+// points are first..first + count - 1 of every column
+struct TrackFile {
+    MappedFile file;
+    const TrackBlock *blocks;
+    const double *lat, *lon, *time;
+    size_t pointCount, blockCount, blockSize;
+};
+
+// Streaming NMEA 0183 parser state; the tail of an incomplete sentence is kept between calls
+static const size_t NMEA_MAX_SENTENCE = 128;
+
+struct NmeaParser {
+    char carry [NMEA_MAX_SENTENCE];
+    size_t carryLength, sentences, fixes, badChecksums, skipped;
+};
+
+// Seven-parameter Helmert transform (position vector convention); translations are in meters, rotations
+// in arc seconds, scale in ppm
+struct HelmertParams {
+    double tx, ty, tz, rx, ry, rz, scale;
+};
+
 struct Pos {
     double lat, lon;
 };
 
-#ifdef __cplusplus
-}
-#else
+// Local tangent plane anchored at a position (initLocalFrame); radii of curvature are in miles, expanded by the
+// latitude at the anchor as r [0] + h * r [1] + h^2 * r [2]
+struct LocalFrame {
+    Ellipsoid ellipsoid;
+    Pos anchor;
+    double sinLat, cosLat;
+    double meridRadius [3], parallelRadius [3];
+    double boundScale;              // error bound is boundScale * range^3 / cos^2 (mid latitude)
+    double maxError;                // miles, points with larger bounds are solved exactly
 };
-#endif
 
-#ifdef _INTERNAL_
-namespace geo {
-    inline bool checkLat (double lat, bool assumeRad = false) {
-        auto range = assumeRad ? 1.3351768777756621263466234378938 : 85.0;
+// Inverse problem solver keeping the last solution (initGcSolver); the next query starts the iteration from it
+struct GcSolver {
+    Ellipsoid ellipsoid;
+    double auxLonScale;             // ratio of the auxiliary sphere longitude difference to the geodetic one
+    size_t queries, iterations;     // totals since initGcSolver
+    size_t bisections;              // queries solved by the bisection on the start azimuth
+    int maxIterations;              // iteration cap, zero for none
+    GcInversePath lastPath;
+};
 
-        return lat >= -range && lat <= range;
-    }
+// Geodesic state of a target kept by the own ship updater (updateTargets): both positions of the last exact solution,
+// the solution and the target displacements along and across the geodesic by the own ship latitude, the target
+// latitude and the longitude difference (miles in the radian)
+struct TargetGeodesic {
+    double ownLat, ownLon, lat, lon;
+    double range, bearing, reducedLength;       // range is negative for the invalid target
+    double alongSlope [3], acrossSlope [3];
+    double eastScale;               // miles in the radian of the longitude at the target
+};
 
-    inline bool checkLon (double lat, bool assumeRad = false, bool strict = false) {
-        auto range = strict ? (assumeRad ? PI : 180.0) : 1000.0;
+// Own ship to all targets updater (initTargetUpdater); target states are owned and pre-sized by the caller
+struct TargetUpdater {
+    Ellipsoid ellipsoid;
+    TargetGeodesic *targets;
+    size_t capacity, count;         // count is the number of the slots holding a state
+    double maxError;                // miles, the drift limit is derived from it
+    size_t exactCount;              // targets solved exactly by the last update
+};
 
-        return lat >= -range && lat <= range;
-    }
+// Kernels having the performance counters (getGeoStats)
+enum GeoKernel {
+    GEO_KERNEL_GC_INVERSE = 0,      // every great circle inverse problem, fallbacks are the bisections
+    GEO_KERNEL_GC_DIRECT,
+    GEO_KERNEL_RL_INVERSE,
+    GEO_KERNEL_RL_INVERSE_SPLIT,    // calcRhumblineDistAndBrg2, iterations are the splits by the step distance
+    GEO_KERNEL_RL_DIRECT,
+    GEO_KERNEL_LOCAL_FRAME,         // iterations are the points, fallbacks are the exact solutions
+    GEO_KERNEL_TARGET_UPDATER,      // iterations are the targets, fallbacks are the exact solutions
+    GEO_KERNEL_COUNT,
+};
 
-    inline bool checkPos (Pos *pos, bool strict = false) {
-        return checkLat (pos->lat, strict) && checkLon (pos->lon, strict);
-    }
+// Log-linear latency histogram: bucket b < 4 holds b clock ticks, every next octave of the ticks is split into 4
+// buckets (25% resolution); the last bucket holds the longer calls as well
+static const size_t LATENCY_BUCKETS = 160;
 
-    inline void normalizeLon (double *lon, bool assumeRad = true) {
-        double range = assumeRad ? PI : 180.0;
+struct KernelStats {
+    unsigned long long calls;       // calls passed the input checks
+    unsigned long long iterations, fallbacks;
+    unsigned long long rejects;     // calls (points of the batch kernels) refused by the input checks
+    unsigned long long ticks;       // total latency
+    unsigned long long latency [LATENCY_BUCKETS];
+};
 
-        while (*lon < -range) *lon += (range + range);
-        while (*lon > range) *lon -= (range + range);
-    }
+struct GeoStats {
+    double ticksPerSecond;
+    KernelStats kernels [GEO_KERNEL_COUNT];
+};
 
-    inline void normalizeAngle (double *angle, bool assumeRad = true) {
-        double range = assumeRad ? TWO_PI : 360.0;
+// Legacy calls recorded by the capture (startGeoCapture)
+enum GeoCall {
+    GEO_CALL_RL_POS = 0,            // calcRhumblinePos
+    GEO_CALL_RL_DIST_BRG,           // calcRhumblineDistAndBrg
+    GEO_CALL_GC_POS,                // calcGreatCirclePos
+    GEO_CALL_GC_DIST_BRG,           // calcGreatCircleDistAndBrg
+    GEO_CALL_COUNT,
+};
 
-        while (*angle < 0.0) *angle += range;
-        while (*angle > range) *angle -= range;
-    }
+// Captured call as stored in the capture file: origin and destination (range and bearing for the direct problems)
+// as they were passed, destination (range and bearing) and the end bearing as returned
+struct GeoCallRecord {
+    unsigned short call;
+    unsigned char useWgs84, result;
+    unsigned int reserved;
+    double inputs [4], outputs [3];
+};
 
-    inline bool isPole (Pos *point, bool assumeRadians = false)
-    {
-        auto range = assumeRadians ? 0.5 : 90.0;
+// Capture file opened by openCaptureFile; records are used in place
+struct CaptureFile {
+    MappedFile file;
+    const GeoCallRecord *records;
+    size_t recordCount, dropped;
+};
 
-        return point->lat == range || point->lat == -range;
-    }
+// Leg result cache opened by openLegCache; shards are allocated by the cache. Endpoints are rounded to the quantum
+// (radians) for the key and the leg is solved between the rounded points
+struct LegCache {
+    void *shards;
+    size_t shardCount, shardCapacity;
+    double quantum;
+};
 
-    inline bool isPole (double lat, bool assumeRadians = false)
-    {
-        auto range = assumeRadians ? 0.5 : 90.0;
+struct LegCacheStats {
+    unsigned long long hits, misses, evictions;
+    size_t entries, capacity;
+};
 
-        return lat == range || lat == -range;
+// Replay of a capture by the kernels linked (replayCapture); differences are taken where both results are true,
+// ranges are in miles and angles in radians
+struct ReplayStats {
+    size_t calls [GEO_CALL_COUNT], mismatches [GEO_CALL_COUNT];
+    double seconds [GEO_CALL_COUNT];
+    double maxDiff [GEO_CALL_COUNT][3];
+};
+
+// Structure-of-arrays position buffer; storage is owned and pre-sized by the caller
+struct PosBatch {
+    double *lat, *lon;
+    size_t capacity, count;
+};
+
+// Columnar AIS position reports; positions.capacity limits all the columns. Unavailable SOG/COG are negative
+struct AisReports {
+    unsigned int *mmsi;
+    PosBatch positions;
+    double *sog, *cog;
+};
+
+// Single buffered region compatible with gkCreateSingleBufferedRegion arguments: sizes of external contours
+// go first then internal ones, vertexes of all the contours are stored one by one in the same array
+struct RegionBuffer {
+    int extContourCount, intContourCount;
+    int *contourSizes;
+    Pos *vertexes;
+    size_t contourCapacity, vertexCapacity;
+};
+
+// Region list file records (see writeRegionList); bounds are in radians
+struct RegionRecord {
+    double south, north, west, east;
+    unsigned int firstContour, extContourCount, intContourCount, reserved;
+};
+
+struct ContourRecord {
+    double south, north, west, east;
+    unsigned long long firstVertex, vertexCount;
+};
+
+// Region list opened by openRegionList; everything is used in place. The index is a grid of cells over the
+// bounds of the whole list, cellItems [cellStarts [i]..cellStarts [i + 1] - 1] are the regions touching the cell i
+struct RegionList {
+    MappedFile file;
+    const RegionRecord *regions;
+    const ContourRecord *contours;
+    const Pos *vertexes;
+    const unsigned int *cellStarts, *cellItems;
+    size_t regionCount, contourCount, vertexCount, cellRows, cellCols;
+    double south, west, cellLat, cellLon;
+};
+
+#ifdef __cplusplus
+}
+#else
+};
+#endif
+
+#ifdef __cplusplus
+// Angle helpers and the ellipsoid math templated over the arithmetic type; constexpr so they are evaluated at compile
+// time as well when instantiated over a constexpr arithmetic type (geoconstexpr.h)
+namespace geo {
+    template <typename Real> constexpr void normalizeLon (Real *lon, bool assumeRad = true) {
+        Real range = assumeRad ? (Real) PI : (Real) 180;
+
+        while (*lon < -range) *lon += (range + range);
+        while (*lon > range) *lon -= (range + range);
     }
 
-    inline bool checkGeoPointRange (double lat, double lon, bool assumeRad = true, bool enablePole = false) {
-        return !(!enablePole && isPole (lat, assumeRad) || !checkLat (lat, assumeRad) || !checkLon (lon, assumeRad));
+    template <typename Real> constexpr void normalizeAngle (Real *angle, bool assumeRad = true) {
+        Real range = assumeRad ? (Real) TWO_PI : (Real) 360;
+
+        while (*angle < (Real) 0) *angle += range;
+        while (*angle > range) *angle -= range;
     }
 
-    inline bool checkSegmentRag (double begLat, double begLon, double endLat, double endLon, bool assumeRad, bool enablePole) {
-        return checkGeoPointRange (begLat, begLon, assumeRad, enablePole) && checkGeoPointRange (endLat, endLon, assumeRad, enablePole);
+    template <typename Real> constexpr void reverseBearing (Real *brg) {
+        if (*brg > (Real) PI) 
+            *brg -= (Real) PI;
+        else
+            *brg += (Real) PI;
+
+        normalizeAngle (brg);
     }
 
-    inline double hypoLen (double cat1, double cat2) {
+    template <typename Real> constexpr Real hypoLen (Real cat1, Real cat2) {
         return sqrt (cat1 * cat1 + cat2 * cat2);
     }
 
-    inline double deltaPhiInline (double eccentricity, double begLat, double endLat)
+    // Ellipsoid math below is templated over the arithmetic type: float for display, double for navigation and
+    // long double for reference results; any type having arithmetic operators and sin/cos/tan/log/log1p/pow fits
+    template <typename Real> constexpr Real deltaPhiInline (Real eccentricity, Real begLat, Real endLat)
     {
-        double eSinBegLat = eccentricity * sin (begLat),
+        const Real one = 1, half = 0.5, quarterPi = (Real) QUARTER_PI;
+        Real eSinBegLat = eccentricity * sin (begLat),
             eSinEndLat = eccentricity * sin (endLat);
 
         return log (
-            tan (QUARTER_PI + endLat * 0.5) /
-            tan (QUARTER_PI + begLat * 0.5) * 
-            pow (((1.0 - eSinEndLat) * (1.0 + eSinBegLat)) / ((1.0 + eSinEndLat) * (1.0 - eSinBegLat)), eccentricity * 0.5)
+            tan (quarterPi + endLat * half) /
+            tan (quarterPi + begLat * half) * 
+            pow (((one - eSinEndLat) * (one + eSinBegLat)) / ((one + eSinEndLat) * (one - eSinBegLat)), eccentricity * half)
         );
     }
 
-    inline bool invalidVal (double val) {
-        return (_fpclass ((double) (val)) & (_FPCLASS_SNAN | _FPCLASS_QNAN | _FPCLASS_NINF | _FPCLASS_PINF));
+    // Same as deltaPhiInline but in the difference form: no cancellation for the close latitudes, suits float
+    template <typename Real> constexpr Real deltaIsoLat (Real eccentricity, Real begLat, Real endLat) {
+        const Real half = 0.5, quarterPi = (Real) QUARTER_PI;
+        auto halfDelta = sin ((endLat - begLat) * half);
+        auto begSin = eccentricity * sin (begLat);
+        auto endSin = eccentricity * sin (endLat);
+        auto sinDiff = (Real) 2 * cos ((begLat + endLat) * half) * halfDelta * eccentricity;
+
+        return log1p (halfDelta / (cos (quarterPi + endLat * half) * sin (quarterPi + begLat * half))) -
+               eccentricity * half * log1p ((Real) 2 * sinDiff / (((Real) 1 - endSin) * ((Real) 1 + begSin)));
     }
 
-    inline double meridionalDist (double lat, double eccentricity, double equRadius)
+    template <typename Real> constexpr Real meridionalDist (Real lat, Real eccentricity, Real equRadius)
     {
         auto e2 = eccentricity * eccentricity;
         auto e4 = e2 * e2;
         auto e6 = e4 * e2;
-        auto v1 = RAD_IN_DEG * (1.0 - e2 / 4.0 - 3.0 * e4 / 64.0 - 0.01953125 /*5.0 / 256.0*/ * e6);
-        auto v2 = 0.375 /*3.0 / 8.0*/ * (e2 - e4 / 4.0 + 0.1171875 /*15.0 / 128.0*/ * e6);
-        auto v3 = 0.05859375 /*15.0 / 256.0*/ * (e4 + 0.75 /*3.0 / 4.0*/ * e6);
-        auto v4 = equRadius / METERS_IN_NM;
-        auto md = v4 * (v1 * lat * DEG_IN_RAD - v2 * sin (2.0 * lat) + v3 * sin (4.0 * lat));
+        auto v1 = (Real) RAD_IN_DEG * ((Real) 1 - e2 / (Real) 4 - (Real) 3 * e4 / (Real) 64 - (Real) 0.01953125 /*5.0 / 256.0*/ * e6);
+        auto v2 = (Real) 0.375 /*3.0 / 8.0*/ * (e2 + e4 / (Real) 4 + (Real) 0.1171875 /*15.0 / 128.0*/ * e6);
+        auto v3 = (Real) 0.05859375 /*15.0 / 256.0*/ * (e4 + (Real) 0.75 /*3.0 / 4.0*/ * e6);
+        auto v4 = equRadius / (Real) METERS_IN_NM;
+        auto v5 = (Real) 0.011393229166666666 /*35.0 / 3072.0*/ * e6;
+        auto md = v4 * (v1 * lat * (Real) DEG_IN_RAD - v2 * sin ((Real) 2 * lat) + v3 * sin ((Real) 4 * lat) - v5 * sin ((Real) 6 * lat));
 
         return md;
     }
 
-    inline double findEndLat (double begLat, double bearing, double range, double eccentricity, double equatorialRadius) {
+    // Fixed number of iterations (no data dependent branches) so the function suits vector types as well
+    template <typename Real> constexpr Real findEndLat (Real begLat, Real bearing, Real range, Real eccentricity, Real equatorialRadius) {
         auto meridRngFrom  = meridionalDist (begLat, eccentricity, equatorialRadius);
         auto meridRngEstim = meridRngFrom + range * cos (bearing);
-        auto lat           = begLat + (meridRngEstim - meridRngFrom) / 60.0;
+        auto lat           = begLat * (Real) DEG_IN_RAD + (meridRngEstim - meridRngFrom) / (Real) 60;
 
         for (auto iteration = 0; iteration < 10; ++ iteration)
         {
-            auto meridRngPart = meridionalDist (lat * RAD_IN_DEG, eccentricity, equatorialRadius);
+            auto meridRngPart = meridionalDist (lat * (Real) RAD_IN_DEG, eccentricity, equatorialRadius);
 
-            lat += (meridRngEstim - meridRngPart) / 60.0;
+            lat += (meridRngEstim - meridRngPart) / (Real) 60;
         }
 
-        return lat * RAD_IN_DEG;
+        return lat * (Real) RAD_IN_DEG;
+    }
+
+    // Isometric latitude, radians
+    template <typename Real> constexpr Real calcIsoLat (Real lat, Real eccentricity) {
+        const Real one = 1, half = 0.5;
+        auto part = eccentricity * sin (lat);
+
+        return log (tan ((Real) QUARTER_PI + lat * half)) - half * eccentricity * log ((one + part) / (one - part));
+    }
+
+    template <typename Real> constexpr Real meridionalPart (Real lat, Real eccentricity) {
+        return (Real) DEG_IN_RAD * calcIsoLat (lat, eccentricity);
     }
 
-    inline double meridionalPart (double lat, double eccentricity) {
+    // Derivative of the latitude by the isometric latitude
+    template <typename Real> constexpr Real calcIsoLatSlope (Real lat, Real eccentricity) {
+        const Real one = 1;
         auto part = eccentricity * sin (lat);
-        
-        return DEG_IN_RAD * (log (tan (QUARTER_PI + lat * 0.5)) - 0.5 * eccentricity * log ((1.0 + part) / (1.0 - part)));
+
+        return (one - part * part) * cos (lat) / (one - eccentricity * eccentricity);
+    }
+
+    // Inverse of deltaIsoLat: latitude at the isometric latitude difference from begLat (begIsoLat is its isometric
+    // latitude). Conformal latitude corrected by the series in the eccentricity up to e^8 is within 1e-11 rad for the
+    // earth ellipsoids, every Newton step on the difference form squares that; fixed step count suits the vector types
+    template <typename Real> constexpr Real findIsoLatRoot (Real eccentricity, Real begLat, Real begIsoLat, Real deltaIso, int steps = 1) {
+        const Real two = 2;
+        auto e2 = eccentricity * eccentricity;
+        auto e4 = e2 * e2, e6 = e4 * e2, e8 = e6 * e2;
+        auto conformal = two * atan (exp (begIsoLat + deltaIso)) - (Real) HALF_PI;
+        auto lat = conformal +
+                   (e2 * (Real) 0.5 + e4 * (Real) (5.0 / 24.0) + e6 * (Real) (1.0 / 12.0) + e8 * (Real) (13.0 / 360.0)) * sin (two * conformal) +
+                   (e4 * (Real) (7.0 / 48.0) + e6 * (Real) (29.0 / 240.0) + e8 * (Real) (811.0 / 11520.0)) * sin ((Real) 4 * conformal) +
+                   (e6 * (Real) (7.0 / 120.0) + e8 * (Real) (81.0 / 1120.0)) * sin ((Real) 6 * conformal) +
+                   e8 * (Real) (4279.0 / 161280.0) * sin ((Real) 8 * conformal);
+
+        for (auto step = 0; step < steps; ++ step)
+            lat += (deltaIso - deltaIsoLat (eccentricity, begLat, lat)) * calcIsoLatSlope (lat, eccentricity);
+
+        return lat;
+    }
+}
+#endif
+
+#ifdef _INTERNAL_
+namespace geo {
+    // Ellipsoid based kernels shared by the legacy and the context based API (geo_gc.cpp, geo_rl.cpp); precision is
+    // the convergence bound of the great circle iterations and the tolerance of the rhumb line special cases
+    void calcGcInverse (const Ellipsoid& ellipsoid, double precision, const Pos *origin, const Pos *dest, double *range, double *bearing,
+                        double *endBearing, double *auxLonScale = 0, int *iterations = 0, int maxIterations = 0, GcInversePath *path = 0);
+    void calcGcDirect (const Ellipsoid& ellipsoid, double precision, const Pos *origin, double range, double bearing, Pos *dest, double *endBearing);
+    bool calcRlInverse (const Ellipsoid& ellipsoid, double precision, const Pos *origin, const Pos *dest, double *range, double *bearing);
+    bool calcRlInverseSplit (const Ellipsoid& ellipsoid, double precision, double stepDistance, const Pos *origin, const Pos *dest, double *range,
+                             double *bearing);
+    bool calcRlDirect (const Ellipsoid& ellipsoid, double precision, const Pos *origin, double range, double bearing, Pos *dest);
+
+    inline bool checkLat (double lat, bool assumeRad = false) {
+        auto range = assumeRad ? 1.3351768777756621263466234378938 : 85.0;
+
+        return lat >= -range && lat <= range;
     }
 
+    inline bool checkLon (double lat, bool assumeRad = false, bool strict = false) {
+        auto range = strict ? (assumeRad ? PI : 180.0) : 1000.0;
+
+        return lat >= -range && lat <= range;
+    }
+
+    inline bool checkPos (Pos *pos, bool strict = false) {
+        return checkLat (pos->lat, strict) && checkLon (pos->lon, strict);
+    }
+
+    inline bool isPole (Pos *point, bool assumeRadians = false)
+    {
+        auto range = assumeRadians ? 0.5 : 90.0;
+
+        return point->lat == range || point->lat == -range;
+    }
+
+    inline bool isPole (double lat, bool assumeRadians = false)
+    {
+        auto range = assumeRadians ? 0.5 : 90.0;
+
+        return lat == range || lat == -range;
+    }
+
+    inline bool checkGeoPointRange (double lat, double lon, bool assumeRad = true, bool enablePole = false) {
+        return !(!enablePole && isPole (lat, assumeRad) || !checkLat (lat, assumeRad) || !checkLon (lon, assumeRad));
+    }
+
+    inline bool checkSegmentRag (double begLat, double begLon, double endLat, double endLon, bool assumeRad, bool enablePole) {
+        return checkGeoPointRange (begLat, begLon, assumeRad, enablePole) && checkGeoPointRange (endLat, endLon, assumeRad, enablePole);
+    }
+
+    // Tolerances of the templated kernels: iteration convergence and comparisons of the special cases
+    template <typename Real> struct KernelTraits {
+        static constexpr Real tolerance = (Real) 1.0e-14;
+        static constexpr Real precision = (Real) DEFPRECISION;
+    };
+
+    template <> struct KernelTraits <float> {
+        static constexpr float tolerance = FLT_EPSILON * 4;
+        static constexpr float precision = 1.0e-6f;
+    };
+
+    template <> struct KernelTraits <long double> {
+        static constexpr long double tolerance = LDBL_EPSILON * 64;
+        static constexpr long double precision = DEFPRECISION;
+    };
+
+    inline bool invalidVal (double val) {
+        return (_fpclass ((double) (val)) & (_FPCLASS_SNAN | _FPCLASS_QNAN | _FPCLASS_NINF | _FPCLASS_PINF));
+    }
+
+    // Latitude at the Mercator northing offset from begLat; the series estimate is refined by Newton steps until the
+    // isometric latitude residual is within precision, which takes one or two steps
     inline double calcLatEquationRoot (
         double eccentricity,                  // Geoid eccentricity
         double begLat,                        // Begin latitude
@@ -174,78 +544,18 @@ namespace geo {
         double scaledEquRadius,               // a * k0
         double precision
     ) {
-        auto step = 0.001;
         auto value = dNorthing / scaledEquRadius;
+        auto lat = findIsoLatRoot (eccentricity, begLat, calcIsoLat (begLat, eccentricity), value, 0);
 
-        double begPhi, endPhi, midPhi, begValue, midValue, endValue;
+        for (auto step = 0; step < 3; ++ step) {
+            auto residual = value - deltaIsoLat (eccentricity, begLat, lat);
 
-        // Search for interval range
-        begPhi   = begLat - step;
-        begValue = deltaPhiInline (eccentricity, begLat, begPhi);
-        endPhi   = begLat + step;
-        endValue = deltaPhiInline (eccentricity, begLat, endPhi);
-
-        if (endValue >= value && begValue <= value)
-        {
-            // Range is found - no some actions needed
-        }
-        else if (endValue <= value && begValue >= value)
-        {
-            // Range is found but must be exachanged
-            double gvTemp = begPhi;
+            if (fabs (residual) <= precision) break;
 
-            begPhi = endPhi;
-            endPhi = gvTemp;
-        }
-        else if (endValue > begValue && endValue > value)
-        {
-            // Shift begPhi down until this is great than value
-            do
-            {
-                endPhi   = begPhi;
-                begPhi  -= step; 
-                endValue = begValue;
-                begValue = deltaPhiInline (eccentricity, begLat, begPhi);
-                step    += step;
-            }
-            while (begValue > value);
-        }
-        else
-        {
-            // Shift endPhi upper until this is less than value
-            do
-            {
-                begPhi   = endPhi;
-                endPhi  += step; 
-                begValue = endValue;
-                endValue = deltaPhiInline (eccentricity, begLat, endPhi);
-                step    += step;
-            }
-            while (endValue < value);
+            lat += residual * calcIsoLatSlope (lat, eccentricity);
         }
 
-        // Range are found - start linear interpolating...
-        do
-        {
-            midPhi   = begPhi + 
-                        (endPhi - begPhi) * (value - begValue) / (endValue - begValue);
-            midValue = deltaPhiInline (eccentricity, begLat, midPhi);
-
-            // Change range...
-            if (midValue >= value)
-            {
-                endPhi   = midPhi;
-                endValue = midValue;
-            }
-            else
-            {
-                begPhi   = midPhi;
-                begValue = midValue;
-            }
-        }
-        while (fabs (midValue - value) > precision);
-
-        return midPhi;
+        return lat;
     }
 
     inline bool isSame (double val1, double val2, double precision = 1.0e-10) {
@@ -261,15 +571,6 @@ namespace geo {
         while (*brg > TWO_PI) *brg -= TWO_PI;
     }
 
-    inline void reverseBearing (double *brg) {                                       \
-        if (*brg > PI) 
-            *brg -= PI;
-        else
-            *brg += PI;
-
-        normalizeAngle (brg);
-    }
-
     inline bool isPole (Pos *point) {
         return isPole (point->lat, true);
     }
@@ -295,5 +596,16 @@ namespace geo {
 
         return !wrongAngle (bearing) && !wrongDistance (range);
     }
+
+    // NMEA 0183 sentence scanning shared by the NMEA and AIS decoders (geo_nmea.cpp)
+    struct NmeaField {
+        const char *begin, *end;
+    };
+
+    typedef void (*NmeaSentenceHandler) (NmeaParser *parser, const char *begin, const char *end, PosBatch *output, void *context);
+
+    bool checkNmeaChecksum (const char *start, const char *end, const char **star);
+    size_t splitNmeaFields (const char *start, const char *star, NmeaField *fields, size_t maxFields);
+    size_t scanNmeaSentences (NmeaParser *parser, const char *data, size_t size, NmeaSentenceHandler handler, PosBatch *output, void *context);
 }
 #endif
\ No newline at end of file
@@ -0,0 +1,327 @@
+#pragma once
+
+#include <math.h>
+#include <string.h>
+#include "geodefs.h"
+
+// Building blocks of the fast batch kernels (geo_merc.cpp, geo_tm.cpp): minimax polynomials instead of the libm
+// calls and no branches, so the same templated code runs in the scalar tail and in the SSE2/AVX2 lanes
+
+#if defined (_M_X64) || defined (__SSE2__)
+#define _USE_SSE2_
+#include <emmintrin.h>
+#endif
+
+#ifdef __AVX2__
+#define _USE_AVX2_
+#include <immintrin.h>
+#endif
+
+// /arch:AVX2 of MSVC implies FMA
+#if defined (_USE_AVX2_) && (defined (__FMA__) || defined (_MSC_VER))
+#define _USE_FMA_
+#endif
+
+#ifdef __cplusplus
+namespace geo {
+#endif
+
+// Minimax coefficients from the highest power; maximum error of every approximation on its range:
+// sin (x) / x and cos (x) by x^2 for |x| <= PI/4 - 3e-18 and 6e-17
+static const double FAST_SIN_COEFS [] = {
+    1.5894136378327439174e-10, -2.5050705846484807903e-08, 2.7557313299015691005e-06, -1.9841269828402131470e-04,
+    8.3333333333200024459e-03, -1.6666666666666614754e-01, 9.9999999999999999669e-01,
+};
+
+static const double FAST_COS_COEFS [] = {
+    2.0627447527702246490e-09, -2.7555177981093247550e-07, 2.4801578148397927493e-05, -1.3888888868721814353e-03,
+    4.1666666666453968395e-02, -4.9999999999999152638e-01, 9.9999999999999994429e-01,
+};
+
+// (log ((1 + t) / (1 - t)) - 2t) / t^3 by t^2 for the mantissa in [sqrt (0.5), sqrt (2)) - 2e-16 of the logarithm
+static const double FAST_LOG_COEFS [] = {
+    1.6623234765748181280e-01, 1.8140089511897732673e-01, 2.2222864965216127499e-01, 2.8571424110111275234e-01,
+    4.0000000011310235517e-01, 6.6666666666662022227e-01,
+};
+
+// exp (r) for |r| <= ln (2) / 2 - 2e-16 (relative)
+static const double FAST_EXP_COEFS [] = {
+    2.7488443522901970846e-07, 2.7639768251354326759e-06, 2.4801917687877068878e-05, 1.9841171384225595205e-04,
+    1.3888888499138289863e-03, 8.3333333846657943609e-03, 4.1666666668426017158e-02, 1.6666666666557741220e-01,
+    4.9999999999997287011e-01, 1.0000000000000064426e+00, 1.0000000000000000661e+00,
+};
+
+// atan (v) / v by v^2 for |v| <= tan (PI/8) - 9e-16
+static const double FAST_ATAN_COEFS [] = {
+    -2.5357895194652049433e-02, 5.0279654696178353327e-02, -6.5070155847147966322e-02, 7.6737149847667246569e-02,
+    -9.0895481598587400294e-02, 1.1111049938284998528e-01, -1.4285712698002658792e-01, 1.9999999979002354885e-01,
+    -3.3333333333225378799e-01, 9.9999999999999908288e-01,
+};
+
+static const double LN2_HI = 6.93147180369123816490e-01;
+static const double LN2_LO = 1.90821492927058770002e-10;
+static const double INV_LN2 = 1.44269504088896338700e+00;
+static const double SQRT_TWO = 1.41421356237309504880;
+static const double ROUNDING_SHIFTER = 6755399441055744.0;            // 1.5 * 2^52
+static const double EXPONENT_SHIFTER = 4503599627370496.0;            // 2^52
+static const unsigned long long EXPONENT_SHIFTER_BITS = 0x4330000000000000ull;
+static const unsigned long long MANTISSA_MASK = 0x000fffffffffffffull;
+static const unsigned long long ONE_BITS = 0x3ff0000000000000ull;
+
+// Lane operations: double is one lane, masks of the scalar lane are bool
+template <typename Lane> static inline Lane laneSplat (double value);
+template <typename Lane> static inline Lane laneLoad (const double *source);
+
+template <> inline double laneSplat <double> (double value) { return value; }
+template <> inline double laneLoad <double> (const double *source) { return *source; }
+static inline void laneStore (double *dest, double value) { *dest = value; }
+static inline double laneAdd (double arg1, double arg2) { return arg1 + arg2; }
+static inline double laneSub (double arg1, double arg2) { return arg1 - arg2; }
+static inline double laneMul (double arg1, double arg2) { return arg1 * arg2; }
+static inline double laneMulAdd (double arg1, double arg2, double arg3) { return arg1 * arg2 + arg3; }
+static inline double laneDiv (double arg1, double arg2) { return arg1 / arg2; }
+static inline double laneSqrt (double arg) { return sqrt (arg); }
+static inline double laneMin (double arg1, double arg2) { return arg1 < arg2 ? arg1 : arg2; }
+static inline double laneMax (double arg1, double arg2) { return arg1 > arg2 ? arg1 : arg2; }
+static inline double laneAbs (double arg) { return fabs (arg); }
+static inline bool laneLess (double arg1, double arg2) { return arg1 < arg2; }
+static inline bool laneLessEqual (double arg1, double arg2) { return arg1 <= arg2; }
+static inline bool laneAnd (bool mask1, bool mask2) { return mask1 && mask2; }
+static inline double laneSelect (bool mask, double arg1, double arg2) { return mask ? arg1 : arg2; }
+static inline bool laneAll (bool mask) { return mask; }
+
+// Unbiased exponent (as a double) and the mantissa in [1, 2) of a positive normal value
+static inline double laneSplitExponent (double value, double *mantissa) {
+    unsigned long long bits, exponentBits;
+    double exponent;
+
+    memcpy (& bits, & value, sizeof (bits));
+
+    exponentBits = (bits >> 52) | EXPONENT_SHIFTER_BITS;
+    bits = (bits & MANTISSA_MASK) | ONE_BITS;
+
+    memcpy (mantissa, & bits, sizeof (bits));
+    memcpy (& exponent, & exponentBits, sizeof (exponent));
+
+    return exponent - (EXPONENT_SHIFTER + 1023.0);
+}
+
+// Multiplies by 2^k where k has been rounded into the low bits of the shifted value by adding ROUNDING_SHIFTER
+static inline double laneScaleByExponent (double value, double shifted) {
+    unsigned long long bits, shiftedBits;
+
+    memcpy (& bits, & value, sizeof (bits));
+    memcpy (& shiftedBits, & shifted, sizeof (shiftedBits));
+
+    bits += shiftedBits << 52;
+
+    memcpy (& value, & bits, sizeof (value));
+
+    return value;
+}
+
+#ifdef _USE_SSE2_
+template <> inline __m128d laneSplat <__m128d> (double value) { return _mm_set1_pd (value); }
+template <> inline __m128d laneLoad <__m128d> (const double *source) { return _mm_loadu_pd (source); }
+static inline void laneStore (double *dest, __m128d value) { _mm_storeu_pd (dest, value); }
+static inline __m128d laneAdd (__m128d arg1, __m128d arg2) { return _mm_add_pd (arg1, arg2); }
+static inline __m128d laneSub (__m128d arg1, __m128d arg2) { return _mm_sub_pd (arg1, arg2); }
+static inline __m128d laneMul (__m128d arg1, __m128d arg2) { return _mm_mul_pd (arg1, arg2); }
+static inline __m128d laneMulAdd (__m128d arg1, __m128d arg2, __m128d arg3) { return _mm_add_pd (_mm_mul_pd (arg1, arg2), arg3); }
+static inline __m128d laneDiv (__m128d arg1, __m128d arg2) { return _mm_div_pd (arg1, arg2); }
+static inline __m128d laneSqrt (__m128d arg) { return _mm_sqrt_pd (arg); }
+static inline __m128d laneMin (__m128d arg1, __m128d arg2) { return _mm_min_pd (arg1, arg2); }
+static inline __m128d laneMax (__m128d arg1, __m128d arg2) { return _mm_max_pd (arg1, arg2); }
+static inline __m128d laneAbs (__m128d arg) { return _mm_andnot_pd (_mm_set1_pd (-0.0), arg); }
+static inline __m128d laneLess (__m128d arg1, __m128d arg2) { return _mm_cmplt_pd (arg1, arg2); }
+static inline __m128d laneLessEqual (__m128d arg1, __m128d arg2) { return _mm_cmple_pd (arg1, arg2); }
+static inline __m128d laneAnd (__m128d mask1, __m128d mask2) { return _mm_and_pd (mask1, mask2); }
+static inline __m128d laneSelect (__m128d mask, __m128d arg1, __m128d arg2) { return _mm_or_pd (_mm_and_pd (mask, arg1), _mm_andnot_pd (mask, arg2)); }
+static inline bool laneAll (__m128d mask) { return _mm_movemask_pd (mask) == 0x3; }
+
+static inline __m128d laneSplitExponent (__m128d value, __m128d *mantissa) {
+    auto bits = _mm_castpd_si128 (value);
+    auto exponentBits = _mm_or_si128 (_mm_srli_epi64 (bits, 52), _mm_set1_epi64x ((long long) EXPONENT_SHIFTER_BITS));
+
+    *mantissa = _mm_castsi128_pd (_mm_or_si128 (_mm_and_si128 (bits, _mm_set1_epi64x ((long long) MANTISSA_MASK)), _mm_set1_epi64x ((long long) ONE_BITS)));
+
+    return _mm_sub_pd (_mm_castsi128_pd (exponentBits), _mm_set1_pd (EXPONENT_SHIFTER + 1023.0));
+}
+
+static inline __m128d laneScaleByExponent (__m128d value, __m128d shifted) {
+    return _mm_castsi128_pd (_mm_add_epi64 (_mm_castpd_si128 (value), _mm_slli_epi64 (_mm_castpd_si128 (shifted), 52)));
+}
+#endif
+
+#ifdef _USE_AVX2_
+template <> inline __m256d laneSplat <__m256d> (double value) { return _mm256_set1_pd (value); }
+template <> inline __m256d laneLoad <__m256d> (const double *source) { return _mm256_loadu_pd (source); }
+static inline void laneStore (double *dest, __m256d value) { _mm256_storeu_pd (dest, value); }
+static inline __m256d laneAdd (__m256d arg1, __m256d arg2) { return _mm256_add_pd (arg1, arg2); }
+static inline __m256d laneSub (__m256d arg1, __m256d arg2) { return _mm256_sub_pd (arg1, arg2); }
+static inline __m256d laneMul (__m256d arg1, __m256d arg2) { return _mm256_mul_pd (arg1, arg2); }
+#ifdef _USE_FMA_
+static inline __m256d laneMulAdd (__m256d arg1, __m256d arg2, __m256d arg3) { return _mm256_fmadd_pd (arg1, arg2, arg3); }
+#else
+static inline __m256d laneMulAdd (__m256d arg1, __m256d arg2, __m256d arg3) { return _mm256_add_pd (_mm256_mul_pd (arg1, arg2), arg3); }
+#endif
+static inline __m256d laneDiv (__m256d arg1, __m256d arg2) { return _mm256_div_pd (arg1, arg2); }
+static inline __m256d laneSqrt (__m256d arg) { return _mm256_sqrt_pd (arg); }
+static inline __m256d laneMin (__m256d arg1, __m256d arg2) { return _mm256_min_pd (arg1, arg2); }
+static inline __m256d laneMax (__m256d arg1, __m256d arg2) { return _mm256_max_pd (arg1, arg2); }
+static inline __m256d laneAbs (__m256d arg) { return _mm256_andnot_pd (_mm256_set1_pd (-0.0), arg); }
+static inline __m256d laneLess (__m256d arg1, __m256d arg2) { return _mm256_cmp_pd (arg1, arg2, _CMP_LT_OQ); }
+static inline __m256d laneLessEqual (__m256d arg1, __m256d arg2) { return _mm256_cmp_pd (arg1, arg2, _CMP_LE_OQ); }
+static inline __m256d laneAnd (__m256d mask1, __m256d mask2) { return _mm256_and_pd (mask1, mask2); }
+static inline __m256d laneSelect (__m256d mask, __m256d arg1, __m256d arg2) { return _mm256_blendv_pd (arg2, arg1, mask); }
+static inline bool laneAll (__m256d mask) { return _mm256_movemask_pd (mask) == 0xf; }
+
+static inline __m256d laneSplitExponent (__m256d value, __m256d *mantissa) {
+    auto bits = _mm256_castpd_si256 (value);
+    auto exponentBits = _mm256_or_si256 (_mm256_srli_epi64 (bits, 52), _mm256_set1_epi64x ((long long) EXPONENT_SHIFTER_BITS));
+
+    *mantissa = _mm256_castsi256_pd (_mm256_or_si256 (_mm256_and_si256 (bits, _mm256_set1_epi64x ((long long) MANTISSA_MASK)), _mm256_set1_epi64x ((long long) ONE_BITS)));
+
+    return _mm256_sub_pd (_mm256_castsi256_pd (exponentBits), _mm256_set1_pd (EXPONENT_SHIFTER + 1023.0));
+}
+
+static inline __m256d laneScaleByExponent (__m256d value, __m256d shifted) {
+    return _mm256_castsi256_pd (_mm256_add_epi64 (_mm256_castpd_si256 (value), _mm256_slli_epi64 (_mm256_castpd_si256 (shifted), 52)));
+}
+
+// Eight points in two AVX2 registers: every operation is issued for both halves back to back, so the two independent
+// dependency chains of a kernel are interleaved and the long latency of one is covered by the other
+struct LanePair {
+    __m256d low, high;
+};
+
+template <> inline LanePair laneSplat <LanePair> (double value) { auto half = _mm256_set1_pd (value); return { half, half }; }
+template <> inline LanePair laneLoad <LanePair> (const double *source) { return { _mm256_loadu_pd (source), _mm256_loadu_pd (source + 4) }; }
+static inline void laneStore (double *dest, LanePair value) { _mm256_storeu_pd (dest, value.low); _mm256_storeu_pd (dest + 4, value.high); }
+static inline LanePair laneAdd (LanePair arg1, LanePair arg2) { return { laneAdd (arg1.low, arg2.low), laneAdd (arg1.high, arg2.high) }; }
+static inline LanePair laneSub (LanePair arg1, LanePair arg2) { return { laneSub (arg1.low, arg2.low), laneSub (arg1.high, arg2.high) }; }
+static inline LanePair laneMul (LanePair arg1, LanePair arg2) { return { laneMul (arg1.low, arg2.low), laneMul (arg1.high, arg2.high) }; }
+static inline LanePair laneMulAdd (LanePair arg1, LanePair arg2, LanePair arg3) {
+    return { laneMulAdd (arg1.low, arg2.low, arg3.low), laneMulAdd (arg1.high, arg2.high, arg3.high) };
+}
+static inline LanePair laneDiv (LanePair arg1, LanePair arg2) { return { laneDiv (arg1.low, arg2.low), laneDiv (arg1.high, arg2.high) }; }
+static inline LanePair laneSqrt (LanePair arg) { return { laneSqrt (arg.low), laneSqrt (arg.high) }; }
+static inline LanePair laneMin (LanePair arg1, LanePair arg2) { return { laneMin (arg1.low, arg2.low), laneMin (arg1.high, arg2.high) }; }
+static inline LanePair laneMax (LanePair arg1, LanePair arg2) { return { laneMax (arg1.low, arg2.low), laneMax (arg1.high, arg2.high) }; }
+static inline LanePair laneAbs (LanePair arg) { return { laneAbs (arg.low), laneAbs (arg.high) }; }
+static inline LanePair laneLess (LanePair arg1, LanePair arg2) { return { laneLess (arg1.low, arg2.low), laneLess (arg1.high, arg2.high) }; }
+static inline LanePair laneLessEqual (LanePair arg1, LanePair arg2) { return { laneLessEqual (arg1.low, arg2.low), laneLessEqual (arg1.high, arg2.high) }; }
+static inline LanePair laneAnd (LanePair mask1, LanePair mask2) { return { laneAnd (mask1.low, mask2.low), laneAnd (mask1.high, mask2.high) }; }
+static inline LanePair laneSelect (LanePair mask, LanePair arg1, LanePair arg2) {
+    return { laneSelect (mask.low, arg1.low, arg2.low), laneSelect (mask.high, arg1.high, arg2.high) };
+}
+static inline bool laneAll (LanePair mask) { return laneAll (laneAnd (mask.low, mask.high)); }
+
+static inline LanePair laneSplitExponent (LanePair value, LanePair *mantissa) {
+    return { laneSplitExponent (value.low, & mantissa->low), laneSplitExponent (value.high, & mantissa->high) };
+}
+
+static inline LanePair laneScaleByExponent (LanePair value, LanePair shifted) {
+    return { laneScaleByExponent (value.low, shifted.low), laneScaleByExponent (value.high, shifted.high) };
+}
+#endif
+
+template <typename Lane, size_t Count> static inline Lane calcFastPoly (Lane arg, const double (&coefs) [Count]) {
+    auto result = laneSplat <Lane> (coefs [0]);
+
+    for (size_t i = 1; i < Count; ++ i) result = laneMulAdd (result, arg, laneSplat <Lane> (coefs [i]));
+
+    return result;
+}
+
+template <typename Lane> static inline Lane calcFastLog (Lane arg) {
+    auto one = laneSplat <Lane> (1.0);
+    Lane mantissa;
+    auto exponent = laneSplitExponent (arg, & mantissa);
+    auto high = laneLess (laneSplat <Lane> (SQRT_TWO), mantissa);
+
+    mantissa = laneSelect (high, laneMul (mantissa, laneSplat <Lane> (0.5)), mantissa);
+    exponent = laneSelect (high, laneAdd (exponent, one), exponent);
+
+    auto t = laneDiv (laneSub (mantissa, one), laneAdd (mantissa, one));
+    auto t2 = laneMul (t, t);
+    auto series = laneMulAdd (laneMul (t, t2), calcFastPoly (t2, FAST_LOG_COEFS), laneAdd (t, t));
+
+    return laneMulAdd (exponent, laneSplat <Lane> (LN2_HI), laneMulAdd (exponent, laneSplat <Lane> (LN2_LO), series));
+}
+
+template <typename Lane> static inline Lane calcFastExp (Lane arg) {
+    auto shifted = laneMulAdd (arg, laneSplat <Lane> (INV_LN2), laneSplat <Lane> (ROUNDING_SHIFTER));
+    auto exponent = laneSub (shifted, laneSplat <Lane> (ROUNDING_SHIFTER));
+    auto rest = laneSub (laneSub (arg, laneMul (exponent, laneSplat <Lane> (LN2_HI))), laneMul (exponent, laneSplat <Lane> (LN2_LO)));
+
+    return laneScaleByExponent (calcFastPoly (rest, FAST_EXP_COEFS), shifted);
+}
+
+// sin and cos for |arg| <= PI/2 by the half angle
+template <typename Lane> static inline void calcFastSinCos (Lane arg, Lane *sinVal, Lane *cosVal) {
+    auto half = laneMul (arg, laneSplat <Lane> (0.5));
+    auto half2 = laneMul (half, half);
+    auto sinHalf = laneMul (half, calcFastPoly (half2, FAST_SIN_COEFS));
+    auto cosHalf = calcFastPoly (half2, FAST_COS_COEFS);
+
+    *sinVal = laneMul (laneAdd (sinHalf, sinHalf), cosHalf);
+    *cosVal = laneSub (laneSplat <Lane> (1.0), laneMul (laneAdd (sinHalf, sinHalf), sinHalf));
+}
+
+// atan2 for x >= 0 (result within [-PI/2, PI/2]): the half angle tangent y / (r + x), halved once more by the
+// square root so the polynomial argument is within tan (PI/8); zero for the zero vector
+template <typename Lane> static inline Lane calcFastAtan2 (Lane y, Lane x) {
+    auto one = laneSplat <Lane> (1.0);
+    auto radius = laneSqrt (laneMulAdd (x, x, laneMul (y, y)));
+    auto tanHalf = laneDiv (y, laneMax (laneAdd (radius, x), laneSplat <Lane> (DBL_MIN)));
+    auto tanQuarter = laneDiv (tanHalf, laneAdd (one, laneSqrt (laneMulAdd (tanHalf, tanHalf, one))));
+
+    return laneMul (laneMul (tanQuarter, laneSplat <Lane> (4.0)), calcFastPoly (laneMul (tanQuarter, tanQuarter), FAST_ATAN_COEFS));
+}
+
+// Conformal latitude series of the ellipsoid: e atanh (e s) = sum of e^(2k+2) s^(2k+1) / (2k+1) (the isometric latitude
+// correction by s = sin (lat)) and the coefficients of lat = chi + sum of a(k) sin (2k chi) up to e^8, Clenshaw order
+struct ConformalSeries {
+    double eccentricity [7];
+    double latitude [4];
+};
+
+static inline void initConformalSeries (double eccentricity, ConformalSeries *series) {
+    auto e2 = eccentricity * eccentricity;
+    auto e4 = e2 * e2, e6 = e4 * e2, e8 = e6 * e2;
+    auto power = e2;
+
+    for (auto k = 0; k < 7; ++ k, power *= e2) series->eccentricity [6 - k] = power / (double) (k * 2 + 1);
+
+    series->latitude [0] = e8 * 4279.0 / 161280.0;
+    series->latitude [1] = e6 * 7.0 / 120.0 + e8 * 81.0 / 1120.0;
+    series->latitude [2] = e4 * 7.0 / 48.0 + e6 * 29.0 / 240.0 + e8 * 811.0 / 11520.0;
+    series->latitude [3] = e2 * 0.5 + e4 * 5.0 / 24.0 + e6 / 12.0 + e8 * 13.0 / 360.0;
+}
+
+// e atanh (e sin (lat))
+template <typename Lane> static inline Lane calcFastEccentricityTerm (const ConformalSeries& series, Lane sinLat) {
+    return laneMul (sinLat, calcFastPoly (laneMul (sinLat, sinLat), series.eccentricity));
+}
+
+// Geodetic latitude by the conformal one and its sine and cosine
+template <typename Lane> static inline Lane calcFastGeodeticLat (const ConformalSeries& series, Lane chi, Lane sinChi, Lane cosChi) {
+    auto sinDouble = laneMul (laneAdd (sinChi, sinChi), cosChi);
+    auto twoCosDouble = laneSub (laneSplat <Lane> (2.0), laneMul (laneMul (sinChi, sinChi), laneSplat <Lane> (4.0)));
+    auto next = laneSplat <Lane> (0.0);
+    auto current = laneSplat <Lane> (series.latitude [0]);
+
+    for (auto k = 1; k < 4; ++ k) {
+        auto prev = laneSub (laneMulAdd (twoCosDouble, current, laneSplat <Lane> (series.latitude [k])), next);
+
+        next = current;
+        current = prev;
+    }
+
+    return laneMulAdd (current, sinDouble, chi);
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,114 @@
+#pragma once
+
+#include "geodefs.h"
+
+// Kernel probes feeding the performance counters (geo_stats.cpp). Everything here is compiled out unless the library
+// is built with _USE_GEO_STATS_; the probe macros expand to nothing then
+
+#ifdef _USE_GEO_STATS_
+#include <atomic>
+#include <stdint.h>
+
+#if defined (_M_X64) || defined (__x86_64__)
+#define _USE_TSC_
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#else
+#include <chrono>
+#endif
+
+namespace geo {
+    // Counters of one thread; only the owner thread writes them, so the relaxed load and store are enough and cost
+    // the same as the plain increment. Snapshots read them from the other threads
+    struct ThreadKernelStats {
+        std::atomic <uint64_t> calls, iterations, fallbacks, rejects, ticks;
+        std::atomic <uint64_t> latency [LATENCY_BUCKETS];
+    };
+
+    struct ThreadStats {
+        ThreadKernelStats kernels [GEO_KERNEL_COUNT];
+        ThreadStats *next;
+    };
+
+    // Counters are registered by the first probe of the thread and folded into the totals at the thread exit
+    struct ThreadStatsHolder {
+        ThreadStats *stats = 0;
+
+        ~ThreadStatsHolder ();
+    };
+
+    extern thread_local ThreadStatsHolder threadStats;
+
+    ThreadStats *registerThreadStats ();
+
+    inline ThreadKernelStats *getKernelStats (GeoKernel kernel) {
+        auto stats = threadStats.stats;
+
+        return (stats ? stats : registerThreadStats ())->kernels + kernel;
+    }
+
+    inline void addCounter (std::atomic <uint64_t>& counter, uint64_t value) {
+        counter.store (counter.load (std::memory_order_relaxed) + value, std::memory_order_relaxed);
+    }
+
+    // Time stamp counter where available (a few nanoseconds to read), steady clock nanoseconds otherwise
+    inline uint64_t readTicks () {
+    #ifdef _USE_TSC_
+        return __rdtsc ();
+    #else
+        return (uint64_t) std::chrono::duration_cast <std::chrono::nanoseconds> (std::chrono::steady_clock::now ().time_since_epoch ()).count ();
+    #endif
+    }
+
+    inline size_t findLatencyBucket (uint64_t ticks) {
+        if (ticks < 4) return (size_t) ticks;
+
+    #ifdef _MSC_VER
+        unsigned long msb;
+
+        _BitScanReverse64 (& msb, ticks);
+    #else
+        auto msb = 63 - __builtin_clzll (ticks);
+    #endif
+        auto bucket = (size_t) (msb - 1) * 4 + (size_t) ((ticks >> (msb - 2)) & 3);
+
+        return bucket < LATENCY_BUCKETS ? bucket : LATENCY_BUCKETS - 1;
+    }
+
+    // Times the scope of the kernel; calls, iterations and fallbacks go to the thread counters when it is left
+    class KernelProbe {
+    public:
+        uint64_t iterations = 0, fallbacks = 0;
+
+        KernelProbe (GeoKernel kernel) : kernel (kernel), start (readTicks ()) {}
+
+        ~KernelProbe () {
+            auto ticks = readTicks () - start;
+            auto stats = getKernelStats (kernel);
+
+            addCounter (stats->calls, 1);
+            addCounter (stats->iterations, iterations);
+            addCounter (stats->fallbacks, fallbacks);
+            addCounter (stats->ticks, ticks);
+            addCounter (stats->latency [findLatencyBucket (ticks)], 1);
+        }
+
+    private:
+        GeoKernel kernel;
+        uint64_t start;
+    };
+}
+
+#define GEO_PROBE(kernel) geo::KernelProbe _probe (kernel)
+#define GEO_PROBE_ITERATIONS(count) (_probe.iterations += (uint64_t) (count))
+#define GEO_PROBE_FALLBACKS(count) (_probe.fallbacks += (uint64_t) (count))
+#define GEO_COUNT_REJECT(kernel) geo::addCounter (geo::getKernelStats (kernel)->rejects, 1)
+#else
+#define GEO_PROBE(kernel)
+#define GEO_PROBE_ITERATIONS(count) ((void) (count))
+#define GEO_PROBE_FALLBACKS(count) ((void) (count))
+#define GEO_COUNT_REJECT(kernel) ((void) 0)
+#endif
@@ -2,8 +2,14 @@
 #include <stdio.h>
 #include <ctype.h>
 #include <string.h>
+#include <math.h>
+#include <chrono>
+#include <initializer_list>
+#include <vector>
 
 #include "geo.h"
+#include "geoabi.h"
+#include "geoconstexpr.h"
 
 #include <Windows.h>
 #include "Library Interface.h"
@@ -21,13 +27,19 @@ void showHelp () {
         "commands are:\n"
         "\tb\tcalculate bearing and range from one point to another one\n"
         "\tp\tcalculate point by origin point, bearing and range\n"
+        "\tt\tmeasure batch kernels throughput for every arithmetic type and the float error (from origin if specified)\n"
+        "\tr\treplay the capture file (-c) and compare the results\n"
+        "\tv\tcheck the kernels against the reference values\n"
         "\th|?\thelp\n\n"
         "options are:\n"
-        "\t-o:lat,lon\torigin position\n"
+        "\t-o:lat,lon\torigin position (decimal degrees or dd mm.mmmS)\n"
         "\t-d:lat,lon\tdestination position\n"
         "\t-r:value\trange from origin (nm)\n"
         "\t-b:value\tbearing from origin (deg)\n"
-        "\t-m:o[rthodromy]|l[oxodromy]\n\n"
+        "\t-m:o[rthodromy]|l[oxodromy]\n"
+        "\t-k:file,file\town ship and target track files for the warm started inverse problem benchmark\n"
+        "\t-c:file\tcapture file to write the calls to (to replay for the r command)\n"
+        "\t-s:t[ext]|p[rometheus]\tprint the kernel counters afterwards (library built with _USE_GEO_STATS_)\n\n"
     );
 
     die ();
@@ -37,9 +49,8 @@ bool parsePosition (geo::Pos& position, char *source) {
     char *comma = strchr (source, ',');
     bool result = false;
 
-    if (comma) {
-        position.lat = atof (source);
-        position.lon = atof (comma + 1);
+    if (comma && geo::parseGeoValue (source, comma - source, true, & position.lat) && geo::parseGeoValue (comma + 1, strlen (comma + 1), false, & position.lon)) {
+        geo::ptToDeg (& position);
 
         result = position.lat >= -85.0 && position.lat <= 85.0 && position.lon >= -180.0 && position.lon <= 180.0;
     }
@@ -47,9 +58,1805 @@ bool parsePosition (geo::Pos& position, char *source) {
     return result;
 }
 
+constexpr double dmsToRad (double deg, double min, double sec) {
+    return (deg + min / 60.0 + sec / 3600.0) * geo::RAD_IN_DEG;
+}
+
+// Compile time kernels against known values: one degree of the equator (equatorial radius times PI/180) and Vincenty's
+// example of the geodesic from Flinders Peak to Buninyong, 54972.271 m at 306 52' 05.37" arriving at 307 10' 25.07";
+// the published values are rounded to 1 mm and 0.01", INVER1 is within 1.5 cm of the range at this length
+constexpr geo::ce::Leg CE_EQUATOR_LEG = geo::ce::calcRhumblineLeg ({ 0.0, 0.0 }, { 0.0, geo::RAD_IN_DEG });
+constexpr geo::ce::Leg CE_VINCENTY_LEG = geo::ce::calcGreatCircleLeg ({ - dmsToRad (37.0, 57.0, 3.72030), dmsToRad (144.0, 25.0, 29.52440) },
+                                                                      { - dmsToRad (37.0, 39.0, 10.15610), dmsToRad (143.0, 55.0, 35.38390) });
+
+static_assert (geo::ce::fabs (CE_EQUATOR_LEG.range - 6378137.0 * geo::RAD_IN_DEG / geo::METERS_IN_NM) < 1.0e-9, "rhumb line range along the equator");
+static_assert (CE_EQUATOR_LEG.bearing == geo::HALF_PI && CE_EQUATOR_LEG.endBearing == geo::HALF_PI, "rhumb line bearing along the equator");
+static_assert (geo::ce::fabs (CE_VINCENTY_LEG.range - 54972.271 / geo::METERS_IN_NM) < 0.015 / geo::METERS_IN_NM, "great circle range of Vincenty's example");
+static_assert (geo::ce::fabs (CE_VINCENTY_LEG.bearing - dmsToRad (306.0, 52.0, 5.37)) < dmsToRad (0.0, 0.0, 0.01), "great circle bearing of Vincenty's example");
+static_assert (geo::ce::fabs (CE_VINCENTY_LEG.endBearing - dmsToRad (307.0, 10.0, 25.07)) < dmsToRad (0.0, 0.0, 0.01), "great circle end bearing of Vincenty's example");
+
+// Direct problem kernels over the arithmetic type; ranges up to 3000 nm, bearings all around
+template <typename Real> void benchmarkKernels (const char *typeName, geo::Pos& origin, size_t count) {
+    std::vector <Real> ranges (count), bearings (count), lat (count), lon (count);
+
+    for (size_t i = 0; i < count; ++ i) {
+        ranges [i] = (Real) (1 + i % 3000);
+        bearings [i] = (Real) fmod (i * 0.013, geo::TWO_PI);
+    }
+
+    auto measure = [&] (const char *kernel, bool (*func) (const geo::Ellipsoid *, const geo::Pos *, const Real *, const Real *, size_t, Real *, Real *),
+                        std::vector <Real>& source1, std::vector <Real>& source2, std::vector <Real>& dest1, std::vector <Real>& dest2) {
+        auto start = std::chrono::steady_clock::now ();
+
+        func (0, & origin, source1.data (), source2.data (), count, dest1.data (), dest2.data ());
+
+        std::chrono::duration <double> elapsed = std::chrono::steady_clock::now () - start;
+
+        printf ("%-10s %-12s %8.2f Mpts/s\n", kernel, typeName, (double) count / elapsed.count () * 1.0e-6);
+    };
+
+    std::vector <Real> rangesBack (count), bearingsBack (count);
+
+    measure ("RL", geo::calcRhumblinePosT <Real>, ranges, bearings, lat, lon);
+    measure ("RL inverse", geo::calcRhumblineDistAndBrgT <Real>, lat, lon, rangesBack, bearingsBack);
+    measure ("GC", geo::calcGreatCirclePosT <Real>, ranges, bearings, lat, lon);
+    measure ("GC inverse", geo::calcGreatCircleDistAndBrgT <Real>, lat, lon, rangesBack, bearingsBack);
+
+    // GC end points are projected around the origin
+    std::vector <Real> easting (count), northing (count);
+    auto start = std::chrono::steady_clock::now ();
+
+    geo::projectMercatorT <Real> (0, & origin, 1.0, lat.data (), lon.data (), count, easting.data (), northing.data ());
+
+    std::chrono::duration <double> elapsed = std::chrono::steady_clock::now () - start;
+
+    printf ("%-10s %-12s %8.2f Mpts/s\n", "MP", typeName, (double) count / elapsed.count () * 1.0e-6);
+}
+
+// Reference checks; every failure is printed and counted, the tool exits with the error code if any
+int checkCount = 0, failedChecks = 0;
+
+bool checkCondition (const char *what, bool passed) {
+    ++ checkCount;
+
+    if (!passed) {
+        ++ failedChecks;
+        printf ("FAILED %s\n", what);
+    }
+
+    return passed;
+}
+
+bool checkValue (const char *what, const char *quantity, double value, double expected, double tolerance) {
+    char text [256];
+
+    snprintf (text, sizeof (text), "%s, %s: %.9g, expected %.9g within %.3g", what, quantity, value, expected, tolerance);
+
+    return checkCondition (text, fabs (value - expected) <= tolerance);
+}
+
+// Distance in meters between the float and the double results (spherical, good enough for the error estimate)
+double calcErrorDistance (double lat, double lon, float latF, float lonF) {
+    auto deltaLon = fabs ((double) lonF - lon);
+
+    if (deltaLon > geo::PI) deltaLon = geo::TWO_PI - deltaLon;
+
+    return hypot ((double) latF - lat, deltaLon * cos (lat)) * geo::WGS84_EQUAT_RAD_M;
+}
+
+// Worst error of the float kernels against the double ones for the same (float) input values; the bounds documented
+// in geo.h are checked, the errors are printed if report is set
+void checkFloatKernels (geo::Pos& origin, size_t count, bool report) {
+    std::vector <float> rangesF (count), bearingsF (count), latF (count), lonF (count), eastingF (count), northingF (count);
+    std::vector <double> ranges (count), bearings (count), lat (count), lon (count), easting (count), northing (count);
+
+    // Range limits (nm) and the error bounds (m) of the direct and the inverse kernels; rhumb lines ending within
+    // 2 degrees of the pole are out of the bounds
+    static const double MAX_RANGES [] = { 500.0, 3000.0 }, ERROR_BOUNDS [] = { 1.5, 6.0 };
+    double maxLat = geo::HALF_PI;
+
+    for (size_t i = 0; i < count; ++ i) {
+        rangesF [i] = (float) (0.5 + fmod (i * 7.919, 3000.0));
+        bearingsF [i] = (float) fmod (i * 0.013, geo::TWO_PI);
+        ranges [i] = rangesF [i];
+        bearings [i] = bearingsF [i];
+    }
+
+    auto worstError = [&] (double maxRange) {
+        double worst = 0.0;
+
+        for (size_t i = 0; i < count; ++ i) {
+            if (ranges [i] <= maxRange && fabs (lat [i]) <= maxLat) worst = fmax (worst, calcErrorDistance (lat [i], lon [i], latF [i], lonF [i]));
+        }
+
+        return worst;
+    };
+
+    auto checkErrors = [&] (const char *kernel, const char *problem, auto worstErrorUpTo) {
+        double errors [2];
+        char what [128];
+
+        for (size_t i = 0; i < 2; ++ i) {
+            errors [i] = worstErrorUpTo (MAX_RANGES [i]);
+
+            snprintf (what, sizeof (what), "%s float %s up to %.0f nm", kernel, problem, MAX_RANGES [i]);
+            checkValue (what, "error m", errors [i], 0.0, ERROR_BOUNDS [i]);
+        }
+
+        if (report) printf ("%s float %s error: %.2f m up to 500 nm, %.2f m up to 3000 nm\n", kernel, problem, errors [0], errors [1]);
+    };
+
+    auto check = [&] (const char *kernel, bool (*funcF) (const geo::Ellipsoid *, const geo::Pos *, const float *, const float *, size_t, float *, float *),
+                      bool (*func) (const geo::Ellipsoid *, const geo::Pos *, const double *, const double *, size_t, double *, double *)) {
+        funcF (0, & origin, rangesF.data (), bearingsF.data (), count, latF.data (), lonF.data ());
+        func (0, & origin, ranges.data (), bearings.data (), count, lat.data (), lon.data ());
+
+        checkErrors (kernel, "direct", worstError);
+    };
+
+    // Inverse problems to the float end points of the direct ones; range error and the bearing one as the lateral offset
+    // at the end point
+    std::vector <float> rangesBackF (count), bearingsBackF (count);
+    std::vector <double> rangesBack (count), bearingsBack (count);
+
+    auto worstInverseError = [&] (double maxRange) {
+        double worst = 0.0;
+
+        for (size_t i = 0; i < count; ++ i) {
+            if (rangesBack [i] > maxRange || fabs (lat [i]) > maxLat) continue;
+
+            auto bearingError = fabs ((double) bearingsBackF [i] - bearingsBack [i]);
+
+            if (bearingError > geo::PI) bearingError = geo::TWO_PI - bearingError;
+
+            worst = fmax (worst, fabs ((double) rangesBackF [i] - rangesBack [i]) * geo::METERS_IN_NM);
+            worst = fmax (worst, bearingError * rangesBack [i] * geo::METERS_IN_NM);
+        }
+
+        return worst;
+    };
+
+    auto checkInverse = [&] (const char *kernel, bool (*funcF) (const geo::Ellipsoid *, const geo::Pos *, const float *, const float *, size_t, float *, float *),
+                             bool (*func) (const geo::Ellipsoid *, const geo::Pos *, const double *, const double *, size_t, double *, double *)) {
+        for (size_t i = 0; i < count; ++ i) {
+            lat [i] = latF [i];
+            lon [i] = lonF [i];
+        }
+
+        funcF (0, & origin, latF.data (), lonF.data (), count, rangesBackF.data (), bearingsBackF.data ());
+        func (0, & origin, lat.data (), lon.data (), count, rangesBack.data (), bearingsBack.data ());
+
+        checkErrors (kernel, "inverse", worstInverseError);
+    };
+
+    maxLat = geo::HALF_PI - 2.0 * geo::RAD_IN_DEG;
+
+    check ("RL", geo::calcRhumblinePosT <float>, geo::calcRhumblinePosT <double>);
+    checkInverse ("RL", geo::calcRhumblineDistAndBrgT <float>, geo::calcRhumblineDistAndBrgT <double>);
+
+    maxLat = geo::HALF_PI;
+
+    check ("GC", geo::calcGreatCirclePosT <float>, geo::calcGreatCirclePosT <double>);
+    checkInverse ("GC", geo::calcGreatCircleDistAndBrgT <float>, geo::calcGreatCircleDistAndBrgT <double>);
+
+    // Mercator round trip of the GC end points up to 500 nm from the origin
+    size_t nearCount = 0;
+
+    for (size_t i = 0; i < count; ++ i) {
+        if (ranges [i] > 500.0) continue;
+
+        latF [nearCount] = (float) lat [i];
+        lonF [nearCount] = (float) lon [i];
+        lat [nearCount] = latF [nearCount];
+        lon [nearCount] = lonF [nearCount];
+
+        ++ nearCount;
+    }
+
+    geo::projectMercatorT <float> (0, & origin, 1.0, latF.data (), lonF.data (), nearCount, eastingF.data (), northingF.data ());
+    geo::projectMercatorT <double> (0, & origin, 1.0, lat.data (), lon.data (), nearCount, easting.data (), northing.data ());
+
+    double worstProjection = 0.0;
+
+    for (size_t i = 0; i < nearCount; ++ i)
+        worstProjection = fmax (worstProjection, hypot ((double) eastingF [i] - easting [i], (double) northingF [i] - northing [i]) * geo::METERS_IN_NM * cos (lat [i]));
+
+    geo::unprojectMercatorT <float> (0, & origin, 1.0, eastingF.data (), northingF.data (), nearCount, latF.data (), lonF.data ());
+    geo::unprojectMercatorT <double> (0, & origin, 1.0, easting.data (), northing.data (), nearCount, lat.data (), lon.data ());
+
+    double worstRoundTrip = 0.0;
+
+    for (size_t i = 0; i < nearCount; ++ i) worstRoundTrip = fmax (worstRoundTrip, calcErrorDistance (lat [i], lon [i], latF [i], lonF [i]));
+
+    checkValue ("MP float forward up to 500 nm", "error m", worstProjection, 0.0, 1.0);
+    checkValue ("MP float round trip up to 500 nm", "error m", worstRoundTrip, 0.0, 1.0);
+
+    if (report) printf ("MP float error up to 500 nm: %.2f m forward, %.2f m round trip\n", worstProjection, worstRoundTrip);
+}
+
+// Polynomial Mercator kernels against the documented bounds up to 89 degrees of latitude; the odd count runs the
+// register pair, the single register, the SSE2 and the scalar paths
+void checkFastMercator (geo::Pos& origin, double k0) {
+    static const size_t COUNT = 4099;
+    static const double MAX_LAT = 89.0 * geo::RAD_IN_DEG;
+    std::vector <double> lat (COUNT), lon (COUNT), easting (COUNT), northing (COUNT), eastingFast (COUNT), northingFast (COUNT), latFast (COUNT), lonFast (COUNT);
+
+    for (size_t i = 0; i < COUNT; ++ i) {
+        lat [i] = MAX_LAT * (2.0 * i / (COUNT - 1) - 1.0);
+        lon [i] = origin.lon + fmod (i * 0.0011, 0.6) - 0.3;
+
+        geo::normalizeLon (& lon [i]);
+    }
+
+    geo::projectMercatorT <double> (0, & origin, k0, lat.data (), lon.data (), COUNT, easting.data (), northing.data ());
+
+    auto forward = geo::projectMercatorFast (0, & origin, k0, lat.data (), lon.data (), COUNT, eastingFast.data (), northingFast.data ());
+    auto inverse = geo::unprojectMercatorFast (0, & origin, k0, easting.data (), northing.data (), COUNT, latFast.data (), lonFast.data ());
+    double worstEasting = 0.0, worstNorthing = 0.0, worstLat = 0.0, worstLon = 0.0;
+
+    for (size_t i = 0; i < COUNT; ++ i) {
+        worstEasting = fmax (worstEasting, fabs (eastingFast [i] - easting [i]));
+        worstNorthing = fmax (worstNorthing, fabs (northingFast [i] - northing [i]));
+        worstLat = fmax (worstLat, fabs (latFast [i] - lat [i]));
+        worstLon = fmax (worstLon, fabs (lonFast [i] - lon [i]));
+    }
+
+    char what [128];
+
+    snprintf (what, sizeof (what), "MP fast from %.0f deg, k0 %g", origin.lat * geo::DEG_IN_RAD, k0);
+    checkCondition (what, forward && inverse);
+    checkValue (what, "easting error nm", worstEasting, 0.0, 0.0);
+    checkValue (what, "northing error nm", worstNorthing, 0.0, 6.0e-10 * k0);
+    checkValue (what, "latitude back error rad", worstLat, 0.0, 2.0e-12);
+    checkValue (what, "longitude back error rad", worstLon, 0.0, 1.0e-15);
+}
+
+// UTM zones with the Norway and Svalbard exceptions, a published projection, the southern false northing and the
+// forward/inverse round trip
+void checkUtm () {
+    static const double UTM_SCALE = 0.9996;
+    struct {
+        double lat, lon;
+        int zone;
+    } zoneCases [] = {
+        { 33.3, 44.4, 38 }, { -33.9, 18.4, -34 }, { 60.0, 5.0, 32 }, { 75.0, 9.1, 33 }, { 75.0, 8.9, 31 },
+        { 0.0, 179.9, 60 }, { 0.0, -180.0, 1 }, { 84.5, 0.0, 0 }, { -80.5, 0.0, 0 },
+    };
+
+    for (auto& test : zoneCases) {
+        char what [128];
+
+        snprintf (what, sizeof (what), "UTM zone of [%g; %g]", test.lat, test.lon);
+        checkValue (what, "zone", geo::findUtmZone (test.lat * geo::RAD_IN_DEG, test.lon * geo::RAD_IN_DEG), test.zone, 0.0);
+    }
+
+    // 33.3N 44.4E in zone 38, also by the transverse Mercator on its central meridian
+    double lat = 33.3 * geo::RAD_IN_DEG, lon = 44.4 * geo::RAD_IN_DEG, easting, northing, x, y;
+    int zone;
+
+    if (checkCondition ("UTM of [33.3; 44.4]", geo::projectUtm (0, & lat, & lon, 1, 0, & zone, & easting, & northing))) {
+        checkValue ("UTM of [33.3; 44.4]", "zone", zone, 38.0, 0.0);
+        checkValue ("UTM of [33.3; 44.4]", "easting m", easting, 444140.54, 0.01);
+        checkValue ("UTM of [33.3; 44.4]", "northing m", northing, 3684706.36, 0.01);
+    }
+
+    if (checkCondition ("TM of [33.3; 44.4]", geo::projectTransverseMercator (0, 45.0 * geo::RAD_IN_DEG, UTM_SCALE, & lat, & lon, 1, & x, & y))) {
+        checkValue ("TM of [33.3; 44.4]", "x m", x, 444140.54 - 500000.0, 0.01);
+        checkValue ("TM of [33.3; 44.4]", "y m", y, 3684706.36, 0.01);
+    }
+
+    // Points mirrored over the equator: the southern northing is the false northing less the northern one
+    static const size_t COUNT = 64;
+    std::vector <double> lats (COUNT), lons (COUNT), eastings (COUNT), northings (COUNT), latsBack (COUNT), lonsBack (COUNT);
+    std::vector <int> zones (COUNT);
+
+    for (size_t i = 0; i < COUNT; ++ i) {
+        lats [i] = (i & 1 ? -1.0 : 1.0) * (0.5 + 79.0 * (i / 2) / (COUNT / 2 - 1)) * geo::RAD_IN_DEG;
+        lons [i] = (-179.0 + 358.0 * i / (COUNT - 1)) * geo::RAD_IN_DEG;
+    }
+
+    auto forward = geo::projectUtm (0, lats.data (), lons.data (), COUNT, 0, zones.data (), eastings.data (), northings.data ());
+    auto inverse = geo::unprojectUtm (0, zones.data (), eastings.data (), northings.data (), COUNT, latsBack.data (), lonsBack.data ());
+    double worstLat = 0.0, worstLon = 0.0, worstMirror = 0.0;
+
+    for (size_t i = 0; i < COUNT; ++ i) {
+        auto deltaLon = fabs (lonsBack [i] - lons [i]);
+
+        worstLat = fmax (worstLat, fabs (latsBack [i] - lats [i]));
+        worstLon = fmax (worstLon, fmin (deltaLon, geo::TWO_PI - deltaLon));
+
+        if (lats [i] < 0.0) {
+            double mirrorLat = - lats [i], mirrorEasting, mirrorNorthing;
+
+            geo::projectUtm (0, & mirrorLat, & lons [i], 1, - zones [i], 0, & mirrorEasting, & mirrorNorthing);
+
+            worstMirror = fmax (worstMirror, fmax (fabs (mirrorEasting - eastings [i]), fabs (10000000.0 - mirrorNorthing - northings [i])));
+        }
+    }
+
+    checkCondition ("UTM round trip", forward && inverse);
+    checkValue ("UTM round trip", "latitude error rad", worstLat, 0.0, 1.0e-11);
+    checkValue ("UTM round trip", "longitude error rad", worstLon, 0.0, 1.0e-11);
+    checkValue ("UTM southern hemisphere", "false northing error m", worstMirror, 0.0, 1.0e-6);
+
+    // Out of 80S..84N there is no zone, the point gives zeros
+    lat = 85.0 * geo::RAD_IN_DEG;
+    geo::projectUtm (0, & lat, & lon, 1, 0, & zone, & easting, & northing);
+    checkCondition ("UTM of [85; 44.4] refused", zone == 0 && easting == 0.0 && northing == 0.0);
+}
+
+// Molodensky shifts of every datum against the exact conversion through ECEF (geodetic to ECEF on the datum
+// ellipsoid, dx/dy/dz added, back to geodetic on WGS84) and the shift back to the datum inverting the forward one;
+// errors are in meters on the ground, the largest (up to 0.15 m standard, 0.5 m abridged) for the largest shifts
+void checkDatumShifts () {
+    static const int DATUM_IDS [] = { 1, 32, 33, 65, 70, 133, 140, 154, 173, 200, 209, 217 };
+    static const size_t COUNT = 37;
+    std::vector <double> lat (COUNT), lon (COUNT), height (COUNT), x (COUNT), y (COUNT), z (COUNT), exactLat (COUNT), exactLon (COUNT), exactHeight (COUNT);
+
+    for (size_t i = 0; i < COUNT; ++ i) {
+        lat [i] = (-80.0 + 160.0 * i / (COUNT - 1)) * geo::RAD_IN_DEG;
+        lon [i] = (-179.0 + 358.0 * ((i * 7) % COUNT) / (COUNT - 1)) * geo::RAD_IN_DEG;
+        height [i] = (double) (i % 5) * 500.0;
+    }
+
+    for (auto datumId : DATUM_IDS) {
+        auto datum = geo::findDatum (datumId);
+        char what [128];
+
+        snprintf (what, sizeof (what), "Datum %d", datumId);
+
+        if (!checkCondition (what, datum != 0)) continue;
+
+        geo::geodeticToEcef (& datum->ellipsoid, lat.data (), lon.data (), height.data (), COUNT, x.data (), y.data (), z.data ());
+
+        for (size_t i = 0; i < COUNT; ++ i) {
+            x [i] += datum->dx;
+            y [i] += datum->dy;
+            z [i] += datum->dz;
+        }
+
+        geo::ecefToGeodetic (0, x.data (), y.data (), z.data (), COUNT, exactLat.data (), exactLon.data (), exactHeight.data ());
+
+        for (auto method : { geo::MOLODENSKY_STANDARD, geo::MOLODENSKY_ABRIDGED }) {
+            auto abridged = method == geo::MOLODENSKY_ABRIDGED;
+            auto shiftedLat = lat, shiftedLon = lon, shiftedHeight = height;
+            geo::PosBatch points { shiftedLat.data (), shiftedLon.data (), COUNT, COUNT };
+            double worstForward = 0.0, worstHeight = 0.0, worstBack = 0.0;
+
+            snprintf (what, sizeof (what), "Datum %d, Molodensky %s", datumId, abridged ? "abridged" : "standard");
+
+            if (!checkCondition (what, geo::convertDatum (datum, method, true, & points, shiftedHeight.data ()))) continue;
+
+            for (size_t i = 0; i < COUNT; ++ i) {
+                auto deltaLon = fabs (shiftedLon [i] - exactLon [i]);
+
+                deltaLon = fmin (deltaLon, geo::TWO_PI - deltaLon) * cos (lat [i]);
+
+                worstForward = fmax (worstForward, hypot (shiftedLat [i] - exactLat [i], deltaLon) * geo::WGS84_EQUAT_RAD_M);
+                worstHeight = fmax (worstHeight, fabs (shiftedHeight [i] - exactHeight [i]));
+            }
+
+            geo::convertDatum (datum, method, false, & points, shiftedHeight.data ());
+
+            for (size_t i = 0; i < COUNT; ++ i) {
+                auto deltaLon = fabs (shiftedLon [i] - lon [i]);
+
+                deltaLon = fmin (deltaLon, geo::TWO_PI - deltaLon) * cos (lat [i]);
+
+                worstBack = fmax (worstBack, fmax (hypot (shiftedLat [i] - lat [i], deltaLon) * geo::WGS84_EQUAT_RAD_M, fabs (shiftedHeight [i] - height [i])));
+            }
+
+            checkValue (what, "horizontal error m", worstForward, 0.0, abridged ? 1.0 : 0.25);
+            checkValue (what, "height error m", worstHeight, 0.0, abridged ? 1.0 : 0.25);
+            checkValue (what, "round trip error m", worstBack, 0.0, 0.5);
+        }
+    }
+}
+
+// ECEF round trip from below the sea to the orbit heights, the center refused, and the Helmert transform on the
+// position vector example of EPSG guidance note 7-2 (WGS72 to WGS84), which a coordinate frame sign would miss by 20 m
+void checkEcef () {
+    static const size_t COUNT = 41;
+    std::vector <double> lat (COUNT), lon (COUNT), height (COUNT), x (COUNT), y (COUNT), z (COUNT), latBack (COUNT), lonBack (COUNT), heightBack (COUNT);
+
+    for (size_t i = 0; i < COUNT; ++ i) {
+        lat [i] = (-90.0 + 180.0 * i / (COUNT - 1)) * geo::RAD_IN_DEG;
+        lon [i] = (-180.0 + 360.0 * ((i * 11) % COUNT) / COUNT) * geo::RAD_IN_DEG;
+        height [i] = i % 4 == 3 ? 2.0e7 : (double) (i % 4) * 4000.0 - 1000.0;
+    }
+
+    auto forward = geo::geodeticToEcef (0, lat.data (), lon.data (), height.data (), COUNT, x.data (), y.data (), z.data ());
+    auto inverse = geo::ecefToGeodetic (0, x.data (), y.data (), z.data (), COUNT, latBack.data (), lonBack.data (), heightBack.data ());
+    double worstLat = 0.0, worstLon = 0.0, worstHeight = 0.0;
+
+    for (size_t i = 0; i < COUNT; ++ i) {
+        worstLat = fmax (worstLat, fabs (latBack [i] - lat [i]));
+        worstHeight = fmax (worstHeight, fabs (heightBack [i] - height [i]));
+
+        // The longitude of the poles is any
+        if (fabs (lat [i]) < geo::HALF_PI - 1.0e-9) worstLon = fmax (worstLon, fabs (lonBack [i] - lon [i]));
+    }
+
+    checkCondition ("ECEF round trip", forward && inverse);
+    checkValue ("ECEF round trip", "latitude error rad", worstLat, 0.0, 1.0e-14);
+    checkValue ("ECEF round trip", "longitude error rad", worstLon, 0.0, 1.0e-15);
+    checkValue ("ECEF round trip", "height error m", worstHeight, 0.0, 1.0e-7);
+
+    // The center and a point within the evolute give zeros, the point beside them is converted
+    double centerX [] = { 0.0, 20000.0, geo::WGS84_EQUAT_RAD_M }, centerY [] = { 0.0, 0.0, 0.0 }, centerZ [] = { 0.0, 10000.0, 0.0 };
+    double centerLat [3], centerLon [3], centerHeight [3];
+
+    checkCondition ("ECEF of the center refused", !geo::ecefToGeodetic (0, centerX, centerY, centerZ, 3, centerLat, centerLon, centerHeight) &&
+                                                  centerLat [0] == 0.0 && centerLon [0] == 0.0 && centerHeight [0] == 0.0 &&
+                                                  centerLat [1] == 0.0 && centerLon [1] == 0.0 && centerHeight [1] == 0.0);
+    checkValue ("ECEF beside the center", "height m", centerHeight [2], 0.0, 1.0e-9);
+
+    // EPSG guidance note 7-2, position vector transformation WGS72 -> WGS84 (published to the centimeter)
+    static const geo::Ellipsoid WGS72_ELLIPSOID { 6378135.0, 1.0 / 298.26 };
+    geo::HelmertParams params { 0.0, 0.0, 4.5, 0.0, 0.0, 0.554, 0.219 };
+    double helmertX = 3657660.66, helmertY = 255768.55, helmertZ = 5201382.11;
+
+    if (checkCondition ("Helmert EPSG example", geo::transformHelmert (& params, 1, & helmertX, & helmertY, & helmertZ))) {
+        checkValue ("Helmert EPSG example", "X m", helmertX, 3657660.78, 0.01);
+        checkValue ("Helmert EPSG example", "Y m", helmertY, 255778.43, 0.01);
+        checkValue ("Helmert EPSG example", "Z m", helmertZ, 5201387.75, 0.01);
+    }
+
+    // The fused pipeline from the WGS72 geodetic position of the example lands on the WGS84 one, within the same rounding
+    double sourceX = 3657660.66, sourceY = 255768.55, sourceZ = 5201382.11, targetX = 3657660.78, targetY = 255778.43, targetZ = 5201387.75;
+    double sourceLat, sourceLon, sourceHeight, targetLat, targetLon, targetHeight;
+
+    geo::ecefToGeodetic (& WGS72_ELLIPSOID, & sourceX, & sourceY, & sourceZ, 1, & sourceLat, & sourceLon, & sourceHeight);
+    geo::ecefToGeodetic (0, & targetX, & targetY, & targetZ, 1, & targetLat, & targetLon, & targetHeight);
+
+    geo::PosBatch points { & sourceLat, & sourceLon, 1, 1 };
+
+    if (checkCondition ("Helmert EPSG example fused", geo::convertHelmert (& WGS72_ELLIPSOID, 0, & params, & points, & sourceHeight))) {
+        checkValue ("Helmert EPSG example fused", "latitude error m", (sourceLat - targetLat) * geo::WGS84_EQUAT_RAD_M, 0.0, 0.01);
+        checkValue ("Helmert EPSG example fused", "longitude error m", (sourceLon - targetLon) * geo::WGS84_EQUAT_RAD_M * cos (targetLat), 0.0, 0.01);
+        checkValue ("Helmert EPSG example fused", "height m", sourceHeight, targetHeight, 0.01);
+    }
+}
+
+// Local plane legs up to 12 nm placed by DIRCT1 (the constexpr one, which takes any latitude): the difference of the
+// local solution from INVER1 (range and cross track together) is within the returned bound plus the INVER1 convergence
+// slack (DEFPRECISION of the longitude, 0.6 mm), from the placed range and bearing within the bound plus 1e-9 nm; with
+// a tighter limit exactly the points whose bound exceeds it take the exact path
+void checkLocalFrame () {
+    static const size_t COUNT = 1001;
+    static const double MAX_ERROR = 0.01 * geo::NM_IN_METER, INVER1_SLACK = 2.0 * geo::DEFPRECISION * geo::WGS84_EQUAT_RAD_M * geo::NM_IN_METER;
+    std::vector <double> lat (COUNT), lon (COUNT), placedRanges (COUNT), placedBearings (COUNT), ranges (COUNT), bearings (COUNT), bounds (COUNT),
+                         rangesExact (COUNT), bearingsExact (COUNT);
+
+    for (auto anchorLat : { 0.0, 45.0, 60.0, 80.0, -70.0 }) {
+        geo::Pos anchor { anchorLat * geo::RAD_IN_DEG, 0.3 };
+        geo::LocalFrame frame, limitedFrame, exactFrame;
+        char what [128];
+
+        snprintf (what, sizeof (what), "ENU local frame at %.0f deg", anchorLat);
+
+        if (!checkCondition (what, geo::initLocalFrame (0, & anchor, 1.0, & frame) && geo::initLocalFrame (0, & anchor, MAX_ERROR, & limitedFrame) &&
+                                   geo::initLocalFrame (0, & anchor, 0.0, & exactFrame))) continue;
+
+        for (size_t i = 0; i < COUNT; ++ i) {
+            placedRanges [i] = 12.0 * i / (COUNT - 1);
+            placedBearings [i] = fmod (i * 0.37, geo::TWO_PI);
+
+            auto target = geo::ce::calcGreatCirclePos (anchor, placedRanges [i], placedBearings [i]);
+
+            lat [i] = target.lat;
+            lon [i] = target.lon;
+        }
+
+        geo::calcLocalDistAndBrgBatch (& exactFrame, lat.data (), lon.data (), COUNT, rangesExact.data (), bearingsExact.data (), 0);
+
+        size_t offInver1 = 0, offPlaced = 0, overLimit = 0, exactCount = 0, offExact = 0;
+
+        for (size_t i = 0; i < COUNT; ++ i) {
+            geo::Pos target { lat [i], lon [i] };
+
+            geo::calcLocalDistAndBrg (& frame, & target, ranges.data () + i, bearings.data () + i, bounds.data () + i);
+
+            auto inver1Diff = fabs (ranges [i] - rangesExact [i]) + rangesExact [i] * fabs (remainder (bearings [i] - bearingsExact [i], geo::TWO_PI));
+            auto placedDiff = fabs (ranges [i] - placedRanges [i]) + placedRanges [i] * fabs (remainder (bearings [i] - placedBearings [i], geo::TWO_PI));
+
+            if (inver1Diff > bounds [i] + INVER1_SLACK) ++ offInver1;
+            if (placedDiff > bounds [i] + 1.0e-9) ++ offPlaced;
+            if (bounds [i] > MAX_ERROR) ++ overLimit;
+        }
+
+        checkValue (what, "points off INVER1 past the bound", (double) offInver1, 0.0, 0.0);
+        checkValue (what, "points off the placed legs past the bound", (double) offPlaced, 0.0, 0.0);
+
+        // Points over the limit are solved exactly, the others locally as above
+        geo::calcLocalDistAndBrgBatch (& limitedFrame, lat.data (), lon.data (), COUNT, ranges.data (), bearings.data (), & exactCount);
+
+        for (size_t i = 0; i < COUNT; ++ i) {
+            if (bounds [i] > MAX_ERROR && (ranges [i] != rangesExact [i] || bearings [i] != bearingsExact [i])) ++ offExact;
+        }
+
+        checkCondition (what, overLimit > 0 && overLimit < COUNT);
+        checkValue (what, "exact count", (double) exactCount, (double) overLimit, 0.0);
+        checkValue (what, "exact points off INVER1", (double) offExact, 0.0, 0.0);
+    }
+}
+
+// Polynomial Mercator kernels against the exact ones on a chart sized grid around the origin (k0 = 1)
+void benchmarkFastMercator (geo::Pos& origin, size_t count) {
+    std::vector <double> lat (count), lon (count), easting (count), northing (count), eastingFast (count), northingFast (count), latFast (count), lonFast (count);
+
+    for (size_t i = 0; i < count; ++ i) {
+        lat [i] = fmax (-1.5, fmin (1.5, origin.lat + fmod (i * 0.0007, 0.4) - 0.2));
+        lon [i] = origin.lon + fmod (i * 0.0011, 0.6) - 0.3;
+
+        geo::normalizeLon (& lon [i]);
+    }
+
+    auto measure = [&] (const char *kernel, bool (*func) (const geo::Ellipsoid *, const geo::Pos *, double, const double *, const double *, size_t, double *, double *),
+                        const double *source1, const double *source2, double *dest1, double *dest2) {
+        auto start = std::chrono::steady_clock::now ();
+
+        func (0, & origin, 1.0, source1, source2, count, dest1, dest2);
+
+        std::chrono::duration <double> elapsed = std::chrono::steady_clock::now () - start;
+
+        printf ("%s %8.2f Mpts/s\n", kernel, (double) count / elapsed.count () * 1.0e-6);
+    };
+
+    measure ("MP exact forward", geo::projectMercatorT <double>, lat.data (), lon.data (), easting.data (), northing.data ());
+    measure ("MP fast forward ", geo::projectMercatorFast, lat.data (), lon.data (), eastingFast.data (), northingFast.data ());
+    measure ("MP fast inverse ", geo::unprojectMercatorFast, easting.data (), northing.data (), latFast.data (), lonFast.data ());
+
+    double worstForward = 0.0, worstInverse = 0.0;
+
+    for (size_t i = 0; i < count; ++ i) {
+        worstForward = fmax (worstForward, hypot (eastingFast [i] - easting [i], northingFast [i] - northing [i]) * geo::METERS_IN_NM * cos (lat [i]));
+        worstInverse = fmax (worstInverse, hypot (latFast [i] - lat [i], (lonFast [i] - lon [i]) * cos (lat [i])) * geo::WGS84_EQUAT_RAD_M);
+    }
+
+    printf ("MP fast error: %.3g m forward, %.3g m inverse\n", worstForward, worstInverse);
+}
+
+// Local plane against the exact inverse problem for targets up to 12 nm around the origin (own ship)
+void benchmarkLocalFrame (geo::Pos& origin, size_t count) {
+    std::vector <double> lat (count), lon (count), ranges (count), bearings (count), rangesExact (count), bearingsExact (count);
+    geo::LocalFrame frame, exactFrame;
+
+    for (size_t i = 0; i < count; ++ i) {
+        geo::Pos target;
+
+        geo::calcGreatCirclePos (true, & origin, 0.01 + fmod (i * 0.0113, 12.0), fmod (i * 0.013, geo::TWO_PI), & target, 0);
+
+        lat [i] = target.lat;
+        lon [i] = target.lon;
+    }
+
+    // Zero error limit makes every point go to the exact inverse problem
+    geo::initLocalFrame (0, & origin, 1.0 * geo::NM_IN_METER, & frame);
+    geo::initLocalFrame (0, & origin, 0.0, & exactFrame);
+
+    size_t exactCount;
+    auto start = std::chrono::steady_clock::now ();
+
+    geo::calcLocalDistAndBrgBatch (& frame, lat.data (), lon.data (), count, ranges.data (), bearings.data (), & exactCount);
+
+    auto middle = std::chrono::steady_clock::now ();
+
+    geo::calcLocalDistAndBrgBatch (& exactFrame, lat.data (), lon.data (), count, rangesExact.data (), bearingsExact.data (), 0);
+
+    std::chrono::duration <double> local = middle - start, exact = std::chrono::steady_clock::now () - middle;
+    double worst = 0.0;
+
+    for (size_t i = 0; i < count; ++ i)
+        worst = fmax (worst, fabs (ranges [i] - rangesExact [i]) + rangesExact [i] * fabs (remainder (bearings [i] - bearingsExact [i], geo::TWO_PI)));
+
+    printf ("ENU local %8.2f Mpts/s, exact %8.2f Mpts/s, %zu exact fallbacks, worst difference %.3f m\n",
+            (double) count / local.count () * 1.0e-6, (double) count / exact.count () * 1.0e-6, exactCount, worst * geo::METERS_IN_NM);
+}
+
+// Own ship updater against the exact inverse problem every tick: own ship at 20 knots and targets up to 24 nm at up
+// to 30 knots, one tick a second for five minutes
+void benchmarkTargetUpdater (geo::Pos& origin, size_t targetCount) {
+    const size_t tickCount = 300;
+    std::vector <geo::TargetGeodesic> states (targetCount);
+    std::vector <geo::Pos> starts (targetCount);
+    std::vector <double> lat (targetCount), lon (targetCount), ranges (targetCount), bearings (targetCount), rangesExact (targetCount), bearingsExact (targetCount);
+    std::chrono::duration <double> updated (0.0), exact (0.0);
+    geo::TargetUpdater updater;
+    geo::LocalFrame exactFrame;
+    size_t exactCount = 0;
+    double worst = 0.0;
+
+    geo::initTargetUpdater (0, 1.0 * geo::NM_IN_METER, states.data (), targetCount, & updater);
+
+    for (size_t i = 0; i < targetCount; ++ i) geo::calcGreatCirclePos (true, & origin, 0.1 + fmod (i * 0.37, 24.0), fmod (i * 0.013, geo::TWO_PI), & starts [i], 0);
+
+    for (size_t tick = 0; tick < tickCount; ++ tick) {
+        auto hours = (double) tick / 3600.0;
+        geo::Pos ownShip;
+
+        geo::calcGreatCirclePos (true, & origin, 20.0 * hours, 0.7, & ownShip, 0);
+
+        for (size_t i = 0; i < targetCount; ++ i) {
+            geo::Pos target;
+
+            geo::calcGreatCirclePos (true, & starts [i], fmod (i * 0.7, 30.0) * hours, fmod (i * 0.029, geo::TWO_PI), & target, 0);
+
+            lat [i] = target.lat;
+            lon [i] = target.lon;
+        }
+
+        auto start = std::chrono::steady_clock::now ();
+
+        geo::updateTargets (& updater, & ownShip, lat.data (), lon.data (), targetCount, ranges.data (), bearings.data ());
+
+        auto middle = std::chrono::steady_clock::now ();
+
+        geo::initLocalFrame (0, & ownShip, 0.0, & exactFrame);
+        geo::calcLocalDistAndBrgBatch (& exactFrame, lat.data (), lon.data (), targetCount, rangesExact.data (), bearingsExact.data (), 0);
+
+        updated += middle - start;
+        exact += std::chrono::steady_clock::now () - middle;
+        exactCount += updater.exactCount;
+
+        for (size_t i = 0; i < targetCount; ++ i)
+            worst = fmax (worst, fabs (ranges [i] - rangesExact [i]) + rangesExact [i] * fabs (remainder (bearings [i] - bearingsExact [i], geo::TWO_PI)));
+    }
+
+    auto pointCount = (double) (targetCount * tickCount);
+
+    printf ("Targets updater %8.1f ns/target, exact %8.1f ns/target, %.2f%% solved exactly, worst difference %.3f m\n",
+            updated.count () / pointCount * 1.0e9, exact.count () / pointCount * 1.0e9, (double) exactCount / pointCount * 100.0, worst * geo::METERS_IN_NM);
+}
+
+// Warm started inverse problem against the cold one on a pair of tracks sampled at the same times; recorded tracks
+// (track files) if given, own ship at 15 knots and a target at 22 knots sampled every second for a day otherwise
+void benchmarkWarmSolver (geo::Pos& origin, const char *ownTrackPath, const char *targetTrackPath) {
+    geo::TrackFile ownTrack, targetTrack;
+    std::vector <double> ownLat, ownLon, lat, lon;
+    size_t count;
+
+    if (ownTrackPath && targetTrackPath) {
+        if (!geo::openTrackFile (ownTrackPath, & ownTrack)) die ("Unable to open own ship track");
+        if (!geo::openTrackFile (targetTrackPath, & targetTrack)) die ("Unable to open target track");
+
+        count = ownTrack.pointCount < targetTrack.pointCount ? ownTrack.pointCount : targetTrack.pointCount;
+
+        ownLat.assign (ownTrack.lat, ownTrack.lat + count);
+        ownLon.assign (ownTrack.lon, ownTrack.lon + count);
+        lat.assign (targetTrack.lat, targetTrack.lat + count);
+        lon.assign (targetTrack.lon, targetTrack.lon + count);
+
+        geo::closeTrackFile (& ownTrack);
+        geo::closeTrackFile (& targetTrack);
+    } else {
+        count = 86400;
+
+        ownLat.resize (count);
+        ownLon.resize (count);
+        lat.resize (count);
+        lon.resize (count);
+
+        geo::Pos targetOrigin { origin.lat + 0.003, origin.lon + 0.004 };
+
+        for (size_t i = 0; i < count; ++ i) {
+            geo::Pos ownShip, target;
+
+            geo::calcRhumblinePos (true, & origin, 15.0 * i / 3600.0, 0.7, & ownShip);
+            geo::calcRhumblinePos (true, & targetOrigin, 22.0 * i / 3600.0, 0.75, & target);
+
+            ownLat [i] = ownShip.lat;
+            ownLon [i] = ownShip.lon;
+            lat [i] = target.lat;
+            lon [i] = target.lon;
+        }
+    }
+
+    std::vector <double> ranges (count), bearings (count), rangesCold (count), bearingsCold (count);
+    geo::GcSolver warmSolver, coldSolver;
+    size_t coldIterations = 0;
+
+    geo::initGcSolver (0, & warmSolver);
+
+    auto start = std::chrono::steady_clock::now ();
+
+    for (size_t i = 0; i < count; ++ i) {
+        geo::Pos ownShip { ownLat [i], ownLon [i] }, target { lat [i], lon [i] };
+
+        geo::solveGcInverse (& warmSolver, & ownShip, & target, & ranges [i], & bearings [i], 0);
+    }
+
+    auto middle = std::chrono::steady_clock::now ();
+
+    for (size_t i = 0; i < count; ++ i) {
+        geo::Pos ownShip { ownLat [i], ownLon [i] }, target { lat [i], lon [i] };
+
+        geo::initGcSolver (0, & coldSolver);
+        geo::solveGcInverse (& coldSolver, & ownShip, & target, & rangesCold [i], & bearingsCold [i], 0);
+
+        coldIterations += coldSolver.iterations;
+    }
+
+    std::chrono::duration <double> warm = middle - start, cold = std::chrono::steady_clock::now () - middle;
+    double worst = 0.0;
+
+    for (size_t i = 0; i < count; ++ i)
+        worst = fmax (worst, fabs (ranges [i] - rangesCold [i]) + rangesCold [i] * fabs (remainder (bearings [i] - bearingsCold [i], geo::TWO_PI)));
+
+    printf ("GC inverse warm %8.1f ns, %.2f iterations; cold %8.1f ns, %.2f iterations; worst difference %.4f m\n",
+            warm.count () / count * 1.0e9, (double) warmSolver.iterations / count, cold.count () / count * 1.0e9, (double) coldIterations / count,
+            worst * geo::METERS_IN_NM);
+}
+
+// Worst case latency of the inverse problem for the points around the antipode of the origin, unbounded iteration
+// against the iteration cap with the bisection past it
+void benchmarkGcLatency (geo::Pos& origin, size_t count) {
+    std::vector <geo::Pos> points (count);
+
+    for (size_t i = 0; i < count; ++ i) {
+        points [i].lat = - origin.lat + (0.3 * rand () / RAND_MAX - 0.15);
+        points [i].lon = origin.lon + geo::PI - 0.2 * rand () / RAND_MAX;
+    }
+
+    for (auto maxIterations : { 0, 20 }) {
+        geo::GcSolver solver;
+        double worst = 0.0, total = 0.0;
+        int maxSteps = 0;
+
+        geo::initGcSolver (0, & solver);
+
+        solver.maxIterations = maxIterations;
+
+        for (size_t i = 0; i < count; ++ i) {
+            auto iterations = solver.iterations;
+            auto start = std::chrono::steady_clock::now ();
+
+            solver.auxLonScale = 1.0;
+
+            geo::solveGcInverse (& solver, & origin, & points [i], 0, 0, 0);
+
+            std::chrono::duration <double> elapsed = std::chrono::steady_clock::now () - start;
+
+            worst = fmax (worst, elapsed.count ());
+            total += elapsed.count ();
+            auto steps = (int) (solver.iterations - iterations);
+
+            if (steps > maxSteps) maxSteps = steps;
+        }
+
+        printf ("GC inverse nearly antipodal, cap %2d: %8.1f ns average, %8.1f ns worst, %d steps worst, %zu bisections\n",
+                maxIterations, total / count * 1.0e9, worst * 1.0e9, maxSteps, solver.bisections);
+    }
+}
+
+// Cached legs against the uncached calls for a route planner pattern: a few hundred waypoint pairs queried over and
+// over with the positions jittered below the quantum
+void benchmarkLegCache (geo::Pos& origin, size_t count) {
+    const size_t legCount = 300;
+    const double quantum = 1.0e-7;
+    std::vector <geo::Pos> begins (count), ends (count);
+    geo::LegCache cache;
+    geo::LegCacheStats stats;
+
+    for (size_t i = 0; i < count; ++ i) {
+        auto leg = (size_t) rand () % legCount;
+
+        begins [i] = { origin.lat + leg * 1.0e-3 + 0.2 * quantum * rand () / RAND_MAX, origin.lon + leg * 2.0e-3 };
+        ends [i] = { origin.lat - leg * 2.0e-3, origin.lon + 0.5 + leg * 1.0e-3 + 0.2 * quantum * rand () / RAND_MAX };
+    }
+
+    if (!geo::openLegCache (1024, quantum, & cache)) die ("Unable to open leg cache");
+
+    for (auto method : { geo::Method::GREAT_CIRCLE, geo::Method::RHUMBLINE }) {
+        double range, bearing, worst = 0.0;
+        auto start = std::chrono::steady_clock::now ();
+
+        for (size_t i = 0; i < count; ++ i) geo::calcLegCached (& cache, method, true, & begins [i], & ends [i], & range, & bearing);
+
+        auto middle = std::chrono::steady_clock::now ();
+
+        for (size_t i = 0; i < count; ++ i) {
+            if (method == geo::Method::GREAT_CIRCLE)
+                geo::calcGreatCircleDistAndBrg (true, & begins [i], & ends [i], & range, & bearing, 0);
+            else
+                geo::calcRhumblineDistAndBrg (true, & begins [i], & ends [i], & range, & bearing);
+        }
+
+        std::chrono::duration <double> cached = middle - start, uncached = std::chrono::steady_clock::now () - middle;
+
+        for (size_t i = 0; i < count; i += 97) {
+            double cachedRange, cachedBearing;
+
+            geo::calcLegCached (& cache, method, true, & begins [i], & ends [i], & cachedRange, & cachedBearing);
+
+            if (method == geo::Method::GREAT_CIRCLE)
+                geo::calcGreatCircleDistAndBrg (true, & begins [i], & ends [i], & range, & bearing, 0);
+            else
+                geo::calcRhumblineDistAndBrg (true, & begins [i], & ends [i], & range, & bearing);
+
+            worst = fmax (worst, fabs (cachedRange - range));
+        }
+
+        printf ("%s leg cache %8.1f ns, uncached %8.1f ns, worst difference %.3f m\n", method == geo::Method::GREAT_CIRCLE ? "GC" : "RL",
+                cached.count () / count * 1.0e9, uncached.count () / count * 1.0e9, worst * geo::METERS_IN_NM);
+    }
+
+    geo::getLegCacheStats (& cache, & stats);
+    geo::closeLegCache (& cache);
+
+    printf ("Leg cache hit rate %.2f%%, %llu evictions, %zu of %zu entries\n", 100.0 * stats.hits / (stats.hits + stats.misses),
+            stats.evictions, stats.entries, stats.capacity);
+}
+
+// Batch C ABI over the interleaved lat/lon buffer against the per point calls
+void benchmarkAbi (geo::Pos& origin, size_t count) {
+    std::vector <double> points (count * 2), ranges (count), bearings (count);
+    double worst = 0.0;
+
+    for (size_t i = 0; i < count; ++ i) {
+        points [i * 2] = origin.lat + 0.5 * rand () / RAND_MAX - 0.25;
+        points [i * 2 + 1] = origin.lon + 0.5 * rand () / RAND_MAX - 0.25;
+    }
+
+    auto start = std::chrono::steady_clock::now ();
+    auto solved = geo_gc_dist_brg (1, count, & origin.lat, 0, & origin.lon, 0, points.data (), 16, points.data () + 1, 16, ranges.data (), 8,
+                                   bearings.data (), 8, 0, 0);
+    auto middle = std::chrono::steady_clock::now ();
+
+    for (size_t i = 0; i < count; ++ i) {
+        geo::Pos begin = origin, end { points [i * 2], points [i * 2 + 1] };
+        double range, bearing;
+
+        geo::calcGreatCircleDistAndBrg (true, & begin, & end, & range, & bearing, 0);
+
+        worst = fmax (worst, fabs (range - ranges [i]) + fabs (bearing - bearings [i]));
+    }
+
+    std::chrono::duration <double> batch = middle - start, single = std::chrono::steady_clock::now () - middle;
+
+    printf ("ABI v%d GC batch %8.2f Mpts/s, single calls %8.2f Mpts/s, %zu of %zu solved, worst difference %g\n", geo_abi_version (),
+            (double) count / batch.count () * 1.0e-6, (double) count / single.count () * 1.0e-6, solved, count, worst);
+}
+
+// Great circle inverse problem against GeographicLib (WGS84), nearly antipodal pairs first; both with and without the
+// iteration cap
+void checkGcInverse () {
+    struct {
+        double lat1, lon1, lat2, lon2, range, bearing, endBearing;
+    } cases [] = {
+        { 1.0, 0.0, -1.0, 179.9, 10800.760487, 9.547131, 170.452869 },
+        { 0.0, 0.0, 0.0, 179.5, 10788.802327, 55.966495, 124.033505 },
+        { 10.0, 20.0, -10.0, -160.02, 10801.238951, 1.929843, 178.070157 },
+        { 45.0, 0.0, -44.5, 179.2, 10760.032027, 37.707077, 142.672205 },
+        { 10.0, 10.0, 20.0, 30.0, 1304.167396, 60.423018, 65.669313 },
+    };
+
+    geo::GeoContext context;
+
+    geo::initGeoContext (& context);
+
+    context.radians = false;
+
+    for (auto maxIterations : { 0, 20 }) {
+        context.maxIterations = maxIterations;
+
+        for (auto& test : cases) {
+            geo::Pos origin { test.lat1, test.lon1 }, dest { test.lat2, test.lon2 };
+            double range, bearing, endBearing;
+            char what [128];
+
+            snprintf (what, sizeof (what), "GC inverse [%g; %g] to [%g; %g], cap %d", test.lat1, test.lon1, test.lat2, test.lon2, maxIterations);
+
+            if (!checkCondition (what, geo::calcGreatCircleDistAndBrgEx (& context, & origin, & dest, & range, & bearing, & endBearing) == geo::GEO_OK))
+                continue;
+
+            checkValue (what, "range nm", range, test.range, 1.0e-4);
+            checkValue (what, "bearing deg", bearing, test.bearing, 1.0e-5);
+            checkValue (what, "end bearing deg", endBearing, test.endBearing, 1.0e-5);
+        }
+    }
+}
+
+// Arc builders: point counts, arc ends on the begin point rotated by the angle, range ring points at the range; and
+// the rhumb line cardinal cases the arcs cross (the meridian bearing in radians, the east/west range in miles)
+void checkArcs () {
+    geo::Pos origin { 45.0 * geo::RAD_IN_DEG, 10.0 * geo::RAD_IN_DEG }, dest;
+    double range, bearing;
+
+    for (auto east : { true, false }) {
+        auto what = east ? "RL 60 nm east along 45N" : "RL 60 nm west along 45N";
+
+        if (!checkCondition (what, geo::calcRhumblinePos (true, & origin, 60.0, east ? geo::HALF_PI : geo::HALF_OF_THREE_PI, & dest))) continue;
+
+        checkValue (what, "lat deg", dest.lat * geo::DEG_IN_RAD, 45.0, 1.0e-12);
+        checkValue (what, "lon deg", dest.lon * geo::DEG_IN_RAD, east ? 11.409314652484849 : 8.590685347515151, 1.0e-9);
+    }
+
+    geo::Pos north { 10.0 * geo::RAD_IN_DEG, 20.0 * geo::RAD_IN_DEG }, south { 5.0 * geo::RAD_IN_DEG, 20.0 * geo::RAD_IN_DEG };
+    double gcRange;
+
+    // Along the meridian the great circle is the meridian arc too
+    if (checkCondition ("RL south along 20E", geo::calcRhumblineDistAndBrg (true, & north, & south, & range, & bearing) &&
+                                              geo::calcGreatCircleDistAndBrg (true, & north, & south, & gcRange, 0, 0))) {
+        checkValue ("RL south along 20E", "bearing rad", bearing, geo::PI, 1.0e-12);
+        checkValue ("RL south along 20E", "range nm", range, gcRange, 1.0e-6);
+    }
+
+    geo::Arc arcs [] = {
+        { { 45.2 * geo::RAD_IN_DEG, 10.0 * geo::RAD_IN_DEG }, origin, 90.0 * geo::RAD_IN_DEG },
+        { { 44.9 * geo::RAD_IN_DEG, 10.3 * geo::RAD_IN_DEG }, origin, -200.0 * geo::RAD_IN_DEG },
+        { { -30.0 * geo::RAD_IN_DEG, 179.5 * geo::RAD_IN_DEG }, { -30.5 * geo::RAD_IN_DEG, -179.8 * geo::RAD_IN_DEG }, geo::TWO_PI },
+        { { 0.1 * geo::RAD_IN_DEG, 0.0 }, { 0.0, 0.0 }, 0.01 * geo::RAD_IN_DEG },
+    };
+    static const size_t ARC_COUNT = sizeof (arcs) / sizeof (*arcs);
+    static const double ANGLE_STEP = 7.0 * geo::RAD_IN_DEG;
+    double lat [256], lon [256];
+    geo::PosBatch points { lat, lon, 256, 0 };
+    size_t firstPoints [ARC_COUNT];
+
+    for (auto method : { geo::GREAT_CIRCLE, geo::RHUMBLINE }) {
+        for (auto includeEndPoint : { true, false }) {
+            char what [128];
+
+            snprintf (what, sizeof (what), "%s arcs%s", method == geo::GREAT_CIRCLE ? "GC" : "RL", includeEndPoint ? " with the end point" : "");
+
+            if (!checkCondition (what, geo::buildGeoArcs (true, method, arcs, ARC_COUNT, ANGLE_STEP, includeEndPoint, & points, firstPoints))) continue;
+
+            size_t total = 0;
+            double worstRange = 0.0, worstBearing = 0.0;
+
+            for (size_t i = 0; i < ARC_COUNT; ++ i) {
+                auto count = geo::calcArcPointCount (arcs [i].angle, ANGLE_STEP, includeEndPoint);
+                auto steps = includeEndPoint ? count - 1 : count;
+                double begRange, begBearing;
+
+                checkCondition (what, firstPoints [i] == total);
+
+                if (method == geo::GREAT_CIRCLE)
+                    geo::calcGreatCircleDistAndBrg (true, & arcs [i].center, & arcs [i].begin, & begRange, & begBearing, 0);
+                else
+                    geo::calcRhumblineDistAndBrg (true, & arcs [i].center, & arcs [i].begin, & begRange, & begBearing);
+
+                // Every point (the last one is the end point if included) is at the begin range and the rotated bearing
+                for (size_t j = 0; j < count; ++ j) {
+                    geo::Pos point { lat [total + j], lon [total + j] };
+                    auto expectedBearing = begBearing + arcs [i].angle * (double) j / (double) steps;
+
+                    if (method == geo::GREAT_CIRCLE)
+                        geo::calcGreatCircleDistAndBrg (true, & arcs [i].center, & point, & range, & bearing, 0);
+                    else
+                        geo::calcRhumblineDistAndBrg (true, & arcs [i].center, & point, & range, & bearing);
+
+                    auto bearingDiff = fmod (fabs (bearing - expectedBearing), geo::TWO_PI);
+
+                    worstRange = fmax (worstRange, fabs (range - begRange));
+                    worstBearing = fmax (worstBearing, fmin (bearingDiff, geo::TWO_PI - bearingDiff));
+                }
+
+                total += count;
+            }
+
+            checkValue (what, "point count", (double) points.count, (double) total, 0.0);
+            checkValue (what, "range error nm", worstRange, 0.0, 1.0e-6);
+            checkValue (what, "bearing error rad", worstBearing, 0.0, 1.0e-7);
+        }
+    }
+
+    geo::Pos centers [] = { origin, { -60.0 * geo::RAD_IN_DEG, 179.9 * geo::RAD_IN_DEG }, { 75.0 * geo::RAD_IN_DEG, 0.0 } };
+    auto ringCount = geo::calcArcPointCount (geo::TWO_PI, ANGLE_STEP, true);
+
+    if (checkCondition ("Range rings", geo::buildRangeRings (true, centers, 3, 25.0, ANGLE_STEP, & points) && points.count == ringCount * 3)) {
+        double worstRange = 0.0;
+
+        for (size_t i = 0; i < points.count; ++ i) {
+            geo::Pos point { lat [i], lon [i] };
+
+            geo::calcGreatCircleDistAndBrg (true, centers + i / ringCount, & point, & range, 0, 0);
+
+            worstRange = fmax (worstRange, fabs (range - 25.0));
+        }
+
+        checkValue ("Range rings", "range error nm", worstRange, 0.0, 1.0e-6);
+        checkCondition ("Range rings closed", lat [ringCount - 1] == lat [0] && lon [ringCount - 1] == lon [0]);
+    }
+}
+
+// Route corridor: the size calculation agrees with the build, contours are clockwise, the offset lines are at the
+// XTE limits of their legs and the caps at the limits around the waypoints, a buffer short of the size is refused
+void checkCorridor () {
+    static const double STEP_DISTANCE = 2.0, ANGLE_STEP = 10.0 * geo::RAD_IN_DEG;
+    geo::Pos route [] = {
+        { 50.0 * geo::RAD_IN_DEG, -5.0 * geo::RAD_IN_DEG }, { 50.2 * geo::RAD_IN_DEG, -4.8 * geo::RAD_IN_DEG }, { 50.2 * geo::RAD_IN_DEG, -4.8 * geo::RAD_IN_DEG },
+        { 50.1 * geo::RAD_IN_DEG, -4.3 * geo::RAD_IN_DEG }, { 49.8 * geo::RAD_IN_DEG, -4.4 * geo::RAD_IN_DEG },
+    };
+    static const size_t POINT_COUNT = sizeof (route) / sizeof (*route);
+    double portXte [] = { 0.5, 1.0, 0.8, 1.2 }, stbdXte [] = { 0.5, 1.0, 0.3, 2.0 };
+    auto quarterPoints = geo::calcArcPointCount (geo::HALF_PI, ANGLE_STEP, true);
+
+    for (auto method : { geo::GREAT_CIRCLE, geo::RHUMBLINE }) {
+        auto what = method == geo::GREAT_CIRCLE ? "GC corridor" : "RL corridor";
+        size_t contourCount, vertexCount;
+
+        if (!checkCondition (what, geo::calcRouteCorridorSize (true, method, route, POINT_COUNT, portXte, stbdXte, STEP_DISTANCE, ANGLE_STEP,
+                                                               & contourCount, & vertexCount))) continue;
+
+        // The collapsed leg has no contour
+        checkValue (what, "contour count", (double) contourCount, 3.0, 0.0);
+
+        std::vector <int> contourSizes (contourCount);
+        std::vector <geo::Pos> vertexes (vertexCount);
+        geo::RegionBuffer corridor { 0, 0, contourSizes.data (), vertexes.data (), contourCount, vertexCount - 1 };
+
+        checkCondition (what, !geo::buildRouteCorridor (true, method, route, POINT_COUNT, portXte, stbdXte, STEP_DISTANCE, ANGLE_STEP, & corridor) &&
+                              corridor.extContourCount == 0);
+
+        corridor.contourCapacity = contourCount - 1;
+        corridor.vertexCapacity = vertexCount;
+
+        checkCondition (what, !geo::buildRouteCorridor (true, method, route, POINT_COUNT, portXte, stbdXte, STEP_DISTANCE, ANGLE_STEP, & corridor) &&
+                              corridor.extContourCount == 0);
+
+        corridor.contourCapacity = contourCount;
+
+        if (!checkCondition (what, geo::buildRouteCorridor (true, method, route, POINT_COUNT, portXte, stbdXte, STEP_DISTANCE, ANGLE_STEP, & corridor) &&
+                                   corridor.extContourCount == (int) contourCount && corridor.intContourCount == 0)) continue;
+
+        size_t first = 0, leg = 0;
+        double worstOffset = 0.0, worstCap = 0.0;
+        int counterClockwise = 0;
+
+        for (size_t contour = 0; contour < contourCount; ++ contour, ++ leg) {
+            // Legs are skipped the way the build does it
+            while (route [leg].lat == route [leg + 1].lat && route [leg].lon == route [leg + 1].lon) ++ leg;
+
+            auto capCount = (quarterPoints - 1) + (quarterPoints - 2) + (portXte [leg] == stbdXte [leg] ? 0 : 1);
+            auto sampleCount = ((size_t) contourSizes [contour] - capCount * 2) / 2;
+            auto points = vertexes.data () + first;
+            geo::Pos begin = route [leg], end = route [leg + 1];
+            double range, bearing, area = 0.0;
+
+            if (method == geo::GREAT_CIRCLE)
+                geo::calcGreatCircleDistAndBrg (true, & begin, & end, & range, & bearing, 0);
+            else
+                geo::calcRhumblineDistAndBrg (true, & begin, & end, & range, & bearing);
+
+            // Offset points against the samples along the leg, port forward then starboard backward
+            for (size_t i = 0; i < sampleCount; ++ i) {
+                auto sampleRange = range * (double) i / (double) (sampleCount - 1);
+                geo::Pos sample, port = points [i], stbd = points [sampleCount + capCount + sampleCount - 1 - i];
+                double portRange, stbdRange;
+
+                if (method == geo::GREAT_CIRCLE)
+                    geo::calcGreatCirclePos (true, & begin, sampleRange, bearing, & sample, 0);
+                else
+                    geo::calcRhumblinePos (true, & begin, sampleRange, bearing, & sample);
+
+                geo::calcGreatCircleDistAndBrg (true, & sample, & port, & portRange, 0, 0);
+                geo::calcGreatCircleDistAndBrg (true, & sample, & stbd, & stbdRange, 0, 0);
+
+                worstOffset = fmax (worstOffset, fmax (fabs (portRange - portXte [leg]), fabs (stbdRange - stbdXte [leg])));
+            }
+
+            // Caps at the limits around the waypoints (the point over the track extension is at the larger one)
+            for (size_t i = 0; i < capCount; ++ i) {
+                geo::Pos endCap = points [sampleCount + i], begCap = points [sampleCount * 2 + capCount + i];
+                double endRange, begRange;
+
+                geo::calcGreatCircleDistAndBrg (true, & end, & endCap, & endRange, 0, 0);
+                geo::calcGreatCircleDistAndBrg (true, & begin, & begCap, & begRange, 0, 0);
+
+                worstCap = fmax (worstCap, fmin (fabs (endRange - portXte [leg]), fabs (endRange - stbdXte [leg])));
+                worstCap = fmax (worstCap, fmin (fabs (begRange - portXte [leg]), fabs (begRange - stbdXte [leg])));
+            }
+
+            // Shoelace area in the local east/north plane is negative for a clockwise contour
+            for (size_t i = 0; i < (size_t) contourSizes [contour]; ++ i) {
+                auto& next = points [(i + 1) % contourSizes [contour]];
+
+                area += (points [i].lon - begin.lon) * cos (begin.lat) * (next.lat - begin.lat) - (next.lon - begin.lon) * cos (begin.lat) * (points [i].lat - begin.lat);
+            }
+
+            if (area >= 0.0) ++ counterClockwise;
+
+            first += contourSizes [contour];
+        }
+
+        checkValue (what, "vertex count", (double) first, (double) vertexCount, 0.0);
+        checkValue (what, "counter-clockwise contours", counterClockwise, 0.0, 0.0);
+        checkValue (what, "offset error nm", worstOffset, 0.0, 1.0e-6);
+        checkValue (what, "cap range error nm", worstCap, 0.0, 1.0e-6);
+    }
+}
+
+// Context settings reaching the kernels: the split rhumb line step, the great circle iteration precision and the
+// ellipsoid refused by the corridors
+void checkContext () {
+    geo::GeoContext context;
+    geo::Pos origin { 10.0, 20.0 }, dest { 30.0, 35.0 };
+    double range, bearing, splitRange, splitBearing, endBearing;
+
+    geo::initGeoContext (& context);
+
+    context.radians = false;
+
+    // Line split after the first step is the rhumb line itself, the one shorter than the step is the mean latitude estimate
+    if (checkCondition ("RL split, default step", geo::calcRhumblineDistAndBrgEx (& context, & origin, & dest, & range, & bearing) == geo::GEO_OK &&
+                        geo::calcRhumblineDistAndBrg2Ex (& context, & origin, & dest, & splitRange, & splitBearing) == geo::GEO_OK)) {
+        checkValue ("RL split, default step", "range nm", splitRange, range, 1.0e-6);
+        checkValue ("RL split, default step", "bearing deg", splitBearing, bearing, 1.0e-9);
+    }
+
+    context.stepDistance = 5000.0;
+
+    if (checkCondition ("RL split, step past the end",
+                        geo::calcRhumblineDistAndBrg2Ex (& context, & origin, & dest, & splitRange, & splitBearing) == geo::GEO_OK))
+        checkValue ("RL split, step past the end", "range nm", splitRange, 1471.885366, 1.0e-6);
+
+    context.stepDistance = 0.0;
+
+    checkCondition ("RL split, zero step refused",
+                    geo::calcRhumblineDistAndBrg2Ex (& context, & origin, & dest, & splitRange, & splitBearing) == geo::GEO_INVALID_ARGUMENT);
+
+    geo::initGeoContext (& context);
+
+    context.radians = false;
+    context.precision = 1.0e-3;
+
+    if (checkCondition ("GC inverse, coarse precision",
+                        geo::calcGreatCircleDistAndBrgEx (& context, & origin, & dest, & range, & bearing, & endBearing) == geo::GEO_OK)) {
+        double preciseRange;
+
+        context.precision = geo::DEFPRECISION;
+
+        geo::calcGreatCircleDistAndBrgEx (& context, & origin, & dest, & preciseRange, & bearing, & endBearing);
+        checkCondition ("GC inverse, coarse precision stops the iteration earlier",
+                        fabs (range - preciseRange) > 1.0e-4 && fabs (range - preciseRange) < 1.0e-3 * geo::MILES_IN_RAD);
+    }
+
+    context.precision = 0.0;
+
+    checkCondition ("GC inverse, zero precision refused",
+                    geo::calcGreatCircleDistAndBrgEx (& context, & origin, & dest, & range, & bearing, & endBearing) == geo::GEO_INVALID_ARGUMENT);
+
+    geo::initGeoContext (& context);
+
+    geo::Pos route [] = { { 0.1, 0.2 }, { 0.11, 0.21 } };
+    double xte [] = { 1.0, 1.0 };
+    size_t contourCount, vertexCount;
+
+    context.ellipsoid.equRadius = 6378135.0;
+    context.ellipsoid.flattening = 1.0 / 298.26;
+
+    checkCondition ("Corridor, WGS72 context refused", geo::calcRouteCorridorSizeEx (& context, geo::GREAT_CIRCLE, route, 2, xte, xte, 0.1, & contourCount,
+                                                                                      & vertexCount) == geo::GEO_INVALID_ARGUMENT);
+}
+
+// Writes the bytes over the file at the offset given
+bool patchFile (const char *path, size_t offset, const void *data, size_t size) {
+    auto file = fopen (path, "r+b");
+
+    if (!file) return false;
+
+    auto result = fseek (file, (long) offset, SEEK_SET) == 0 && fwrite (data, 1, size, file) == size;
+
+    fclose (file);
+
+    return result;
+}
+
+// Grid shift file: lookups, the broken headers refused and the backward conversion leaving the grid
+void checkGridShift () {
+    static const char *PATH = "geotest.grid";
+    static const double STEP = geo::RAD_IN_DEG;
+    float latShifts [12], lonShifts [12];
+
+    // 3 x 4 nodes a degree apart; the longitude shift is a degree eastwards, the latitude one grows by the column
+    for (size_t i = 0; i < 12; ++ i) {
+        latShifts [i] = (float) (i % 4) * 10.0f;
+        lonShifts [i] = 3600.0f;
+    }
+
+    if (!checkCondition ("Grid shift written", geo::writeGridShift (PATH, 0.0, 0.0, STEP, STEP, 3, 4, latShifts, lonShifts, 2))) return;
+
+    geo::GridShift grid;
+
+    if (checkCondition ("Grid shift opened", geo::openGridShift (PATH, & grid))) {
+        double lat [] = { 1.0 * STEP, 1.5 * STEP }, lon [] = { 2.5 * STEP, 0.5 * STEP }, deltaLat [2], deltaLon [2];
+
+        checkCondition ("Grid shift lookup", geo::calcGridShifts (& grid, lat, lon, 2, deltaLat, deltaLon));
+        checkValue ("Grid shift lookup", "lat shift arc seconds", deltaLat [0] * geo::DEG_IN_RAD * 3600.0, 25.0, 1.0e-9);
+        checkValue ("Grid shift lookup", "lon shift arc seconds", deltaLon [1] * geo::DEG_IN_RAD * 3600.0, 3600.0, 1.0e-9);
+
+        // Backward position of the second point is west of the grid; it is kept and reported
+        geo::PosBatch points { lat, lon, 2, 2 };
+
+        checkCondition ("Grid shift backward leaving the grid", !geo::convertGridShift (& grid, false, & points));
+        checkValue ("Grid shift backward", "lon deg", lon [0] * geo::DEG_IN_RAD, 1.5, 1.0e-9);
+        checkValue ("Grid shift backward leaving the grid", "lon deg", lon [1] * geo::DEG_IN_RAD, 0.5, 0.0);
+
+        geo::closeGridShift (& grid);
+    }
+
+    // Header fields are uint32 rows, cols, tileSize, tileRows, tileCols from offset 8 and double south, west, latStep,
+    // lonStep from offset 32
+    struct {
+        const char *what;
+        size_t offset;
+        unsigned int count;
+        double step;
+    } cases [] = {
+        { "rows not matching the tile rows", 8, 5, 0.0 },
+        { "single row", 8, 1, 0.0 },
+        { "single column", 12, 1, 0.0 },
+        { "tile columns not matching the columns", 24, 3, 0.0 },
+        { "huge tile size", 16, 0xFFFFFFFF, 0.0 },
+        { "zero latitude step", 48, 0, 0.0 },
+        { "negative longitude step", 56, 0, - STEP },
+    };
+
+    for (auto& test : cases) {
+        char what [128];
+
+        snprintf (what, sizeof (what), "Grid shift refused, %s", test.what);
+
+        geo::writeGridShift (PATH, 0.0, 0.0, STEP, STEP, 3, 4, latShifts, lonShifts, 2);
+
+        if (test.offset < 32)
+            patchFile (PATH, test.offset, & test.count, sizeof (test.count));
+        else
+            patchFile (PATH, test.offset, & test.step, sizeof (test.step));
+
+        if (!checkCondition (what, !geo::openGridShift (PATH, & grid))) geo::closeGridShift (& grid);
+    }
+
+    remove (PATH);
+}
+
+// Region list round trip (write, open, find, point in region) and the records pointing out of the file refused
+// Track file: the round trip, then broken layouts and block headers refused
+void checkTrackFile () {
+    static const char *PATH = "geotest.track";
+    double lat [10], lon [10], time [10];
+
+    for (size_t i = 0; i < 10; ++ i) {
+        lat [i] = 0.01 * i;
+        lon [i] = -0.02 * i;
+        time [i] = 60.0 * i;
+    }
+
+    // Blocks of 0..3, 4..7 and 8..9
+    if (!checkCondition ("Track file written", geo::writeTrackFile (PATH, lat, lon, time, 10, 4))) return;
+
+    geo::TrackFile track;
+    size_t blocks [4];
+
+    if (!checkCondition ("Track file opened", geo::openTrackFile (PATH, & track) && track.pointCount == 10 && track.blockCount == 3)) return;
+
+    checkCondition ("Track file, columns", track.lat [9] == lat [9] && track.lon [5] == lon [5] && track.time [0] == 0.0);
+    checkCondition ("Track file, last block", track.blocks [2].first == 8 && track.blocks [2].count == 2 && track.blocks [2].endTime == 540.0);
+    checkCondition ("Track file, blocks in the box", geo::findTrackBlocks (& track, 0.035, 0.045, -1.0, 1.0, 0.0, 1000.0, blocks, 4) == 1 &&
+                                                     blocks [0] == 1);
+
+    geo::closeTrackFile (& track);
+
+    // Header is 8 bytes of the signature and then pointCount, blockCount, blockSize, blocksOffset, latOffset, lonOffset,
+    // timeOffset (uint64); block headers of 64 bytes from 64 have first and count (uint64) at 48
+    struct {
+        const char *what;
+        size_t offset;
+        unsigned long long value;
+    } cases [] = {
+        { "point count past the file", 8, 1ull << 40 },
+        { "zero block size", 24, 0 },
+        { "empty block", 64 + 56, 0 },
+        { "block out of order", 64 + 64 + 48, 5 },
+        { "block larger than the block size", 64 + 56, 5 },
+        { "block past the points", 64 + 128 + 56, 3 },
+    };
+
+    for (auto& test : cases) {
+        char what [128];
+
+        snprintf (what, sizeof (what), "Track file refused, %s", test.what);
+
+        geo::writeTrackFile (PATH, lat, lon, time, 10, 4);
+
+        // Values are little endian
+        patchFile (PATH, test.offset, & test.value, sizeof (test.value));
+
+        if (!checkCondition (what, !geo::openTrackFile (PATH, & track))) geo::closeTrackFile (& track);
+    }
+
+    // 2^61 points in a block of 2^61: column offsets and the end of the time column all wrap to 128
+    unsigned long long wrapped [] = { 1ull << 61, 1, 1ull << 61, 64, 128, 128, 128 };
+
+    geo::writeTrackFile (PATH, lat, lon, time, 10, 4);
+    patchFile (PATH, 8, wrapped, sizeof (wrapped));
+
+    if (!checkCondition ("Track file refused, layout wrapping", !geo::openTrackFile (PATH, & track))) geo::closeTrackFile (& track);
+
+    remove (PATH);
+}
+
+void checkRegionList () {
+    static const char *PATH = "geotest.regions";
+
+    // Square with a hole, triangle and a square south-east; radians
+    geo::Pos vertexes [] = {
+        { 0.10, 0.10 }, { 0.20, 0.10 }, { 0.20, 0.20 }, { 0.10, 0.20 },
+        { 0.14, 0.14 }, { 0.16, 0.14 }, { 0.16, 0.16 }, { 0.14, 0.16 },
+        { 0.40, 0.40 }, { 0.60, 0.45 }, { 0.45, 0.60 },
+        { -0.30, 0.30 }, { -0.20, 0.30 }, { -0.20, 0.40 }, { -0.30, 0.40 },
+    };
+    int contourSizes [] = { 4, 4, 3, 4 };
+    geo::RegionBuffer regions [] = {
+        { 1, 1, contourSizes, vertexes, 2, 8 },
+        { 1, 0, contourSizes + 2, vertexes + 8, 1, 3 },
+        { 1, 0, contourSizes + 3, vertexes + 11, 1, 4 },
+    };
+
+    if (!checkCondition ("Region list written", geo::writeRegionList (PATH, regions, 3))) return;
+
+    geo::RegionList list;
+
+    if (!checkCondition ("Region list opened", geo::openRegionList (PATH, & list) && list.regionCount == 3 && list.contourCount == 4 &&
+                                               list.vertexCount == 15)) return;
+
+    size_t found [4];
+    geo::Pos inside { 0.12, 0.12 }, hole { 0.15, 0.15 }, triangle { 0.48, 0.48 }, outside { 0.5, 0.5 };
+
+    checkCondition ("Region list, box in the hole", geo::findRegions (& list, 0.15, 0.15, 0.15, 0.15, found, 4) == 1 && found [0] == 0);
+    checkCondition ("Region list, box over all", geo::findRegions (& list, -1.0, 1.0, -1.0, 1.0, found, 4) == 3 &&
+                                                 found [0] + found [1] + found [2] == 3 && found [0] != found [1]);
+    checkCondition ("Region list, point inside", geo::isPointInRegion (& list, 0, & inside));
+    checkCondition ("Region list, point in the hole", !geo::isPointInRegion (& list, 0, & hole));
+    checkCondition ("Region list, point in the triangle", geo::isPointInRegion (& list, 1, & triangle));
+    checkCondition ("Region list, point outside", !geo::isPointInRegion (& list, 2, & outside));
+
+    // Offsets of the parts of the file are taken from the list
+    auto data = (const char *) list.file.data;
+
+    auto regionsOffset = (size_t) ((const char *) list.regions - data), contoursOffset = (size_t) ((const char *) list.contours - data);
+    auto cellStartsOffset = (size_t) ((const char *) list.cellStarts - data), cellItemsOffset = (size_t) ((const char *) list.cellItems - data);
+    auto itemCount = list.cellStarts [list.cellRows * list.cellCols];
+
+    geo::closeRegionList (& list);
+
+    // Region record: firstContour, extContourCount, intContourCount (uint32) at 32; contour record: firstVertex,
+    // vertexCount (uint64) at 32
+    struct {
+        const char *what;
+        size_t offset;
+        unsigned long long value;
+        size_t size;
+    } cases [] = {
+        { "region count past the file", 8, 1ull << 40, 8 },
+        { "contours past the end", regionsOffset + 2 * sizeof (geo::RegionRecord) + 32, 4, 4 },
+        { "internal contour count wrapping", regionsOffset + 40, 0xFFFFFFFF, 4 },
+        { "no external contour", regionsOffset + sizeof (geo::RegionRecord) + 36, 0, 4 },
+        { "vertexes past the end", contoursOffset + 3 * sizeof (geo::ContourRecord) + 32, 13, 8 },
+        { "vertex count wrapping", contoursOffset + 40, ~0ull, 8 },
+        { "two vertexes", contoursOffset + sizeof (geo::ContourRecord) + 40, 2, 8 },
+        { "cell starts decreasing", cellStartsOffset + 4, itemCount + 1, 4 },
+        { "cell item past the regions", cellItemsOffset, 3, 4 },
+    };
+
+    for (auto& test : cases) {
+        char what [128];
+
+        snprintf (what, sizeof (what), "Region list refused, %s", test.what);
+
+        geo::writeRegionList (PATH, regions, 3);
+
+        // Values are little endian
+        patchFile (PATH, test.offset, & test.value, test.size);
+
+        if (!checkCondition (what, !geo::openRegionList (PATH, & list))) geo::closeRegionList (& list);
+    }
+
+    remove (PATH);
+}
+
+// Latency histogram of the Prometheus exposition: the same cumulative series whatever the clock rate and the buckets
+// filled (the counters are set by hand, so these checks run with the counters compiled out as well)
+void checkStatsExposition () {
+    static const char PREFIX [] = "geo_kernel_latency_seconds_bucket{kernel=\"gc_inverse\",le=\"";
+    static geo::GeoStats stats;
+    std::vector <char> text (1 << 16);
+    std::vector <unsigned long long> counts;
+    char emptyLabels [512], labels [512];
+
+    // Labels of the series are joined by the closing quotes
+    auto readHistogram = [&] (double ticksPerSecond, char *labels, size_t size) {
+        stats.ticksPerSecond = ticksPerSecond;
+        labels [0] = '\0';
+
+        counts.clear ();
+
+        if (!geo::formatGeoStats (& stats, true, text.data (), text.size ())) return false;
+
+        for (auto line = strstr (text.data (), PREFIX); line; line = strstr (line + 1, PREFIX)) {
+            auto label = line + sizeof (PREFIX) - 1;
+            auto end = strchr (label, '"');
+
+            if (!end || strlen (labels) + (end - label) + 2 > size) return false;
+
+            strncat (labels, label, end - label + 1);
+            counts.push_back (strtoull (end + 2, 0, 10));
+        }
+
+        return true;
+    };
+
+    memset (& stats, 0, sizeof (stats));
+
+    checkCondition ("Stats histogram without calls", readHistogram (2.0e9, emptyLabels, sizeof (emptyLabels)) && counts.size () == 17 &&
+                                                     strstr (emptyLabels, "+Inf\"") != 0);
+
+    // 3 calls of 14 ticks at most, 2 calls of 81920 ticks at most (41 us at 2 GHz, 27 us at 3 GHz) and one longer call
+    auto latency = stats.kernels [geo::GEO_KERNEL_GC_INVERSE].latency;
+
+    latency [10] = 3;
+    latency [60] = 2;
+    latency [geo::LATENCY_BUCKETS - 1] = 1;
+
+    for (auto ticksPerSecond : { 2.0e9, 3.0e9 }) {
+        char what [128];
+
+        snprintf (what, sizeof (what), "Stats histogram at %.0f GHz", ticksPerSecond * 1.0e-9);
+
+        if (!checkCondition (what, readHistogram (ticksPerSecond, labels, sizeof (labels)) && counts.size () == 17 && strcmp (labels, emptyLabels) == 0))
+            continue;
+
+        bool cumulative = true;
+
+        for (size_t i = 1; i < counts.size (); ++ i) cumulative = cumulative && counts [i] >= counts [i - 1];
+
+        checkCondition (what, cumulative && counts [0] == 3 && counts [9] == 3 && counts [10] == 5 && counts [15] == 5 && counts [16] == 6);
+    }
+}
+
+// Feeds the text to a new parser in pieces of the size given (the whole text if zero); returns the number of fixes
+size_t parseNmeaText (const char *text, size_t pieceSize, geo::NmeaParser *parser, geo::PosBatch *fixes, double *times) {
+    auto size = strlen (text);
+
+    geo::initNmeaParser (parser);
+
+    for (size_t first = 0; first < size; first += pieceSize) {
+        auto piece = pieceSize && size - first > pieceSize ? pieceSize : size - first;
+
+        geo::parseNmea (parser, text + first, piece, fixes, times);
+
+        if (!pieceSize) break;
+    }
+
+    return fixes->count;
+}
+
+// NMEA ingest: checksum, field mapping of GGA/RMC/GLL, the angle range and the sentences split across the buffers
+void checkNmea () {
+    static const char *SENTENCES =
+        "$GPGGA,123519,4807.038,N,01131.000,E,1,08,0.9,545.4,M,46.9,M,,*47\r\n"
+        "$GPRMC,123519,A,4807.038,N,01131.000,E,022.4,084.4,230394,003.1,W*6A\r\n"
+        "$GPGLL,4916.45,N,12311.12,W,225444,A,*1D\r\n";
+    struct {
+        double lat, lon, time;
+    } expected [] = {
+        { 48.0 + 7.038 / 60.0, 11.0 + 31.0 / 60.0, 12.0 * 3600.0 + 35.0 * 60.0 + 19.0 },
+        { 48.0 + 7.038 / 60.0, 11.0 + 31.0 / 60.0, 12.0 * 3600.0 + 35.0 * 60.0 + 19.0 },
+        { 49.0 + 16.45 / 60.0, - (123.0 + 11.12 / 60.0), 22.0 * 3600.0 + 54.0 * 60.0 + 44.0 },
+    };
+
+    double lat [8], lon [8], times [8];
+    geo::PosBatch fixes { lat, lon, 8, 0 };
+    geo::NmeaParser parser;
+
+    // Every split point of the text, so each sentence is once carried over at every position
+    for (size_t pieceSize = 0; pieceSize < 80; ++ pieceSize) {
+        char what [64];
+
+        snprintf (what, sizeof (what), "NMEA fixes, pieces of %zu", pieceSize);
+
+        fixes.count = 0;
+
+        if (!checkCondition (what, parseNmeaText (SENTENCES, pieceSize, & parser, & fixes, times) == 3 && parser.badChecksums == 0)) continue;
+
+        for (size_t i = 0; i < 3; ++ i) {
+            checkValue (what, "lat deg", lat [i] * geo::DEG_IN_RAD, expected [i].lat, 1.0e-9);
+            checkValue (what, "lon deg", lon [i] * geo::DEG_IN_RAD, expected [i].lon, 1.0e-9);
+            checkValue (what, "time s", times [i], expected [i].time, 1.0e-6);
+        }
+    }
+
+    struct {
+        const char *text;
+        size_t fixes, badChecksums;
+    } cases [] = {
+        { "$GPGGA,123519,4807.038,N,01131.000,E,1,08,0.9,545.4,M,46.9,M,,*48\r\n", 0, 1 },            // checksum
+        { "$GPGGA,123519,4807.038,N,01131.000,E,1,08,0.9,545.4,M,46.9,M,,*4G\r\n", 0, 1 },            // checksum digit
+        { "$GPGGA,123519,4807.038,N,01131.000,E,0,08,0.9,545.4,M,46.9,M,,*46\r\n", 0, 0 },            // no fix
+        { "$GPRMC,123519,V,4807.038,N,01131.000,E,022.4,084.4,230394,003.1,W*7D\r\n", 0, 0 },         // void fix
+        { "$GPGLL,9030.000,N,18030.000,E*6B\r\n", 0, 0 },                                            // past the pole
+        { "$GPGLL,4916.45,N,18030.000,W*48\r\n", 0, 0 },                                             // past 180
+        { "$GPGLL,4916.45,N,12360.00,W*74\r\n", 0, 0 },                                              // 60 minutes
+        { "$GPGLL,4916.45,E,12311.12,W*7A\r\n", 0, 0 },                                              // sides
+        { "$GPGLL,9000.000,S,18000.000,W*64\r\n", 1, 0 },                                            // exactly the pole
+    };
+
+    for (auto& test : cases) {
+        char what [128];
+
+        snprintf (what, sizeof (what), "NMEA %.*s", (int) (strlen (test.text) - 2), test.text);
+
+        fixes.count = 0;
+
+        checkCondition (what, parseNmeaText (test.text, 0, & parser, & fixes, 0) == test.fixes && parser.badChecksums == test.badChecksums);
+    }
+}
+
+// AIS position reports of class A and B, fed whole and in pieces through the carry buffer, and a bad checksum
+void checkAis () {
+    static const char *SENTENCES =
+        "!AIVDM,1,1,,B,177KQJ5000G?tO`K>RA1wUbN0TKH,0*5C\r\n"
+        "!AIVDM,1,1,,B,B52K>;h00Fc>jpUlNV@ikwpUoP06,0*4F\r\n"
+        "!AIVDM,1,1,,B,177KQJ5000G?tO`K>RA1wUbN0TKH,0*5D\r\n";
+    struct {
+        unsigned int mmsi;
+        double lat, lon;
+    } expected [] = {
+        { 477553000, 47.5828, -122.3458 },
+        { 338087471, 40.6845, -74.0721 },
+    };
+
+    unsigned int mmsi [4];
+    double lat [4], lon [4], sog [4], cog [4];
+    geo::AisReports reports { mmsi, { lat, lon, 4, 0 }, sog, cog };
+    geo::NmeaParser parser;
+    auto size = strlen (SENTENCES);
+
+    for (size_t pieceSize : { 0, 1, 7 }) {
+        char what [64];
+
+        snprintf (what, sizeof (what), "AIS reports, pieces of %zu", pieceSize);
+
+        geo::initNmeaParser (& parser);
+
+        reports.positions.count = 0;
+
+        for (size_t first = 0; first < size; first += pieceSize) {
+            auto piece = pieceSize && size - first > pieceSize ? pieceSize : size - first;
+
+            geo::decodeAis (& parser, SENTENCES + first, piece, & reports);
+
+            if (!pieceSize) break;
+        }
+
+        if (!checkCondition (what, reports.positions.count == 2 && parser.badChecksums == 1)) continue;
+
+        for (size_t i = 0; i < 2; ++ i) {
+            checkValue (what, "MMSI", mmsi [i], expected [i].mmsi, 0.0);
+            checkValue (what, "lat deg", lat [i] * geo::DEG_IN_RAD, expected [i].lat, 1.0e-4);
+            checkValue (what, "lon deg", lon [i] * geo::DEG_IN_RAD, expected [i].lon, 1.0e-4);
+        }
+
+        checkValue (what, "COG deg", cog [0] * geo::DEG_IN_RAD, 51.0, 1.0e-9);
+    }
+}
+
+// Format compilation, rounding carried into the upper units and the texts refused by the parser
+void checkGeoFormat () {
+    struct {
+        const char *format;
+        bool latitude, valid;
+    } formats [] = {
+        { "dd_mm.mmmS", true, true }, { "ddd_mm_ss.sS", false, true }, { "dd.ddddd", true, true }, { "ddmm.mmmm", true, true },
+        { "", true, false },                // empty
+        { "mm.mmm", true, false },          // no degrees
+        { "dd_ss.s", true, false },         // seconds without minutes
+        { "d_d.d", true, false },           // degrees split
+        { ".dd", true, false },             // point before the units
+        { "dd.d.d", true, false },          // second point
+        { "dd_mm.mmmSS", true, false },     // second side
+        { "dd.dddddddddd", true, false },   // ten fraction digits
+    };
+
+    for (auto& test : formats) {
+        geo::GeoFormat format;
+        char what [128];
+
+        snprintf (what, sizeof (what), "Format \"%s\" %s", test.format, test.valid ? "compiled" : "refused");
+
+        checkCondition (what, geo::compileGeoFormat (test.format, test.latitude, & format) == test.valid);
+    }
+
+    struct {
+        const char *format;
+        bool latitude;
+        double degrees;
+        const char *text;
+    } values [] = {
+        { "dd_mm.mmmS", true, 10.0 + 59.9996 / 60.0, "11 00.000N" },        // minutes carried into degrees
+        { "ddd_mm_ss.sS", false, -(12.0 + 59.0 / 60.0 + 59.96 / 3600.0), "013 00 00.0W" },
+        { "ddd_mm_ss.sS", false, -(12.0 + 30.0 / 60.0 + 15.5 / 3600.0), "012 30 15.5W" },
+        { "dd.dddd", true, -0.00001, "00.0000" },                            // no minus for zero
+        { "dd.dddd", true, -45.25, "-45.2500" },
+        { "dd_mm.mmmS", true, 90.0001, 0 },                                 // past the pole
+    };
+
+    for (auto& test : values) {
+        geo::GeoFormat format;
+        char what [128], text [32];
+
+        snprintf (what, sizeof (what), "Format \"%s\" of %.9f deg gives \"%s\"", test.format, test.degrees, test.text ? test.text : "nothing");
+
+        if (!geo::compileGeoFormat (test.format, test.latitude, & format)) continue;
+
+        auto length = geo::formatGeoValue (& format, test.degrees * geo::RAD_IN_DEG, text, sizeof (text));
+
+        checkCondition (what, test.text ? length == strlen (test.text) && strcmp (text, test.text) == 0 : length == 0);
+    }
+
+    struct {
+        const char *text;
+        bool latitude, valid;
+        double degrees;
+    } texts [] = {
+        { "12 30.000N", true, true, 12.5 },
+        { "012 30 15.5W", false, true, -(12.0 + 30.0 / 60.0 + 15.5 / 3600.0) },
+        { "-12.5", true, true, -12.5 },
+        { "12\xc2\xb0" "30'S", true, true, -12.5 },
+        { "90 00.000S", true, true, -90.0 },
+        { "", true, false, 0.0 },
+        { "N", true, false, 0.0 },                                          // side only
+        { "12 60.000N", true, false, 0.0 },                                 // 60 minutes
+        { "12 30 60S", true, false, 0.0 },                                  // 60 seconds
+        { "90 00.001N", true, false, 0.0 },                                 // past the pole
+        { "180 00 01E", false, false, 0.0 },                                // past 180
+        { "12.5 30N", true, false, 0.0 },                                   // fraction not in the last group
+        { "12 30N 15", true, false, 0.0 },                                  // group after the side
+        { "-12 30S", true, false, 0.0 },                                    // sign and side
+        { "12 30E", true, false, 0.0 },                                     // longitude side
+        { "1 2 3 4", true, false, 0.0 },                                    // four groups
+        { "12x30", true, false, 0.0 },
+    };
+
+    for (auto& test : texts) {
+        char what [128];
+        double value = 1.0;
+
+        snprintf (what, sizeof (what), "Parse \"%s\" %s", test.text, test.valid ? "accepted" : "refused");
+
+        if (checkCondition (what, geo::parseGeoValue (test.text, strlen (test.text), test.latitude, & value) == test.valid) && test.valid)
+            checkValue (what, "deg", value * geo::DEG_IN_RAD, test.degrees, 1.0e-12);
+    }
+
+    // Records of the batch are not zero terminated when they take the whole stride; failed ones give zero
+    const char records [] = "12 30.000N12 60.000N";
+    double parsed [2] = { 1.0, 1.0 };
+
+    checkCondition ("Parse batch with a bad record", !geo::parseGeoValues (records, 10, 2, true, parsed) && parsed [1] == 0.0);
+    checkValue ("Parse batch with a bad record", "deg", parsed [0] * geo::DEG_IN_RAD, 12.5, 1.0e-12);
+
+    // Fixed layout path on the records of formatGeoValues, in place (stride 16) and copied (stride of the text), against
+    // parseGeoValue where it reads the layout (not "ddmm"); records off the layout go to parseGeoValue
+    struct {
+        const char *format;
+        bool latitude, general;
+    } layouts [] = {
+        { "dd_mm.mmmS", true, true }, { "ddd_mm_ss.sS", false, true }, { "dd.dddd", true, true }, { "ddd.ddddd", false, true },
+        { "ddmm.mmmmS", true, false }, { "ddd_mm_ssS", false, true },
+    };
+
+    for (auto& test : layouts) {
+        const size_t COUNT = 64;
+        geo::GeoFormat format;
+        char records [COUNT * 16], what [128];
+        double values [COUNT], fixed [COUNT], general [COUNT];
+
+        if (!geo::compileGeoFormat (test.format, test.latitude, & format)) continue;
+
+        for (size_t i = 0; i < COUNT; ++ i)
+            values [i] = (test.latitude ? 90.0 : 180.0) * geo::RAD_IN_DEG * ((double) ((i * 37) % COUNT) / (COUNT - 1) * 2.0 - 1.0);
+
+        // Half the last unit of the format
+        auto tolerance = 0.5 / format.unitsPerDegree * geo::RAD_IN_DEG * (1.0 + 1.0e-9);
+        auto formatted = geo::formatGeoValues (& format, values, COUNT, records, 16);
+        auto parsed = geo::parseFormattedGeoValues (& format, records, 16, COUNT, fixed);
+        double maxError = 0.0, maxDiff = 0.0;
+
+        if (test.general) parsed &= geo::parseGeoValues (records, 16, COUNT, test.latitude, general);
+
+        for (size_t i = 0; i < COUNT; ++ i) {
+            maxError = fmax (maxError, fabs (fixed [i] - values [i]));
+
+            if (test.general) maxDiff = fmax (maxDiff, fabs (fixed [i] - general [i]));
+        }
+
+        snprintf (what, sizeof (what), "Fixed layout \"%s\" batch", test.format);
+
+        if (checkCondition (what, formatted && parsed)) {
+            checkValue (what, "rad", maxError, 0.0, tolerance);
+            checkValue (what, "rad from parseGeoValue", maxDiff, 0.0, 1.0e-15);
+        }
+
+        // The records of the text length only, the last one is the longest (the minus or three degree digits)
+        auto length = strlen (records + (COUNT - 1) * 16);
+        char packed [COUNT * 16];
+
+        for (size_t i = 0; i < COUNT; ++ i) memcpy (packed + i * length, records + i * 16, length);
+
+        snprintf (what, sizeof (what), "Fixed layout \"%s\" packed", test.format);
+
+        if (checkCondition (what, geo::parseFormattedGeoValues (& format, packed + (COUNT - 1) * length, length, 1, fixed)))
+            checkValue (what, "rad", fixed [0], values [COUNT - 1], tolerance);
+    }
+
+    struct {
+        const char *text;
+        bool valid;
+        double degrees;
+    } offLayout [] = {
+        { "12 30.000N", true, 12.5 },
+        { "12 30N", true, 12.5 },                                          // other layout
+        { "12 30.000n", true, 12.5 },                                      // other side letter
+        { "12 30.000N ", true, 12.5 },                                     // trailing space
+        { "12 60.000N", false, 0.0 },                                      // 60 minutes
+        { "91 00.000N", false, 0.0 },                                      // past the pole
+        { "1x 30.000N", false, 0.0 },
+        { "12 3;.000N", false, 0.0 },                                      // ';' is 0x3b, past the digits
+        { "12 30.000E", false, 0.0 },
+    };
+
+    geo::GeoFormat format;
+
+    geo::compileGeoFormat ("dd_mm.mmmS", true, & format);
+
+    for (auto& test : offLayout) {
+        char what [128], record [16] = { 0 };
+        double value = 1.0;
+
+        snprintf (what, sizeof (what), "Parse \"%s\" by the format %s", test.text, test.valid ? "accepted" : "refused");
+        strcpy (record, test.text);
+
+        if (checkCondition (what, geo::parseFormattedGeoValues (& format, record, sizeof (record), 1, & value) == test.valid))
+            checkValue (what, "deg", value * geo::DEG_IN_RAD, test.degrees, 1.0e-12);
+    }
+}
+
+// Replays the captured calls by the kernels linked; differences are in meters and degrees
+void replayCaptureFile (const char *path) {
+    static const char *CALL_NAMES [geo::GEO_CALL_COUNT] = { "RL position", "RL range/bearing", "GC position", "GC range/bearing" };
+    geo::CaptureFile capture;
+    geo::ReplayStats stats;
+
+    if (!geo::openCaptureFile (path, & capture)) die ("Unable to open capture");
+
+    if (!geo::replayCapture (& capture, & stats)) die ("Unable to replay capture");
+
+    printf ("%zu calls captured, %zu dropped\n", capture.recordCount, capture.dropped);
+
+    for (size_t call = 0; call < geo::GEO_CALL_COUNT; ++ call) {
+        if (!stats.calls [call]) continue;
+
+        auto diff = stats.maxDiff [call];
+
+        printf ("%-18s %10zu calls %10.1f ns/call, %zu results differ; max difference ", CALL_NAMES [call], stats.calls [call],
+                stats.seconds [call] / stats.calls [call] * 1.0e9, stats.mismatches [call]);
+
+        if (call == geo::GEO_CALL_RL_POS || call == geo::GEO_CALL_GC_POS)
+            printf ("%.4f m position, %.6f deg end bearing\n", hypot (diff [0], diff [1]) * geo::WGS84_EQUAT_RAD_M, diff [2] * geo::DEG_IN_RAD);
+        else
+            printf ("%.4f m range, %.6f deg bearing, %.6f deg end bearing\n", diff [0] * geo::METERS_IN_NM, diff [1] * geo::DEG_IN_RAD, diff [2] * geo::DEG_IN_RAD);
+    }
+
+    geo::closeCaptureFile (& capture);
+}
+
 int main (int argCount, char *args []) {
     geo::Operation operation;
     geo::Pos origin { 1.0e3, 1.0e3 }, dest { 1.0e3, 1.0e3 };
+    char *ownTrackPath = 0, *targetTrackPath = 0, *capturePath = 0;
+    char statsFormat = 0;
     double range = -1.0, bearing = -1.0;
     bool rhumbline = true;
 
@@ -62,6 +1869,9 @@ int main (int argCount, char *args []) {
     switch (operChar) {
         case geo::Operation::CALC_BRG_RNG:
         case geo::Operation::CALC_DEST_POINT:
+        case geo::Operation::RUN_BENCHMARK:
+        case geo::Operation::REPLAY_CAPTURE:
+        case geo::Operation::RUN_CHECKS:
             operation = (geo::Operation) operChar; break;
         default:
             die ("Invalid command");
@@ -102,11 +1912,32 @@ int main (int argCount, char *args []) {
                 if (bearing < 0.0f || bearing >= 360.0f) die ("Invalid bearing option");                
                 break;
 
+            case 'k':
+                if (arg [2] != ':' || !(targetTrackPath = strchr (arg + 3, ','))) die ("Invalid track option");
+
+                ownTrackPath = arg + 3;
+                *(targetTrackPath ++) = '\0';
+                break;
+
+            case 'c':
+                if (arg [2] != ':' || !arg [3]) die ("Invalid capture option");
+
+                capturePath = arg + 3;
+                break;
+
+            case 's':
+                if (arg [2] != ':' || ((statsFormat = tolower (arg [3])) != 't' && statsFormat != 'p')) die ("Invalid counters option");
+                break;
+
             default:
                 die ("Unknown option");
         }
     }
 
+    if (operation == geo::Operation::REPLAY_CAPTURE && !capturePath) die ("Capture file not specified");
+
+    if (capturePath && operation != geo::Operation::REPLAY_CAPTURE && !geo::startGeoCapture (capturePath, 1 << 16)) die ("Unable to start capture");
+
     switch (operation) {
         case geo::Operation::CALC_BRG_RNG: {
             if (origin.lat > 1.0e3 || origin.lon > 1.0e3) die ("Origin point not specified");
@@ -175,5 +2006,77 @@ int main (int argCount, char *args []) {
 
             break;
         }
+        case geo::Operation::RUN_BENCHMARK: {
+            geo::Pos _origin { geo::valToRad (45.0), 0.0 };
+            const size_t count = 1 << 20;
+
+            if (origin.lat < 1.0e3 && origin.lon < 1.0e3) _origin = { geo::valToRad (origin.lat), geo::valToRad (origin.lon) };
+
+            benchmarkKernels <float> ("float", _origin, count);
+            benchmarkKernels <double> ("double", _origin, count);
+            benchmarkKernels <long double> ("long double", _origin, count);
+            benchmarkFastMercator (_origin, count);
+            benchmarkLocalFrame (_origin, count);
+            benchmarkTargetUpdater (_origin, 1000);
+            benchmarkWarmSolver (_origin, ownTrackPath, targetTrackPath);
+            benchmarkGcLatency (_origin, 65536);
+            benchmarkLegCache (_origin, 1 << 18);
+            benchmarkAbi (_origin, count);
+            checkFloatKernels (_origin, count, true);
+
+            break;
+        }
+        case geo::Operation::REPLAY_CAPTURE: {
+            replayCaptureFile (capturePath);
+            break;
+        }
+        case geo::Operation::RUN_CHECKS: {
+            checkGcInverse ();
+            checkArcs ();
+            checkCorridor ();
+            checkContext ();
+            checkNmea ();
+            checkAis ();
+            checkGeoFormat ();
+            checkGridShift ();
+            checkTrackFile ();
+            checkRegionList ();
+            checkStatsExposition ();
+            checkUtm ();
+            checkDatumShifts ();
+            checkEcef ();
+            checkLocalFrame ();
+
+            for (auto lat : { 0.0, 45.0, 70.0, -60.0 }) {
+                geo::Pos _origin { geo::valToRad (lat), 0.3 };
+
+                checkFloatKernels (_origin, 1 << 16, false);
+                checkFastMercator (_origin, 1.0);
+                checkFastMercator (_origin, 0.9996);
+            }
+
+            break;
+        }
+    }
+
+    if (capturePath && operation != geo::Operation::REPLAY_CAPTURE) {
+        size_t written, dropped;
+
+        if (!geo::stopGeoCapture (& written, & dropped)) die ("Unable to write capture");
+
+        printf ("%zu calls captured, %zu dropped\n", written, dropped);
+    }
+
+    if (statsFormat) {
+        geo::GeoStats stats;
+        std::vector <char> text (1 << 16);
+
+        if (!geo::getGeoStats (& stats)) die ("Kernel counters are not built in");
+
+        if (geo::formatGeoStats (& stats, statsFormat == 'p', text.data (), text.size ())) printf ("\n%s", text.data ());
     }
+
+    if (checkCount) printf ("%d checks, %d failed\n", checkCount, failedChecks);
+
+    if (failedChecks) die (0, 2);
 }
\ No newline at end of file